@@ -12,10 +12,10 @@
 
 using namespace std;
 
-DdlJFP::DdlJFP(map<uint32_t, vector<string>> jobUseLinkId,
+DdlJFP::DdlJFP(map<uint32_t, vector<vector<uint32_t>>> jobFlowLinks,
                map<uint32_t, jobInfoType> jobJFPFlowIntensity,
                uint16_t solverPort)
-    : m_jobUseLinkId(jobUseLinkId),
+    : m_jobFlowLinks(jobFlowLinks),
       m_jobJFPFlowIntensity(jobJFPFlowIntensity),
       m_solverPort(solverPort)
 {
@@ -33,27 +33,37 @@ DdlJFP::DdlJFP(map<uint32_t, vector<string>> jobUseLinkId,
 void
 DdlJFP::initMatrixSize()
 {
-    m_jobNum = m_jobUseLinkId.size();
-    for (const auto& [jobId, links] : m_jobUseLinkId)
+    m_jobNum = m_jobFlowLinks.size();
+    // column -> 1 + the row of the last job counted on the link
+    vector<uint32_t> lastJobRow;
+    for (const auto& [jobId, flowLinks] : m_jobFlowLinks)
     {
+        uint32_t row = m_jobSet.size();
+        m_jobRow[jobId] = row;
         m_jobSet.push_back(jobId);
-        for (const auto& link : links)
+        for (const auto& links : flowLinks)
         {
-            if (find(m_linkSet.begin(), m_linkSet.end(), link) == m_linkSet.end())
+            for (uint32_t link : links)
             {
-                m_linkSet.push_back(link);
+                auto [it, added] = m_linkColumn.emplace(link, m_linkSet.size());
+                if (added)
+                {
+                    m_linkSet.push_back(link);
+                    m_linkJobNum.push_back(0);
+                    lastJobRow.push_back(0);
+                }
+                if (lastJobRow[it->second] != row + 1)
+                {
+                    lastJobRow[it->second] = row + 1;
+                    m_linkJobNum[it->second]++;
+                }
             }
         }
     }
     m_linkNum = m_linkSet.size();
     // init the flow matrix
-    for (const auto& jobId : m_jobSet)
-    {
-        for (const auto& linkName : m_linkSet)
-        {
-            m_allJobsFlowsInfoMatrix[jobId][linkName] = {{"comp_time", 0}, {"comm_size", 0}};
-        }
-    }
+    m_allJobsFlowsInfoMatrix.assign(m_jobNum, vector<array<uint32_t, 2>>(m_linkNum, {0, 0}));
+    m_priorityMatrix.assign(m_jobNum, vector<uint32_t>(m_linkNum, 0));
     cout << "Link Set: ";
     for (const auto& link : m_linkSet)
     {
@@ -65,42 +75,23 @@ DdlJFP::initMatrixSize()
 void
 DdlJFP::constructJobsFlowsInfoMatrix()
 {
+    // a flow loads every link of its path with its comp time and comm size
     for (const auto& jobId : m_jobSet)
     {
-        vector<string> jobUseLinks = m_jobUseLinkId[jobId];
-        jobInfoType jobFlows = m_jobJFPFlowIntensity[jobId];
-        uint32_t flowNum = jobFlows.size();
-        for(uint32_t flowId = 0; flowId < flowNum; flowId++)
+        const vector<vector<uint32_t>>& flowLinks = m_jobFlowLinks[jobId];
+        jobInfoType& jobFlows = m_jobJFPFlowIntensity[jobId];
+        vector<array<uint32_t, 2>>& row = m_allJobsFlowsInfoMatrix[m_jobRow[jobId]];
+        uint32_t flowNum = min<size_t>(jobFlows.size(), flowLinks.size());
+        for (uint32_t flowId = 0; flowId < flowNum; flowId++)
         {
-            string linkName = jobUseLinks[flowId];
-
-            m_allJobsFlowsInfoMatrix[jobId][linkName]["comp_time"] += jobFlows[flowId]["comp_time"];
-            m_allJobsFlowsInfoMatrix[jobId][linkName]["comm_size"] += jobFlows[flowId]["comm_size"];
+            for (uint32_t link : flowLinks[flowId])
+            {
+                array<uint32_t, 2>& flowInfo = row[m_linkColumn[link]];
+                flowInfo[0] += jobFlows[flowId]["comp_time"];
+                flowInfo[1] += jobFlows[flowId]["comm_size"];
+            }
         }
     }
-    // for (const auto& jobId : m_jobSet)
-    // {
-    //     vector<string> jobUseLinks = m_jobUseLinkId[jobId];
-    //     jobInfoType jobFlows = m_jobJFPFlowIntensity[jobId];
-    //     for (uint32_t linkId = 0; linkId < m_linkNum; linkId++)
-    //     {
-    //         string linkName = m_linkSet[linkId];
-    //         printColoredText(linkName,"blue");
-
-    //         // cout << "Job " << jobId << " uses link " << linkName << endl;
-    //         auto it = find(jobUseLinks.begin(), jobUseLinks.end(), linkName);
-
-    //         if (it == jobUseLinks.end())
-    //         { // the job does not use the link, write (0,0)
-    //             m_allJobsFlowsInfoMatrix[jobId][linkName] = {{"comp_time", 0}, {"comm_size", 0}};
-    //         }
-    //         else
-    //         { // the job is using the link, return the exact flow info
-    //             uint32_t flowId = distance(jobUseLinks.begin(), it);
-    //             m_allJobsFlowsInfoMatrix[jobId][linkName] = jobFlows[flowId];
-    //         }
-    //     }
-    // }
     dumpJobsFlowsInfoMatrix();
 }
 
@@ -126,31 +117,49 @@ DdlJFP::solveMatrix()
     if (connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
     {
         cout << "connect error" << endl;
+        close(sock);
         return -1;
     }
     send(sock, jsonStr.c_str(), jsonStr.size(), 0);
 
-    char buffer[1024] = {0};
-    int bytes_read = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    if (bytes_read < 0)
+    // the response grows with the links, read until it is a whole json
+    string response;
+    char buffer[4096];
+    int bytes_read;
+    while ((bytes_read = recv(sock, buffer, sizeof(buffer), 0)) > 0)
+    {
+        response.append(buffer, bytes_read);
+        if (json::accept(response))
+        {
+            break;
+        }
+    }
+    if (response.empty())
     {
         cout << "no solver response" << endl;
     }
-    buffer[bytes_read] = '\0';
-    
+
     try
     {
-        json j = json::parse(buffer);
+        json j = json::parse(response);
         for (auto& [jobId, jobJson] : j.items())
         {
-            uint32_t jobIdInt = stoi(jobId); // Convert jobId to uint32_t
+            auto row = m_jobRow.find(stoul(jobId));
+            if (row == m_jobRow.end())
+            {
+                continue;
+            }
             for (auto& [linkName, flowPrio] : jobJson.items())
             {
-                m_priorityMatrix[jobIdInt][linkName] = flowPrio;
+                auto column = m_linkColumn.find(stoul(linkName));
+                if (column != m_linkColumn.end())
+                {
+                    m_priorityMatrix[row->second][column->second] = flowPrio;
+                }
             }
         }
     }
-    catch (json::parse_error& e)
+    catch (json::exception& e)
     {
         cout << "parse error: " << e.what() << endl;
     }
@@ -163,23 +172,42 @@ DdlJFP::solveMatrix()
     return 1;
 }
 
+uint32_t
+DdlJFP::getFlowPriority(uint32_t jobId, uint32_t flowId)
+{
+    const vector<uint32_t>& links = m_jobFlowLinks[jobId].at(flowId);
+    if (links.empty())
+    {
+        return 0;
+    }
+    // the first of the most shared links of the flow decides, the others are less contended
+    uint32_t bestColumn = m_linkColumn[links[0]];
+    for (uint32_t link : links)
+    {
+        uint32_t column = m_linkColumn[link];
+        if (m_linkJobNum[column] > m_linkJobNum[bestColumn])
+        {
+            bestColumn = column;
+        }
+    }
+    return m_priorityMatrix[m_jobRow[jobId]][bestColumn];
+}
+
 json
 DdlJFP::convertMatrixToJson()
 {
+    // json keys are strings, the link index is written in decimal
     json j;
-    for (const auto& [jobId, jobFlows] : m_allJobsFlowsInfoMatrix)
+    for (uint32_t row = 0; row < m_jobNum; row++)
     {
         json jobJson;
-        for (const auto& [linkName, flowInfo] : jobFlows)
+        for (uint32_t column = 0; column < m_linkNum; column++)
         {
-            json flowJson;
-            for (const auto& [key, value] : flowInfo)
-            {
-                flowJson[key] = value;
-            }
-            jobJson[linkName] = flowJson;
+            const array<uint32_t, 2>& flowInfo = m_allJobsFlowsInfoMatrix[row][column];
+            jobJson[to_string(m_linkSet[column])] = {{"comp_time", flowInfo[0]},
+                                                     {"comm_size", flowInfo[1]}};
         }
-        j[to_string(jobId)] = jobJson;
+        j[to_string(m_jobSet[row])] = jobJson;
     }
     return j;
 }
@@ -187,78 +215,48 @@ DdlJFP::convertMatrixToJson()
 void
 DdlJFP::dumpJobsFlowsInfoMatrix()
 {
-    // 首先提取所有链路 ID（string 类型），用于作为表格的列索引
-    map<string, bool> allLinks; // 使用 map 来收集所有链路 ID，避免重复
-    for (const auto& job : m_allJobsFlowsInfoMatrix)
-    {
-        for (const auto& link : job.second)
-        {
-            allLinks[link.first] = true; // 记录链路 ID
-        }
-    }
-
-    // 打印表头：先打印空白区域以对齐行索引（任务 ID）
+    // 打印表头：先打印空白区域以对齐行索引（任务 ID），链路按首次使用的顺序
     cout << left << setw(12) << "Job ID";
-    for (const auto& link : allLinks)
+    for (uint32_t link : m_linkSet)
     {
-        cout << setw(20) << link.first; // 打印每个链路 ID 作为表头
+        cout << setw(20) << link; // 打印每个链路 ID 作为表头
     }
     cout << endl;
-    cout << string(12 + 20 * allLinks.size(), '-') << endl; // 分割线
+    cout << string(12 + 20 * m_linkNum, '-') << endl; // 分割线
 
     // 遍历任务 ID（行索引）并打印对应的 comp_time 和 comm_size
-    for (const auto& job : m_allJobsFlowsInfoMatrix)
+    for (uint32_t row = 0; row < m_jobNum; row++)
     {
-        uint32_t taskId = job.first; // 任务 ID
-        cout << left << setw(12) << taskId;
-
-        // 打印每个链路上的 comp_time 和 comm_size
-        for (const auto& link : allLinks)
+        cout << left << setw(12) << m_jobSet[row];
+        for (const array<uint32_t, 2>& flowInfo : m_allJobsFlowsInfoMatrix[row])
         {
-            const auto& taskMap = job.second;
-            if (taskMap.find(link.first) != taskMap.end())
-            {
-                const flowInfoType& flowInfo = taskMap.at(link.first);
-                uint32_t compTime = flowInfo.count("comp_time") ? flowInfo.at("comp_time") : 0;
-                uint32_t commSize = flowInfo.count("comm_size") ? flowInfo.at("comm_size") : 0;
-                cout << setw(20) << ("CT: " + to_string(compTime) + ", CS: " + to_string(commSize));
-            }
-            else
-            {
-                // 如果该链路 ID 不存在，则打印空白
-                cout << setw(20) << "-";
-            }
+            cout << setw(20)
+                 << ("CT: " + to_string(flowInfo[0]) + ", CS: " + to_string(flowInfo[1]));
         }
         cout << endl;
     }
 }
 
-void DdlJFP::dumpJobsFlowsPriorityMatrix(){
-    // 提取所有链路 ID 作为列索引
-    map<string, bool> allLinks;
-    for (const auto& job : m_priorityMatrix) {
-        for (const auto& link : job.second) {
-            allLinks[link.first] = true;
-        }
-    }
-
+void
+DdlJFP::dumpJobsFlowsPriorityMatrix()
+{
     // 打印表头（任务 ID 及所有链路 ID）
     cout << left << setw(12) << "Job ID";
-    for (const auto& link : allLinks) {
-        cout << setw(12) << link.first;
+    for (uint32_t link : m_linkSet)
+    {
+        cout << setw(12) << link;
     }
     cout << endl;
-    cout << string(12 + 12 * allLinks.size(), '-') << endl;  // 分割线
+    cout << string(12 + 12 * m_linkNum, '-') << endl; // 分割线
 
     // 遍历每个任务及其链路优先级
-    for (const auto& job : m_priorityMatrix) {
-        uint32_t taskId = job.first;  // 当前任务 ID
-        cout << left << setw(12) << taskId;
-
-        for (const auto& link : allLinks) {
-            uint32_t priority = job.second.at(link.first);  // 获取该任务对应链路的优先级
+    for (uint32_t row = 0; row < m_jobNum; row++)
+    {
+        cout << left << setw(12) << m_jobSet[row];
+        for (uint32_t priority : m_priorityMatrix[row])
+        {
             cout << setw(12) << priority;
         }
         cout << endl;
     }
-}
\ No newline at end of file
+}
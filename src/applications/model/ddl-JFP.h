@@ -2,6 +2,7 @@
 #define DDL_JFP_H
 #include <algorithm>
 #include <arpa/inet.h>
+#include <array>
 #include <climits>
 #include <iostream>
 #include <map>
@@ -12,6 +13,7 @@
 #include <set>
 #include <string>
 #include <sys/socket.h>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -24,7 +26,8 @@ using jobInfoType = map<uint32_t, flowInfoType>;
 class DdlJFP
 {
   public:
-    DdlJFP(map<uint32_t, vector<string>> jobUseLinkId,
+    // jobFlowLinks: jobId -> flowId -> the dense topo indices of the links the flow takes
+    DdlJFP(map<uint32_t, vector<vector<uint32_t>>> jobFlowLinks,
            map<uint32_t, jobInfoType> jobJFPFlowIntensity,
            uint16_t solverPort);
 
@@ -37,29 +40,33 @@ class DdlJFP
 
     json convertMatrixToJson();
 
-    map<uint32_t, map<string, uint32_t>> getPriorityMatrix()
-    {
-        return m_priorityMatrix;
-    }
+    // the priority of a flow of a job, the one on its link shared by the most jobs
+    uint32_t getFlowPriority(uint32_t jobId, uint32_t flowId);
 
   private:
-    map<uint32_t, vector<string>> m_jobUseLinkId;
+    map<uint32_t, vector<vector<uint32_t>>> m_jobFlowLinks;
     map<uint32_t, jobInfoType> m_jobJFPFlowIntensity;
 
-    // size is m_jobNum * m_linkNum
-    map<uint32_t, map<string, flowInfoType>> m_allJobsFlowsInfoMatrix;
-    // size is m_jobNum * m_linkNum
-    map<uint32_t, map<string, uint32_t>> m_allJobsFlowsPriorityMatrix;
+    // [job row][link column], the comp_time and comm_size summed over the flows on the link
+    vector<vector<array<uint32_t, 2>>> m_allJobsFlowsInfoMatrix;
+    // [job row][link column]
+    vector<vector<uint32_t>> m_priorityMatrix;
 
     vector<uint32_t> m_jobSet;
     uint32_t m_jobNum;
-    vector<string> m_linkSet;
+    // jobId -> row
+    map<uint32_t, uint32_t> m_jobRow;
+    // column -> link index, in the order the links are first used
+    vector<uint32_t> m_linkSet;
     uint32_t m_linkNum;
+    // link index -> column
+    unordered_map<uint32_t, uint32_t> m_linkColumn;
+    // column -> the jobs using the link
+    vector<uint32_t> m_linkJobNum;
 
     // the port to communicate with the python solver
     uint16_t m_solverPort;
     vector<uint32_t> m_tosList;
-    map<uint32_t, map<string, uint32_t>> m_priorityMatrix;
 };
 
-#endif // DDL_JFP_H
\ No newline at end of file
+#endif // DDL_JFP_H
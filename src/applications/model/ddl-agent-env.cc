@@ -0,0 +1,210 @@
+#include "ddl-agent-env.h"
+
+#include <chrono>
+#include <cstddef>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint32_t DDL_AGENT_MAGIC = 0x414c4444; // "DDLA"
+static const uint32_t DDL_AGENT_VERSION = 1;
+// the end of the run, past any real step
+static const uint64_t DDL_AGENT_END_SEQ = UINT64_MAX;
+
+static_assert(atomic<uint64_t>::is_always_lock_free, "the counters are shared across processes");
+static_assert(offsetof(DdlAgentHeader, stepSeq) == 128, "fixed header layout");
+static_assert(offsetof(DdlAgentHeader, actionSeq) == 192, "fixed header layout");
+static_assert(offsetof(DdlAgentHeader, decision) == 256, "fixed header layout");
+static_assert(offsetof(DdlAgentHeader, timeNs) == 280, "fixed header layout");
+
+// the arrays start on a cache line
+static uint64_t
+alignUp(uint64_t bytes)
+{
+    return (bytes + 63) / 64 * 64;
+}
+
+DdlAgentEnv::DdlAgentEnv(string name, bool owner, void* region, size_t bytes)
+    : m_name(name),
+      m_owner(owner),
+      m_header(static_cast<DdlAgentHeader*>(region)),
+      m_bytes(bytes),
+      m_stepSeq(0)
+{
+}
+
+DdlAgentEnv::~DdlAgentEnv()
+{
+    munmap(m_header, m_bytes);
+    if (m_owner)
+    {
+        shm_unlink(m_name.c_str());
+    }
+}
+
+unique_ptr<DdlAgentEnv>
+DdlAgentEnv::create(string name, uint32_t maxJobNum, uint32_t linkNum, uint32_t gpuNum)
+{
+    if (name.empty() || name[0] != '/')
+    {
+        name = "/" + name;
+    }
+    uint64_t offset = alignUp(sizeof(DdlAgentHeader));
+    uint64_t jobIdOffset = offset;
+    offset = alignUp(offset + sizeof(uint32_t) * maxJobNum);
+    uint64_t progressOffset = offset;
+    offset = alignUp(offset + sizeof(float) * maxJobNum);
+    uint64_t jobLinkOffset = offset;
+    offset = alignUp(offset + sizeof(float) * maxJobNum * linkNum);
+    uint64_t queueOffset = offset;
+    offset = alignUp(offset + sizeof(uint32_t) * linkNum);
+    uint64_t gpuFreeOffset = offset;
+    offset = alignUp(offset + gpuNum);
+    uint64_t tosOffset = offset;
+    offset = alignUp(offset + (uint64_t)maxJobNum * linkNum);
+    uint64_t placementOffset = offset;
+    offset = alignUp(offset + sizeof(uint32_t) * gpuNum);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        cerr << "Failed to create the shared memory " << name << endl;
+        return nullptr;
+    }
+    void* region = MAP_FAILED;
+    if (ftruncate(fd, offset) == 0)
+    {
+        region = mmap(nullptr, offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        cerr << "Failed to map the shared memory " << name << endl;
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    // ftruncate zeroes the region, the counters are constructed in place
+    DdlAgentHeader* header = static_cast<DdlAgentHeader*>(region);
+    new (&header->stepSeq) atomic<uint64_t>(0);
+    new (&header->actionSeq) atomic<uint64_t>(0);
+    header->version = DDL_AGENT_VERSION;
+    header->maxJobNum = maxJobNum;
+    header->linkNum = linkNum;
+    header->gpuNum = gpuNum;
+    header->regionBytes = offset;
+    header->jobIdOffset = jobIdOffset;
+    header->progressOffset = progressOffset;
+    header->jobLinkOffset = jobLinkOffset;
+    header->queueOffset = queueOffset;
+    header->gpuFreeOffset = gpuFreeOffset;
+    header->tosOffset = tosOffset;
+    header->placementOffset = placementOffset;
+    // the magic goes last, an agent polling the region sees a complete header
+    atomic_thread_fence(memory_order_release);
+    header->magic = DDL_AGENT_MAGIC;
+    return unique_ptr<DdlAgentEnv>(new DdlAgentEnv(name, true, region, offset));
+}
+
+unique_ptr<DdlAgentEnv>
+DdlAgentEnv::attach(string name)
+{
+    if (name.empty() || name[0] != '/')
+    {
+        name = "/" + name;
+    }
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    void* region = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(DdlAgentHeader))
+    {
+        region = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    DdlAgentHeader* header = static_cast<DdlAgentHeader*>(region);
+    if (header->magic != DDL_AGENT_MAGIC || header->version != DDL_AGENT_VERSION ||
+        header->regionBytes > (uint64_t)st.st_size)
+    {
+        munmap(region, st.st_size);
+        return nullptr;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    auto env = unique_ptr<DdlAgentEnv>(new DdlAgentEnv(name, false, region, st.st_size));
+    // a late agent answers the next step, not the ones before it attached
+    env->m_stepSeq = header->actionSeq.load(memory_order_acquire);
+    return env;
+}
+
+bool
+DdlAgentEnv::waitFor(atomic<uint64_t>& counter, uint64_t seq, double timeoutSeconds)
+{
+    // a local agent answers within microseconds, spinning keeps the handoff off the scheduler
+    for (uint32_t i = 0; i < 4096; i++)
+    {
+        if (counter.load(memory_order_acquire) >= seq)
+        {
+            return true;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    auto start = chrono::steady_clock::now();
+    while (counter.load(memory_order_acquire) < seq)
+    {
+        sched_yield();
+        if (timeoutSeconds > 0 &&
+            chrono::duration<double>(chrono::steady_clock::now() - start).count() >
+                timeoutSeconds)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+DdlAgentEnv::step(double timeoutSeconds)
+{
+    m_header->stepSeq.store(++m_stepSeq, memory_order_release);
+    return waitFor(m_header->actionSeq, m_stepSeq, timeoutSeconds);
+}
+
+void
+DdlAgentEnv::end()
+{
+    m_header->decision = DDL_AGENT_END;
+    m_header->stepSeq.store(DDL_AGENT_END_SEQ, memory_order_release);
+}
+
+bool
+DdlAgentEnv::waitStep()
+{
+    waitFor(m_header->stepSeq, m_stepSeq + 1, 0);
+    uint64_t seq = m_header->stepSeq.load(memory_order_acquire);
+    if (seq == DDL_AGENT_END_SEQ)
+    {
+        return false;
+    }
+    m_stepSeq = seq;
+    return true;
+}
+
+void
+DdlAgentEnv::commitAction()
+{
+    m_header->actionSeq.store(m_stepSeq, memory_order_release);
+}
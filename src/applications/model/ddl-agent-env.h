@@ -0,0 +1,172 @@
+#ifndef DDL_AGENT_ENV_H
+#define DDL_AGENT_ENV_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// the decision the simulator asks for at a step
+enum DdlAgentDecision : uint32_t
+{
+    DDL_AGENT_OBSERVE = 0, // no action is read
+    DDL_AGENT_PLACE = 1,   // the gpus of the arriving job
+    DDL_AGENT_TOS = 2,     // the tos matrix of the running jobs
+    DDL_AGENT_END = 3      // the simulation is over, no action is awaited
+};
+
+// what brought the simulator to the step
+enum DdlAgentEvent : uint32_t
+{
+    DDL_AGENT_ARRIVAL = 0,
+    DDL_AGENT_START = 1,
+    DDL_AGENT_FINISH = 2,
+    DDL_AGENT_TICK = 3
+};
+
+// the head of the shared region, the arrays follow at the given byte offsets
+// the field offsets are fixed, so an agent in another language can map the region:
+//   0 magic "DDLA", 4 version, 8 maxJobNum, 12 linkNum, 16 gpuNum, 20 reserved,
+//   24 regionBytes, 32.. the array offsets (uint64) in the declared order,
+//   128 stepSeq (uint64), 192 actionSeq (uint64),
+//   256 decision, 260 event, 264 jobId, 268 workerNum, 272 jobNum, 276 placementNum,
+//   280 timeNs (uint64)
+struct DdlAgentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t maxJobNum;
+    uint32_t linkNum;
+    uint32_t gpuNum;
+    uint32_t reserved;
+    uint64_t regionBytes;
+    // uint32[maxJobNum], the job of each row
+    uint64_t jobIdOffset;
+    // float[maxJobNum], the finished share of the iterations
+    uint64_t progressOffset;
+    // float[maxJobNum][linkNum], the comm ms of an iteration on each link of the fabric
+    uint64_t jobLinkOffset;
+    // uint32[linkNum], the queued bytes of each link direction
+    uint64_t queueOffset;
+    // uint8[gpuNum], 1 if the gpu is free
+    uint64_t gpuFreeOffset;
+    // action uint8[maxJobNum][linkNum], the tos of each job on each link
+    uint64_t tosOffset;
+    // action uint32[gpuNum], the gpus of the arriving job
+    uint64_t placementOffset;
+    uint64_t padding[5];
+
+    // the simulator publishes step n by storing n, the agent answers by storing n
+    alignas(64) atomic<uint64_t> stepSeq;
+    alignas(64) atomic<uint64_t> actionSeq;
+
+    alignas(64) uint32_t decision;
+    uint32_t event;
+    // the arriving or finished job
+    uint32_t jobId;
+    // the gpus the arriving job asks
+    uint32_t workerNum;
+    // the rows of the observation
+    uint32_t jobNum;
+    // action, the gpus written to the placement array, 0 keeps the job pending
+    uint32_t placementNum;
+    uint64_t timeNs;
+};
+
+// a step channel between the simulator and a local agent process over POSIX shared memory
+// the handoff is two sequence counters, each side spins on the other's counter,
+// then yields, no lock or syscall is on the fast path
+class DdlAgentEnv
+{
+  public:
+    ~DdlAgentEnv();
+
+    // the simulator side creates the region /dev/shm/<name> and removes it when destroyed,
+    // nullptr if it cannot be created
+    static unique_ptr<DdlAgentEnv> create(string name,
+                                          uint32_t maxJobNum,
+                                          uint32_t linkNum,
+                                          uint32_t gpuNum);
+    // the agent side maps an existing region, nullptr if it is missing or of another version
+    static unique_ptr<DdlAgentEnv> attach(string name);
+
+    // simulator: publish the step written to the region and wait for the action,
+    // false if no action came within timeoutSeconds, 0 waits forever
+    bool step(double timeoutSeconds = 0);
+    // simulator: publish the end, the agent's waitStep then returns false
+    void end();
+
+    // agent: wait for the next step, false once the simulation ended
+    bool waitStep();
+    // agent: hand the action written to the region back
+    void commitAction();
+
+    DdlAgentHeader* header()
+    {
+        return m_header;
+    }
+
+    uint32_t* jobIds()
+    {
+        return array<uint32_t>(m_header->jobIdOffset);
+    }
+
+    float* progress()
+    {
+        return array<float>(m_header->progressOffset);
+    }
+
+    // row-major, a row per job
+    float* jobLink()
+    {
+        return array<float>(m_header->jobLinkOffset);
+    }
+
+    uint32_t* queueBytes()
+    {
+        return array<uint32_t>(m_header->queueOffset);
+    }
+
+    uint8_t* gpuFree()
+    {
+        return array<uint8_t>(m_header->gpuFreeOffset);
+    }
+
+    // row-major, a row per job
+    uint8_t* tos()
+    {
+        return array<uint8_t>(m_header->tosOffset);
+    }
+
+    uint32_t* placement()
+    {
+        return array<uint32_t>(m_header->placementOffset);
+    }
+
+    uint64_t getStepNum()
+    {
+        return m_stepSeq;
+    }
+
+  private:
+    DdlAgentEnv(string name, bool owner, void* region, size_t bytes);
+
+    template <typename T>
+    T* array(uint64_t offset)
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(m_header) + offset);
+    }
+
+    // spin, then yield, until the counter reaches seq
+    static bool waitFor(atomic<uint64_t>& counter, uint64_t seq, double timeoutSeconds);
+
+    string m_name;
+    bool m_owner;
+    DdlAgentHeader* m_header;
+    size_t m_bytes;
+    // the last step published or handled on this side
+    uint64_t m_stepSeq;
+};
+
+#endif // DDL_AGENT_ENV_H
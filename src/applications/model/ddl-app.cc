@@ -33,18 +33,10 @@ namespace ns3
 NS_LOG_COMPONENT_DEFINE("DdlApplication");
 NS_OBJECT_ENSURE_REGISTERED(DdlApplication);
 
-Address
-getNodeIp(Ptr<Node> node)
-{
-    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-    Ipv4InterfaceAddress iaddr = ipv4->GetAddress(1, 0);
-    Ipv4Address ipAddr = iaddr.GetLocal();
-    return ipAddr;
-}
-
 DdlApplication::DdlApplication(uint32_t jobId, DdlAppManager* appManager)
     : m_jobId(jobId),
       m_iterCnt(0),
+      m_lastIterEndTime(0),
       m_appManager(appManager),
       m_state(JobState::UNARRIVED)
 {
@@ -108,78 +100,213 @@ void
 DdlApplication::generateFlow(vector<uint32_t> gpuIndex)
 {
     NS_LOG_FUNCTION(this);
-    spineLeafTopo* topo = m_appManager->getTopo();
-    NodeContainer gpuNodes = topo->getGpuNodes();
-    Ptr<Node> sender;
-    Ptr<Node> receiver;
     uint32_t resourceCnt = 0;
     m_jobStartTime = Simulator::Now().GetMilliSeconds();
+    m_lastIterEndTime = Simulator::Now().GetMicroSeconds();
 
     printColoredText("Job[" + to_string(m_jobId) + "] starts at " + to_string(m_jobStartTime) +
                          "ms",
                      "green");
+    // the gpu pair of each flow is decided by the placement
+    map<uint32_t, pair<uint32_t, uint32_t>> flowGpuPair;
     for (const auto& [flowId, value] : m_flowFeatures)
     {
+        flowGpuPair[flowId] = {gpuIndex[resourceCnt], gpuIndex[resourceCnt + 1]};
+        resourceCnt += 2;
+    }
+
+    // optional DAG rewrite, tiny zero-compute flows are sent together with their upstream flow
+    map<uint32_t, vector<uint32_t>> flowChains;
+    uint32_t maxFusedBytes = m_appManager->getSmallFlowFusionBytes();
+    if (maxFusedBytes > 0)
+    {
+        flowChains = fuseSmallFlowChains(m_flowFeatures, flowGpuPair, maxFusedBytes);
+    }
+    else
+    {
+        for (const auto& [flowId, value] : m_flowFeatures)
+        {
+            flowChains[flowId] = {flowId};
+        }
+    }
+
+    // the app slots exist before any gpu fills them, so the maps are not resized concurrently
+    for (const auto& [flowId, chain] : flowChains)
+    {
+        m_flowSendApp[flowId] = nullptr;
+        m_flowRecvApp[chain.back()] = nullptr;
+    }
+
+    for (const auto& [flowId, chain] : flowChains)
+    {
+        // the sender behaves as the head flow, the recv behaves as the tail flow
         auto flowFeature = m_flowFeatures[flowId];
+        uint32_t tailFlowId = chain.back();
 
         uint32_t compTime = get<uint32_t>(flowFeature["comp_time"]);
-        uint32_t commSize = get<uint32_t>(flowFeature["comm_size"]);
+        uint32_t commSize = 0;
+        for (auto memberId : chain)
+        {
+            commSize += get<uint32_t>(m_flowFeatures[memberId]["comm_size"]);
+        }
 
         printColoredText("Flow ID: " + to_string(flowId) + ", compTime: " + to_string(compTime) +
                              ", commSize: " + to_string(commSize),
                          "yellow");
-        uint32_t from = gpuIndex[resourceCnt];
-        uint32_t to = gpuIndex[resourceCnt + 1];
+        if (chain.size() > 1)
+        {
+            NS_LOG_INFO("Job[" << m_jobId << "] fuses flow " << flowId << " to flow "
+                               << tailFlowId << " (" << chain.size() << " flows)");
+        }
+        uint32_t from = flowGpuPair[flowId].first;
+        uint32_t to = flowGpuPair[tailFlowId].second;
+
+        m_flowSendGpu[flowId] = from;
+        m_flowRecvGpu[tailFlowId] = to;
+        m_flowChainHead[tailFlowId] = flowId;
+        m_appManager->registerFlowPort(to, m_port + flowId, m_jobId, flowId);
+
+        // the apps are created on their gpu, at once without partitions
+        DdlControlMessage message;
+        message.jobId = m_jobId;
+        message.srcGpu = from;
+        message.dstGpu = to;
+        message.value = commSize;
+        message.type = DdlControlType::INSTALL_SEND;
+        message.flowId = flowId;
+        message.peerFlowId = tailFlowId;
+        m_appManager->sendControl(from, message);
+        message.type = DdlControlType::INSTALL_RECV;
+        message.flowId = tailFlowId;
+        message.peerFlowId = flowId;
+        m_appManager->sendControl(to, message);
+    }
+    pushFlowTos();
+}
 
-        resourceCnt += 2;
-        vector<uint32_t> upstreamFlowIds = get<vector<uint32_t>>(flowFeature["upstream"]);
-        vector<uint32_t> downstreamFlowIds = get<vector<uint32_t>>(flowFeature["downstream"]);
-
-        bool first_flow = get<bool>(flowFeature["first_flow"]);
-        bool last_flow = get<bool>(flowFeature["last_flow"]);
-        uint32_t port = m_port + flowId;
-        sender = gpuNodes.Get(from);
-        receiver = gpuNodes.Get(to);
-        DdlFlowSendHelper flowSendHelper(getNodeIp(receiver), port);
-        flowSendHelper.SetAttribute("JobId", UintegerValue(m_jobId));
-        flowSendHelper.SetAttribute("NodeId", UintegerValue(from));
-        flowSendHelper.SetAttribute("FlowId", UintegerValue(flowId));
-        flowSendHelper.SetAttribute("CompTime", TimeValue(MilliSeconds(compTime)));
-        flowSendHelper.SetAttribute("CommSize", UintegerValue(commSize));
-        ApplicationContainer flowSenderApp = flowSendHelper.Install(sender);
-        Ptr<DdlFlowSendApplication> sendApp =
-            DynamicCast<DdlFlowSendApplication>(flowSenderApp.Get(0));
-        sendApp->setUpstreamFlowIds(upstreamFlowIds);
-        sendApp->setParentDdlApp(this); // 核心出装
-        // the first flows need not to wait other flows's finish
-        if (first_flow)
+void
+DdlApplication::installFlowSend(const DdlControlMessage& message)
+{
+    NS_LOG_FUNCTION(this);
+    spineLeafTopo* topo = m_appManager->getTopo();
+    uint32_t flowId = message.flowId;
+    const auto& flowFeature = m_flowFeatures.at(flowId);
+    uint32_t compTime = get<uint32_t>(flowFeature.at("comp_time"));
+    vector<uint32_t> upstreamFlowIds = get<vector<uint32_t>>(flowFeature.at("upstream"));
+    bool first_flow = get<bool>(flowFeature.at("first_flow"));
+    uint32_t port = m_port + flowId;
+
+    DdlFlowSendHelper flowSendHelper(topo->getGpuAddress(message.dstGpu), port);
+    flowSendHelper.SetAttribute("JobId", UintegerValue(m_jobId));
+    flowSendHelper.SetAttribute("NodeId", UintegerValue(message.srcGpu));
+    flowSendHelper.SetAttribute("FlowId", UintegerValue(flowId));
+    flowSendHelper.SetAttribute("CompTime", TimeValue(MilliSeconds(compTime)));
+    flowSendHelper.SetAttribute("CommSize", UintegerValue(message.value));
+    // a transfer inside the host leaves the fabric alone
+    DataRate intraHostRate = m_appManager->getIntraHostRate(message.srcGpu, message.dstGpu);
+    flowSendHelper.SetAttribute("IntraHostRate", DataRateValue(intraHostRate));
+    ApplicationContainer flowSenderApp = flowSendHelper.Install(topo->getGpuNode(message.srcGpu));
+    Ptr<DdlFlowSendApplication> sendApp =
+        DynamicCast<DdlFlowSendApplication>(flowSenderApp.Get(0));
+    sendApp->setUpstreamFlowIds(upstreamFlowIds);
+    sendApp->setParentDdlApp(this); // 核心出装
+    sendApp->setIntraHostRecvFlowId(message.peerFlowId);
+    // the first flows need not to wait other flows's finish
+    if (first_flow)
+    {
+        sendApp->setUpstreamFinishStatesAllTrue();
+    }
+    else
+    {
+        sendApp->setUpstreamFinishStatesAllFalse();
+    }
+    m_flowSendApp.at(flowId) = sendApp;
+
+    flowSenderApp.Start(MilliSeconds(0)); // it means it start at current time!!!
+    flowSenderApp.Stop(MilliSeconds(10000000));
+}
+
+void
+DdlApplication::installFlowRecv(const DdlControlMessage& message)
+{
+    NS_LOG_FUNCTION(this);
+    spineLeafTopo* topo = m_appManager->getTopo();
+    uint32_t tailFlowId = message.flowId;
+    bool last_flow = get<bool>(m_flowFeatures.at(tailFlowId).at("last_flow"));
+    // the port of the chain is the one of its head flow
+    uint32_t port = m_port + message.peerFlowId;
+
+    DdlFlowRecvHelper flowRecvHelper(port);
+    flowRecvHelper.SetAttribute("Protocol", TypeIdValue(UdpSocketFactory::GetTypeId()));
+    flowRecvHelper.SetAttribute("JobId", UintegerValue(m_jobId));
+    flowRecvHelper.SetAttribute("NodeId", UintegerValue(message.dstGpu));
+    flowRecvHelper.SetAttribute("FlowId", UintegerValue(tailFlowId));
+    flowRecvHelper.SetAttribute("ExpectedBytes", UintegerValue(message.value));
+    flowRecvHelper.SetAttribute("IterNum", UintegerValue(m_iterNum));
+    flowRecvHelper.SetAttribute("IsLastFlow", BooleanValue(last_flow));
+    DataRate intraHostRate = m_appManager->getIntraHostRate(message.srcGpu, message.dstGpu);
+    flowRecvHelper.SetAttribute("IntraHost", BooleanValue(intraHostRate.GetBitRate() > 0));
+    ApplicationContainer flowReceiverApp = flowRecvHelper.Install(topo->getGpuNode(message.dstGpu));
+    Ptr<DdlFlowRecvApplication> recvApp =
+        DynamicCast<DdlFlowRecvApplication>(flowReceiverApp.Get(0));
+    recvApp->setParentDdlApp(this); // 核心出装
+    m_flowRecvApp.at(tailFlowId) = recvApp;
+
+    flowReceiverApp.Start(MilliSeconds(0));
+    flowReceiverApp.Stop(MilliSeconds(10000000));
+}
+
+void
+DdlApplication::pushFlowTos()
+{
+    for (const auto& [flowId, gpu] : m_flowSendGpu)
+    {
+        DdlControlMessage message;
+        message.type = DdlControlType::SET_TOS;
+        message.jobId = m_jobId;
+        message.flowId = flowId;
+        message.value = flowId < m_flowTos.size() ? m_flowTos[flowId] : 0;
+        m_appManager->sendControl(gpu, message);
+    }
+}
+
+void
+DdlApplication::handleControl(const DdlControlMessage& message)
+{
+    switch (message.type)
+    {
+    case DdlControlType::FLOW_SEND:
+        recordFlowSend(message.flowId, message.time);
+        break;
+    case DdlControlType::FLOW_FINISH:
+        recordFlowFinish(message.flowId, message.value, message.time);
+        if (message.peerFlowId)
         {
-            sendApp->setUpstreamFinishStatesAllTrue();
+            stopAllFlows(message.flowId);
         }
         else
         {
-            sendApp->setUpstreamFinishStatesAllFalse();
+            notifyFinish(message.flowId);
         }
-        DdlFlowRecvHelper flowRecvHelper(port);
-        flowRecvHelper.SetAttribute("Protocol", TypeIdValue(UdpSocketFactory::GetTypeId()));
-        flowRecvHelper.SetAttribute("JobId", UintegerValue(m_jobId));
-        flowRecvHelper.SetAttribute("NodeId", UintegerValue(to));
-        flowRecvHelper.SetAttribute("FlowId", UintegerValue(flowId));
-        flowRecvHelper.SetAttribute("ExpectedBytes", UintegerValue(commSize));
-        flowRecvHelper.SetAttribute("IterNum", UintegerValue(m_iterNum));
-        flowRecvHelper.SetAttribute("IsLastFlow", BooleanValue(last_flow));
-        ApplicationContainer flowReceiverApp = flowRecvHelper.Install(receiver);
-        Ptr<DdlFlowRecvApplication> recvApp =
-            DynamicCast<DdlFlowRecvApplication>(flowReceiverApp.Get(0));
-        recvApp->setParentDdlApp(this); // 核心出装
-
-        m_flowSendApp[flowId] = sendApp;
-        m_flowRecvApp[flowId] = recvApp;
-
-        flowSenderApp.Start(MilliSeconds(0)); // it means it start at current time!!!
-        flowSenderApp.Stop(MilliSeconds(10000000));
-        flowReceiverApp.Start(MilliSeconds(0));
-        flowReceiverApp.Stop(MilliSeconds(10000000));
+        break;
+    case DdlControlType::UPSTREAM_FINISH:
+        m_flowSendApp.at(message.flowId)->setUpstreamFinishState(message.peerFlowId, true);
+        break;
+    case DdlControlType::STOP_SEND:
+        m_flowSendApp.at(message.flowId)->ddlStop();
+        break;
+    case DdlControlType::STOP_RECV:
+        m_flowRecvApp.at(message.flowId)->ddlStop();
+        break;
+    case DdlControlType::SET_TOS:
+        m_flowSendApp.at(message.flowId)->setFlowTos(message.value);
+        break;
+    case DdlControlType::INSTALL_SEND:
+        installFlowSend(message);
+        break;
+    case DdlControlType::INSTALL_RECV:
+        installFlowRecv(message);
+        break;
     }
 }
 
@@ -200,10 +327,20 @@ DdlApplication::stopAllFlows(uint32_t lastFlowId)
         // 1. change job state
         setState(JobState::FINISH);
         // 2. stop all the flows in the job
-        for (const auto& [flowId, value] : m_flowFeatures)
+        // fused flows have no apps of their own, so iter the apps instead of the flows
+        DdlControlMessage message;
+        message.jobId = m_jobId;
+        for (const auto& [flowId, gpu] : m_flowSendGpu)
+        {
+            message.type = DdlControlType::STOP_SEND;
+            message.flowId = flowId;
+            m_appManager->sendControl(gpu, message);
+        }
+        for (const auto& [flowId, gpu] : m_flowRecvGpu)
         {
-            m_flowSendApp[flowId]->ddlStop();
-            m_flowRecvApp[flowId]->ddlStop();
+            message.type = DdlControlType::STOP_RECV;
+            message.flowId = flowId;
+            m_appManager->sendControl(gpu, message);
         }
         // 3. release the node resource
         m_appManager->stopApp(m_jobId);
@@ -235,11 +372,27 @@ DdlApplication::getGpuUtilizationSum()
     return sum;
 }
 
+uint64_t
+DdlApplication::getIterCommBytes()
+{
+    uint64_t commBytes = 0;
+    for (auto& [flowId, flowFeature] : m_flowFeatures)
+    {
+        commBytes += get<uint32_t>(flowFeature["comm_size"]);
+    }
+    return commBytes;
+}
+
 void
 DdlApplication::startNextFlow(uint32_t downFlowId, uint32_t finishedFlowId)
 {
     NS_LOG_FUNCTION(this);
-    m_flowSendApp[downFlowId]->setUpstreamFinishState(finishedFlowId, true);
+    DdlControlMessage message;
+    message.type = DdlControlType::UPSTREAM_FINISH;
+    message.jobId = m_jobId;
+    message.flowId = downFlowId;
+    message.peerFlowId = finishedFlowId;
+    m_appManager->sendControl(m_flowSendGpu.at(downFlowId), message);
 }
 
 void
@@ -254,6 +407,77 @@ DdlApplication::notifyFinish(uint32_t finishedFlowId)
     }
 }
 
+void
+DdlApplication::flowSent(uint32_t flowId)
+{
+    DdlControlMessage message;
+    message.type = DdlControlType::FLOW_SEND;
+    message.jobId = m_jobId;
+    message.flowId = flowId;
+    m_appManager->sendControl(DDL_COORDINATOR, message);
+}
+
+void
+DdlApplication::flowReceived(uint32_t flowId, uint32_t iter, bool stopJob)
+{
+    DdlControlMessage message;
+    message.type = DdlControlType::FLOW_FINISH;
+    message.jobId = m_jobId;
+    message.flowId = flowId;
+    message.peerFlowId = stopJob ? 1 : 0;
+    message.value = iter;
+    m_appManager->sendControl(DDL_COORDINATOR, message);
+}
+
+void
+DdlApplication::flowReceivedIntraHost(uint32_t flowId, uint32_t bytes)
+{
+    // both gpus are in one leaf, so in the partition of the sender
+    m_flowRecvApp.at(flowId)->receiveIntraHost(bytes);
+}
+
+void
+DdlApplication::recordFlowSend(uint32_t flowId, uint64_t sendTime)
+{
+    m_flowSendTimes[flowId].push_back(sendTime);
+}
+
+void
+DdlApplication::recordFlowFinish(uint32_t flowId, uint32_t iter, uint64_t finishTime)
+{
+    // the time the message left the recv, not the time it reached the coordinator
+    uint64_t now = finishTime;
+    uint32_t headFlowId = m_flowChainHead[flowId];
+    deque<uint64_t>& sendTimes = m_flowSendTimes[headFlowId];
+    DdlIterRecord& record = m_pendingIters[iter];
+    // the transfers of a flow finish in the order they are sent
+    if (!sendTimes.empty())
+    {
+        record.flowTransferTime[headFlowId] = now - sendTimes.front();
+        sendTimes.pop_front();
+    }
+    record.flowTos[headFlowId] = headFlowId < m_flowTos.size() ? m_flowTos[headFlowId] : 0;
+
+    if (m_lastFlowStates.count(flowId) == 0)
+    {
+        return;
+    }
+    record.finishedLastFlowCnt++;
+    if (record.finishedLastFlowCnt < m_lastFlowStates.size())
+    {
+        return;
+    }
+    // all the last flows finished, the iteration ends
+    record.jobId = m_jobId;
+    record.iter = iter;
+    record.startTime = m_lastIterEndTime;
+    record.endTime = now;
+    m_lastIterEndTime = now;
+    m_iterTimeList.push_back(record.endTime - record.startTime);
+    m_appManager->writeIterRecord(record);
+    m_pendingIters.erase(iter);
+}
+
 void
 DdlApplication::printFlowFeatures()
 {
@@ -291,8 +515,7 @@ void
 DdlApplication::initFlowFeatures()
 {
     NS_LOG_FUNCTION(this);
-    std::string prefix =
-        "/home/yangxiaomao/ns-3-dev/src/applications/model/ddl-trace/job-generate/";
+    std::string prefix = m_appManager->getJobTraceDir();
     m_flowFeatures =
         loadFlowFeaturesFromCSV(prefix + "ddl-job-" + std::to_string(m_jobId) + ".csv");
     // printFlowFeatures();
@@ -318,6 +541,7 @@ DdlApplication::initFlowFeatures()
         m_JFPFlowFeatures[flowId]["comp_time"] = (uint32_t)compTime;
         m_JFPFlowFeatures[flowId]["comm_size"] =
             (uint32_t)(commSize / (m_appManager->getTopo()->getBandwidth() * 1000));
+        m_flowCompCommTimes.push_back({compTime, commSize / (clusterBandwidth * 1000)});
         // cout << "pppppppppppppppppppppppppppppppp" << endl;
         // cout << "comp_time: " << compTime << ", comm_size: " << commSize << endl;
     }
@@ -3,6 +3,7 @@
 #include "../helper/ddl-flow-recv-helper.h"
 #include "../helper/ddl-flow-send-helper.h"
 #include "ddl-apps-manager.h"
+#include "ddl-control.h"
 #include "ddl-flow-recv.h"
 #include "ddl-flow-send.h"
 #include "ddl-state.h"
@@ -23,6 +24,7 @@
 #include "ns3/uinteger.h"
 
 #include <cassert>
+#include <deque>
 #include <variant>
 #include <vector>
 
@@ -34,6 +36,20 @@ class DdlFlowSendApplication;
 class DdlFlowRecvApplication;
 class DdlAppManager;
 
+// the timeline of one iteration of a job, times in microseconds
+struct DdlIterRecord
+{
+    uint32_t jobId;
+    uint32_t iter;
+    uint64_t startTime;
+    uint64_t endTime;
+    // head flowId -> transfer time from the send to the recv of the last byte
+    map<uint32_t, uint64_t> flowTransferTime;
+    // the tos of each flow when its transfer finished
+    map<uint32_t, uint32_t> flowTos;
+    uint32_t finishedLastFlowCnt = 0;
+};
+
 class DdlApplication : public Application
 {
   public:
@@ -53,6 +69,16 @@ class DdlApplication : public Application
     void checkAndStartApplication();
 
     void notifyFinish(uint32_t finishedFlowId);
+    // called by the flow apps on their gpu, forwarded to the coordinator
+    void flowSent(uint32_t flowId);
+    void flowReceived(uint32_t flowId, uint32_t iter, bool stopJob);
+    // an intra-host transfer reaches the recv of its tail flow, on the gpu of both apps
+    void flowReceivedIntraHost(uint32_t flowId, uint32_t bytes);
+    // the control messages of this job, on the coordinator or on a gpu
+    void handleControl(const DdlControlMessage& message);
+    // build the per-iteration timeline, times in us
+    void recordFlowSend(uint32_t flowId, uint64_t sendTime);
+    void recordFlowFinish(uint32_t flowId, uint32_t iter, uint64_t finishTime);
     void startNextFlow(uint32_t downFlowId, uint32_t finishedFlowId);
     void stopAllFlows(uint32_t lastFlowId);
     void StartApplication() override;
@@ -84,6 +110,25 @@ class DdlApplication : public Application
         return m_flowNum;
     }
 
+    // the duration in us of every finished iteration
+    vector<uint32_t> getIterTimeList()
+    {
+        return m_iterTimeList;
+    }
+
+    uint32_t getFinishedIterNum()
+    {
+        return m_iterTimeList.size();
+    }
+
+    uint32_t getIterNum()
+    {
+        return m_iterNum;
+    }
+
+    // the bytes sent by all the flows in one iteration
+    uint64_t getIterCommBytes();
+
     float getCruxGpuIntensity()
     {
         return m_cruxGpuIntensity;
@@ -98,6 +143,7 @@ class DdlApplication : public Application
             exit(0);
         }
         m_flowTos = flowTos;
+        pushFlowTos();
     }
 
     vector<uint32_t> getFlowTos()
@@ -114,10 +160,21 @@ class DdlApplication : public Application
     {
         return m_JFPFlowFeatures;
     }
+
+    // flowId -> (comp time, comm time on a spine-leaf link) in ms, not rounded as for JFP
+    const vector<pair<float, float>>& getFlowCompCommTimes()
+    {
+        return m_flowCompCommTimes;
+    }
     
 
   private:
     void StopApplication() override;
+    // the flow apps, created on their gpu
+    void installFlowSend(const DdlControlMessage& message);
+    void installFlowRecv(const DdlControlMessage& message);
+    // the senders read their tos at every send
+    void pushFlowTos();
 
     uint32_t m_jobId;
     uint32_t m_flowNum;
@@ -129,7 +186,14 @@ class DdlApplication : public Application
     uint32_t m_iterCnt;
     uint32_t m_iterNum;
     vector<uint32_t> m_iterTimeList;
-    
+    // the iterations whose last flows have not all finished
+    map<uint32_t, DdlIterRecord> m_pendingIters;
+    uint64_t m_lastIterEndTime;
+    // head flowId -> send times of its transfers in flight
+    map<uint32_t, deque<uint64_t>> m_flowSendTimes;
+    // tail flowId -> head flowId of a fused chain, a flow is its own head without fusion
+    map<uint32_t, uint32_t> m_flowChainHead;
+
     float m_arriveTimeMilliSeconds;
     uint32_t m_jobStartTime;
 
@@ -144,6 +208,9 @@ class DdlApplication : public Application
     // std::map<int, ApplicationContainer> m_flowRecvApp;
     std::map<uint32_t, Ptr<DdlFlowSendApplication>> m_flowSendApp;
     std::map<uint32_t, Ptr<DdlFlowRecvApplication>> m_flowRecvApp;
+    // the gpu of each flow app, the coordinator reaches the apps through it
+    std::map<uint32_t, uint32_t> m_flowSendGpu;
+    std::map<uint32_t, uint32_t> m_flowRecvGpu;
 
     DdlAppManager* m_appManager;
     JobState m_state;
@@ -152,6 +219,7 @@ class DdlApplication : public Application
 
     float m_cruxGpuIntensity;
     map<uint32_t, map<string, uint32_t>> m_JFPFlowFeatures;
+    vector<pair<float, float>> m_flowCompCommTimes;
     uint32_t m_oracleRunningTime;
 };
 
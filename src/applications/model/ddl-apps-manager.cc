@@ -23,8 +23,11 @@
 #include "ns3/tcp-socket-base.h"
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/traffic-control-layer.h"
 #include "ns3/uinteger.h"
 
+#include <set>
+#include <sys/wait.h>
 #include <variant>
 #include <vector>
 
@@ -42,17 +45,53 @@ DdlAppManager::DdlAppManager(spineLeafTopo* topo,
     : m_placeStrategy(placeStrategy),
       m_tosStrategy(tosStrategy),
       m_topo(topo),
-      m_solverPort(solverPort)
-
+      m_solverPort(solverPort),
+      m_smallFlowFusionBytes(0),
+      m_intraHost(false),
+      m_jobTraceDir(""),
+      m_solverSeconds(0),
+      m_controlDelay(MicroSeconds(1)),
+      m_branchPipe(-1),
+      m_placementCandidates(256),
+      m_placementRng(1),
+      m_placementSeconds(0),
+      m_scoredCandidates(0),
+      m_backfilling("none"),
+      m_backfilledJobs(0),
+      m_agentTimeout(0),
+      m_agentEvent(DDL_AGENT_START),
+      m_agentSeconds(0)
 {
     NS_LOG_FUNCTION(this);
     initGpuStates();
-    startPythonSolver(cruxPlus);
+    // the topo splits the fabric by leaf, the jobs then stay on the coordinator
+    string simulatorType = Simulator::GetImplementation()->GetInstanceTypeId().GetName();
+    m_distributed = m_topo->isPartitioned();
+    m_remoteRanks = simulatorType == "ns3::DistributedSimulatorImpl" ||
+                    simulatorType == "ns3::NullMessageSimulatorImpl";
+    if (m_remoteRanks)
+    {
+        installControlSockets();
+    }
+    // only JFP and crux+ are solved by the python solver
+    if (m_tosStrategy == "JFP" || m_tosStrategy == "crux+")
+    {
+        startPythonSolver(cruxPlus);
+    }
 }
 
 DdlAppManager::~DdlAppManager()
 {
     NS_LOG_FUNCTION(this);
+    if (m_iterTimelineFile.is_open())
+    {
+        m_iterTimelineFile.close();
+    }
+    // an agent still waiting is let go before the region is removed
+    if (m_agentEnv)
+    {
+        m_agentEnv->end();
+    }
 }
 
 // this is yinyong's code
@@ -194,6 +233,132 @@ bool DdlAppManager::jobIsFirstArrived(DdlApplication* job)
     }
 }
 
+void
+DdlAppManager::setBackfilling(string backfilling)
+{
+    if (backfilling != "none" && backfilling != "easy" && backfilling != "conservative")
+    {
+        NS_FATAL_ERROR("Not supported backfilling: " << backfilling);
+    }
+    m_backfilling = backfilling;
+}
+
+double
+DdlAppManager::predictFinishTime(uint32_t jobId)
+{
+    DdlApplication* job = m_allApps[jobId];
+    double now = Simulator::Now().GetMilliSeconds();
+    vector<uint32_t> iterTimeList = job->getIterTimeList();
+    if (!iterTimeList.empty())
+    {
+        // the iterations so far carry the contention the job meets, times in us
+        double iterTime = 0;
+        for (auto time : iterTimeList)
+        {
+            iterTime += time;
+        }
+        iterTime /= iterTimeList.size() * 1000.0;
+        uint32_t iterLeft = job->getIterNum() > iterTimeList.size()
+                                ? job->getIterNum() - iterTimeList.size()
+                                : 0;
+        return now + iterLeft * iterTime;
+    }
+    // a job behind its oracle time is expected to finish at once
+    uint32_t startTime = get<uint32_t>(m_jobStatistics[jobId]["startTime"]);
+    return max(now, (double)startTime + job->getOracleRunningTime());
+}
+
+bool
+DdlAppManager::jobMayStart(DdlApplication* job)
+{
+    if (jobIsFirstArrived(job))
+    {
+        return true;
+    }
+    if (m_backfilling == "none")
+    {
+        return false;
+    }
+    // the pending jobs before this one, in the FIFO order
+    vector<pair<float, uint32_t>> earlierJobs;
+    for (auto& [jobId, pendingJob] : m_pendingApps)
+    {
+        float arriveTime = pendingJob->getArriveTimeMilliSeconds();
+        if (jobId != job->getJobId() &&
+            make_pair(arriveTime, jobId) <
+                make_pair(job->getArriveTimeMilliSeconds(), job->getJobId()))
+        {
+            earlierJobs.push_back({arriveTime, jobId});
+        }
+    }
+    sort(earlierJobs.begin(), earlierJobs.end());
+    if (m_backfilling == "easy")
+    {
+        earlierJobs.resize(1);
+    }
+
+    // the free gpus over time, time in ms -> change of the free gpu count
+    double now = Simulator::Now().GetMilliSeconds();
+    int32_t freeNow = getFreeGpuIndex().size();
+    multimap<double, int32_t> freeChanges;
+    for (auto& [jobId, runningJob] : m_runningApps)
+    {
+        freeChanges.insert({predictFinishTime(jobId), runningJob->getWorkerNum()});
+    }
+    // whether workerNum gpus stay free from start to end
+    auto fits = [&](double start, double end, int32_t workerNum) {
+        int32_t free = freeNow;
+        for (auto it = freeChanges.begin(); it != freeChanges.end() && it->first < end; it++)
+        {
+            if (it->first <= start)
+            {
+                free += it->second;
+            }
+            else if (free < workerNum)
+            {
+                return false;
+            }
+            else
+            {
+                free += it->second;
+            }
+        }
+        return free >= workerNum;
+    };
+    // each earlier job takes the first time its gpus stay free for its whole run
+    for (const auto& [arriveTime, jobId] : earlierJobs)
+    {
+        DdlApplication* earlierJob = m_pendingApps[jobId];
+        int32_t workerNum = earlierJob->getWorkerNum();
+        double runningTime = earlierJob->getOracleRunningTime();
+        double start = now;
+        if (!fits(start, start + runningTime, workerNum))
+        {
+            // a job larger than the cluster waits for all the others
+            start = freeChanges.empty() ? now : freeChanges.rbegin()->first;
+            for (const auto& [time, change] : freeChanges)
+            {
+                if (time > now && fits(time, time + runningTime, workerNum))
+                {
+                    start = time;
+                    break;
+                }
+            }
+        }
+        freeChanges.insert({start, -workerNum});
+        freeChanges.insert({start + runningTime, workerNum});
+    }
+    // the job may start if it delays none of the reservations
+    if (!fits(now, now + job->getOracleRunningTime(), job->getWorkerNum()))
+    {
+        return false;
+    }
+    m_backfilledJobs++;
+    NS_LOG_INFO("Job[" << job->getJobId() << "] backfills ahead of " << earlierJobs.size()
+                       << " reserved jobs");
+    return true;
+}
+
 vector<uint32_t>
 DdlAppManager::consolidatePlacement(DdlApplication* job)
 {
@@ -246,7 +411,7 @@ DdlAppManager::loadBalancePlacement(DdlApplication* job)
     vector<uint32_t> freeGpuIndex = getFreeGpuIndex();
 
     // no matter what placer, not enough gpu leads to failure
-    if (freeGpuIndex.size() < workerNum || !jobIsFirstArrived(job))
+    if (freeGpuIndex.size() < workerNum || !jobMayStart(job))
     {
         return {};
     }
@@ -283,10 +448,177 @@ DdlAppManager::loadBalancePlacement(DdlApplication* job)
     return gpuIndex;
 }
 
+vector<uint32_t>
+DdlAppManager::agentPlacement(DdlApplication* job)
+{
+    NS_LOG_FUNCTION(this);
+    uint32_t workerNum = job->getWorkerNum();
+    // the agent is not asked while the job cannot start anyway
+    if (getFreeGpuIndex().size() < workerNum)
+    {
+        return {};
+    }
+    agentStep(DDL_AGENT_PLACE, DDL_AGENT_ARRIVAL, job);
+    uint32_t placementNum = m_agentEnv->header()->placementNum;
+    if (placementNum == 0)
+    {
+        return {};
+    }
+    const uint32_t* placement = m_agentEnv->placement();
+    vector<uint32_t> workers(placement, placement + min<size_t>(placementNum, m_gpuStates.size()));
+    set<uint32_t> distinctWorkers(workers.begin(), workers.end());
+    bool valid = workers.size() == workerNum && distinctWorkers.size() == workerNum;
+    for (uint32_t gpu : workers)
+    {
+        valid = valid && gpu < m_gpuStates.size() && m_gpuStates[gpu] == GpuState::FREE;
+    }
+    if (!valid)
+    {
+        NS_LOG_INFO("Job[" << job->getJobId() << "] rejects the agent placement of "
+                           << placementNum << " gpus, it stays pending");
+        return {};
+    }
+    return workerNum == 1 ? vector<uint32_t>{workers[0], workers[0]}
+                          : duplicateMiddleElements(workers);
+}
+
+vector<uint32_t>
+DdlAppManager::getSolverLinks(uint32_t srcGpu, uint32_t dstGpu)
+{
+    vector<uint32_t> links;
+    for (uint32_t link : m_topo->getPathLinks(srcGpu, dstGpu))
+    {
+        DdlLinkKind kind = m_topo->getLinkKind(link);
+        if (kind != DdlLinkKind::GPU_TO_LEAF && kind != DdlLinkKind::LEAF_TO_GPU)
+        {
+            links.push_back(link);
+        }
+    }
+    if (links.empty())
+    {
+        links.push_back(m_topo->getLinkIndex(m_topo->getGpuUplink(srcGpu)));
+    }
+    return links;
+}
+
+vector<pair<uint32_t, float>>
+DdlAppManager::getPlacementLinkComm(DdlApplication* job, const vector<uint32_t>& gpuIndex)
+{
+    const auto& flowTimes = job->getFlowCompCommTimes();
+    vector<pair<uint32_t, float>> linkComm;
+    for (uint32_t i = 0; i + 1 < gpuIndex.size() && i / 2 < flowTimes.size(); i += 2)
+    {
+        for (uint32_t link : getSolverLinks(gpuIndex[i], gpuIndex[i + 1]))
+        {
+            linkComm.push_back({link, flowTimes[i / 2].second});
+        }
+    }
+    return linkComm;
+}
+
+vector<uint32_t>
+DdlAppManager::scorePlacement(DdlApplication* job)
+{
+    NS_LOG_FUNCTION(this);
+    // the lb placement is the first candidate, it also checks the free gpus and the FIFO order
+    vector<uint32_t> lbGpuIndex = loadBalancePlacement(job);
+    if (lbGpuIndex.empty())
+    {
+        return {};
+    }
+    auto scoreStart = chrono::steady_clock::now();
+    uint32_t workerNum = job->getWorkerNum();
+    vector<uint32_t> freeGpuIndex = getFreeGpuIndex();
+    uint32_t gpuNumPerLeaf = m_topo->getGpuNumPerLeaf();
+    uint32_t leafNum = m_topo->getLeafNum();
+    auto toGpuIndex = [](vector<uint32_t> workers) {
+        return workers.size() == 1 ? vector<uint32_t>{workers[0], workers[0]}
+                                   : duplicateMiddleElements(workers);
+    };
+
+    vector<vector<uint32_t>> candidates = {lbGpuIndex};
+    candidates.push_back(
+        toGpuIndex(vector<uint32_t>(freeGpuIndex.begin(), freeGpuIndex.begin() + workerNum)));
+    // packed from each leaf on, the flows stay inside the leafs as much as they can
+    for (uint32_t startLeaf = 1; startLeaf < leafNum && candidates.size() < m_placementCandidates;
+         startLeaf++)
+    {
+        vector<uint32_t> workers;
+        for (uint32_t i = 0; i < freeGpuIndex.size() && workers.size() < workerNum; i++)
+        {
+            uint32_t gpu = freeGpuIndex[i];
+            if (gpu / gpuNumPerLeaf >= startLeaf)
+            {
+                workers.push_back(gpu);
+            }
+        }
+        for (uint32_t i = 0; i < freeGpuIndex.size() && workers.size() < workerNum; i++)
+        {
+            if (freeGpuIndex[i] / gpuNumPerLeaf < startLeaf)
+            {
+                workers.push_back(freeGpuIndex[i]);
+            }
+        }
+        candidates.push_back(toGpuIndex(workers));
+    }
+    vector<uint32_t> shuffled = freeGpuIndex;
+    while (candidates.size() < m_placementCandidates && workerNum > 1)
+    {
+        shuffle(shuffled.begin(), shuffled.end(), m_placementRng);
+        candidates.push_back(
+            toGpuIndex(vector<uint32_t>(shuffled.begin(), shuffled.begin() + workerNum)));
+    }
+
+    // a flow loads every switch link of its path, the iteration counts its comm once
+    auto iterTime = [](DdlApplication* app) {
+        float time = 0;
+        for (const auto& [flowCompTime, flowCommTime] : app->getFlowCompCommTimes())
+        {
+            time += flowCompTime + flowCommTime;
+        }
+        return time;
+    };
+    DdlPlacementScorer scorer(m_topo->getLinkNum());
+    for (auto& [jobId, runningJob] : m_runningApps)
+    {
+        scorer.addJob(iterTime(runningJob), getPlacementLinkComm(runningJob, m_jobGPU[jobId]));
+    }
+    scorer.prepare();
+    float jobIterTime = iterTime(job);
+    // the earlier candidate wins a tie, so lb is kept unless another one is better
+    uint32_t bestId = 0;
+    double bestScore = 0;
+    for (uint32_t i = 0; i < candidates.size(); i++)
+    {
+        double score = scorer.score(jobIterTime, getPlacementLinkComm(job, candidates[i]));
+        if (i == 0 || score < bestScore)
+        {
+            bestId = i;
+            bestScore = score;
+        }
+    }
+    m_placementSeconds +=
+        chrono::duration<double>(chrono::steady_clock::now() - scoreStart).count();
+    m_scoredCandidates += candidates.size();
+    NS_LOG_INFO("Job[" << job->getJobId() << "] takes candidate " << bestId << " of "
+                       << candidates.size() << ", mean slowdown " << bestScore);
+    return candidates[bestId];
+}
+
 void
 DdlAppManager::adaptJobsFlowTos()
 {
     NS_LOG_FUNCTION(this);
+    // the branches fork before the decision, so that each one takes it with its strategy
+    if (!m_branchStrategies.empty() && Simulator::Now() >= m_branchTime)
+    {
+        forkTosBranches();
+        if (hasTosBranches())
+        {
+            return;
+        }
+    }
+    auto solveStart = chrono::steady_clock::now();
     if (m_tosStrategy == "crux")
     {
         adaptJobsFlowTosCrux();
@@ -299,11 +631,17 @@ DdlAppManager::adaptJobsFlowTos()
     {
         adaptJobsFlowTosJFP();
     }
+    else if (m_tosStrategy == "agent")
+    {
+        adaptJobsFlowTosAgent();
+    }
     else
     {
         NS_LOG_INFO("Not supported tos strategy: " << m_tosStrategy);
         exit(0);
     }
+    m_solverSeconds +=
+        chrono::duration<double>(chrono::steady_clock::now() - solveStart).count();
 }
 
 void
@@ -327,36 +665,29 @@ DdlAppManager::adaptJobsFlowTosCrux()
     NS_LOG_FUNCTION(this);
     // we should adapt the flow tos to suit the new running jobs set
     // we should first get the all running jobs set
-    // 1. get the map from leaf to spine
-    map<uint32_t, uint32_t> leafSpineMap = m_topo->getLeafSpineMap();
-    // 2. get the all running jobs's using gpuIndex, that is m_jobGPU,
+    // 1. get the all running jobs's using gpuIndex, that is m_jobGPU,
     // the job itself don't save the gpuIndex, it is saved in the manager
-    // 3. get the link id from the leafSpineMap and the placement(gpuIndex)
+    // 2. get the link id from the topo's links of the placement(gpuIndex)
     //  and get the job intensity
-    map<uint32_t, vector<string>> jobUseLinkId;
+    map<uint32_t, vector<uint32_t>> jobUseLinkId;
     map<uint32_t, float> jobIntensity;
 
     for (auto& [jobId, job] : m_runningApps)
     {
         jobIntensity[jobId] = job->getCruxGpuIntensity();
         vector<uint32_t> useGpuIndex = m_jobGPU[jobId];
-        vector<string> useLinkId;
+        vector<uint32_t> useLinkId;
         for (uint32_t i = 0; i < useGpuIndex.size(); i += 2) // attention here
         {
-            uint32_t senderGpuId = useGpuIndex[i];
-            uint32_t receiverGpuId = useGpuIndex[i + 1];
-            uint32_t gpuNumPerLeaf = m_topo->getGpuNumPerLeaf();
-            uint32_t senderLeafId = senderGpuId / gpuNumPerLeaf;
-            uint32_t senderSpineId = leafSpineMap[senderLeafId];
-            if (senderGpuId / gpuNumPerLeaf == receiverGpuId / gpuNumPerLeaf)
+            // the gpu link of a flow inside a leaf is not shared with the other jobs
+            for (uint32_t link : getSolverLinks(useGpuIndex[i], useGpuIndex[i + 1]))
             {
-                continue;
+                useLinkId.push_back(link);
             }
-            useLinkId.push_back("link" + to_string(senderLeafId) + to_string(senderSpineId));
         }
         jobUseLinkId[jobId] = useLinkId;
     }
-    // 4. constrcut the DAG of crux through jobUseLinkId and jobIntensity
+    // 3. constrcut the DAG of crux through jobUseLinkId and jobIntensity
     //    and get the output cut, each group have the same tos
     vector<uint32_t> prioList = {0,1,2,3,4,5,6,7};
 
@@ -365,7 +696,7 @@ DdlAppManager::adaptJobsFlowTosCrux()
     crux.solveDAG();
     vector<vector<uint32_t>> output = crux.getOutputCut();
 
-    // 5. set tos
+    // 4. set tos
     uint32_t groupNum = output.size();
 
     for (uint32_t groupId = 0; groupId < groupNum; groupId++)
@@ -397,44 +728,32 @@ DdlAppManager::adaptJobsFlowTosJFP()
     NS_LOG_FUNCTION(this);
     // we should adapt the flow tos to suit the new running jobs set
     // we should first get the all running jobs set
-    // 1. get the map from leaf to spine
-    map<uint32_t, uint32_t> leafSpineMap = m_topo->getLeafSpineMap();
-    // 2. get the all running jobs's using gpuIndex, that is m_jobGPU,
+    // 1. get the all running jobs's using gpuIndex, that is m_jobGPU,
     // the job itself don't save the gpuIndex, it is saved in the manager
-    // 3. get the link id from the leafSpineMap and the placement(gpuIndex)
+    // 2. get the link id from the topo's links of the placement(gpuIndex)
     //  and get the job intensity
-    map<uint32_t, vector<string>> jobUseLinkId;
+    // jobId -> flowId -> the links of the flow
+    map<uint32_t, vector<vector<uint32_t>>> jobUseLinkId;
     map<uint32_t, map<uint32_t, map<string, uint32_t>>> jobJFPFlowIntensity;
 
     for (auto& [jobId, job] : m_runningApps)
     {
         jobJFPFlowIntensity[jobId] = job->getJFPFlowFeatures();
         vector<uint32_t> useGpuIndex = m_jobGPU[jobId];
-        vector<string> useLinkId;
+        vector<vector<uint32_t>> useLinkId;
         for (uint32_t i = 0; i < useGpuIndex.size(); i += 2) // attention here
         {
             uint32_t senderGpuId = useGpuIndex[i];
             uint32_t receiverGpuId = useGpuIndex[i + 1];
             cout << "Sender GPU ID: " << senderGpuId << ", Receiver GPU ID: " << receiverGpuId << endl;
-            uint32_t gpuNumPerLeaf = m_topo->getGpuNumPerLeaf();
-            uint32_t senderLeafId = senderGpuId / gpuNumPerLeaf;
-            uint32_t senderSpineId = leafSpineMap[senderLeafId];
-            if (senderGpuId / gpuNumPerLeaf == receiverGpuId / gpuNumPerLeaf)
-            {
-                // noting that the link is not the link between leaf and spine, appears once at most
-                useLinkId.push_back("gpulink" + to_string(senderGpuId));
-            }
-            else
-            {
-                // noting that the link is the link between leaf and spine
-                useLinkId.push_back("link" + to_string(senderLeafId) + to_string(senderSpineId));
-            }
+            // the switch links of the path, up to the spine and down to the receiver leaf,
+            // or the gpu link of a flow inside a leaf, which appears once at most
+            useLinkId.push_back(getSolverLinks(senderGpuId, receiverGpuId));
         }
         jobUseLinkId[jobId] = useLinkId;
     }
     DdlJFP jfp(jobUseLinkId, jobJFPFlowIntensity, m_solverPort);
     jfp.solveMatrix();
-    map<uint32_t, map<string, uint32_t>> output = jfp.getPriorityMatrix();
 
     // here the JFP solver return the opposite result, 
     // the smaller the priority, the lower the priority
@@ -443,15 +762,14 @@ DdlAppManager::adaptJobsFlowTosJFP()
 
     for (auto& [jobId, job] : m_runningApps)
     {
-        map<string, uint32_t> flowPriority = output[jobId];
         vector<uint32_t> tosList;
-        vector<string> links = jobUseLinkId[jobId];
         // the link are complete
         cout << "Job ID: " << jobId << ", Link List: " << endl;
-        for (auto& link : links)
+        for (uint32_t flowId = 0; flowId < jobUseLinkId[jobId].size(); flowId++)
         {
-            tosList.push_back(prioList[flowPriority[link]]);
-            cout << "Link: " << link << ", TOS: " << prioList[flowPriority[link]] << endl;
+            uint32_t tos = prioList[jfp.getFlowPriority(jobId, flowId)];
+            tosList.push_back(tos);
+            cout << "Flow: " << flowId << ", TOS: " << tos << endl;
         }
 
         job->setFlowTos(tosList);
@@ -475,6 +793,37 @@ DdlAppManager::adaptJobsFlowTosJFP()
     // }
 }
 
+void
+DdlAppManager::adaptJobsFlowTosAgent()
+{
+    NS_LOG_FUNCTION(this);
+    agentStep(DDL_AGENT_TOS, m_agentEvent, nullptr);
+    // the rows follow m_runningApps, as the step wrote them
+    uint32_t linkNum = m_agentEnv->header()->linkNum;
+    uint32_t row = 0;
+    for (auto& [jobId, job] : m_runningApps)
+    {
+        const uint8_t* rowTos = m_agentEnv->tos() + (size_t)row * linkNum;
+        row++;
+        const vector<uint32_t>& gpuIndex = m_jobGPU[jobId];
+        vector<uint32_t> tosList(job->getFlowNum(), 0);
+        for (uint32_t i = 0; i + 1 < gpuIndex.size() && i / 2 < tosList.size(); i += 2)
+        {
+            // the link the flow contends on most decides, a flow to its own gpu keeps 0
+            float busiestLoad = -1;
+            for (uint32_t link : m_topo->getPathLinks(gpuIndex[i], gpuIndex[i + 1]))
+            {
+                if (m_agentLinkLoad[link] > busiestLoad)
+                {
+                    busiestLoad = m_agentLinkLoad[link];
+                    tosList[i / 2] = rowTos[link];
+                }
+            }
+        }
+        job->setFlowTos(tosList);
+    }
+}
+
 void
 DdlAppManager::addApp(DdlApplication* job)
 {
@@ -498,6 +847,11 @@ DdlAppManager::getJobPlacement(DdlApplication* job)
     {
         eraseMapElement(&m_unArrivedApps, jobId);
         m_jobStatistics[jobId]["arriveTime"] = (uint32_t)Simulator::Now().GetMilliSeconds();
+        // the agent placement steps at each check of the job instead
+        if (m_agentEnv && m_placeStrategy != "agent")
+        {
+            agentStep(DDL_AGENT_OBSERVE, DDL_AGENT_ARRIVAL, job);
+        }
     }
 
     if (m_placeStrategy == "sequence")
@@ -511,6 +865,14 @@ DdlAppManager::getJobPlacement(DdlApplication* job)
     {
         gpuIndex = loadBalancePlacement(job);
     }
+    else if (m_placeStrategy == "score")
+    {
+        gpuIndex = scorePlacement(job);
+    }
+    else if (m_placeStrategy == "agent")
+    {
+        gpuIndex = agentPlacement(job);
+    }
     else
     {
         NS_LOG_INFO("Not supported place strategy: " << m_placeStrategy);
@@ -535,7 +897,12 @@ DdlAppManager::getJobPlacement(DdlApplication* job)
         // key point of my work.
         eraseMapElement(&m_pendingApps, jobId);
         addMapElement(&m_runningApps, job);
+        m_agentEvent = DDL_AGENT_START;
         adaptJobsFlowTos();
+        if (m_agentEnv && m_tosStrategy != "agent")
+        {
+            agentStep(DDL_AGENT_OBSERVE, DDL_AGENT_START, job);
+        }
         m_jobStatistics[jobId]["startTime"] = (uint32_t)Simulator::Now().GetMilliSeconds();
         m_jobStatistics[jobId]["placement"] = removeDuplicates(gpuIndex);
     }
@@ -557,9 +924,244 @@ DdlAppManager::runApp()
     NS_LOG_FUNCTION(this);
     // auto job = m_unArrivedApps[1];
     // job->checkAndStartApplication();
+    // the other ranks only run the flow apps the coordinator installs on them
+    if (Simulator::GetSystemId() != m_topo->getCoordinatorSystemId())
+    {
+        return;
+    }
+    if (!m_agentShmName.empty())
+    {
+        uint32_t linkNum = m_topo->getLinkNum();
+        m_agentEnv =
+            DdlAgentEnv::create(m_agentShmName, m_allApps.size(), linkNum, m_gpuStates.size());
+        if (!m_agentEnv)
+        {
+            NS_FATAL_ERROR("Failed to create the agent env " << m_agentShmName);
+        }
+        m_agentLinkLoad.assign(linkNum, 0);
+        // the queues of the other partitions are out of reach, their depths stay 0
+        if (!m_distributed)
+        {
+            for (const DdlLinkId& linkId : m_topo->getLinkIds())
+            {
+                Ptr<NetDevice> device = m_topo->getLinkSendDevice(linkId);
+                Ptr<TrafficControlLayer> tc = device->GetNode()->GetObject<TrafficControlLayer>();
+                m_agentQueues.push_back(tc ? tc->GetRootQueueDiscOnDevice(device) : nullptr);
+            }
+        }
+        if (m_agentTick.IsStrictlyPositive())
+        {
+            Simulator::ScheduleWithContext(m_topo->getCoordinatorNodeId(),
+                                           m_agentTick,
+                                           &DdlAppManager::agentTick,
+                                           this);
+        }
+    }
+    else if (m_placeStrategy == "agent" || m_tosStrategy == "agent")
+    {
+        NS_FATAL_ERROR("The agent strategies need setAgentEnv");
+    }
     for (auto& [jobId, job] : m_allApps)
     {
-        job->checkAndStartApplication();
+        if (!m_distributed)
+        {
+            job->checkAndStartApplication();
+        }
+        else
+        {
+            // the checks run in the context of the coordinator, so do their messages
+            Simulator::ScheduleWithContext(m_topo->getCoordinatorNodeId(),
+                                           Seconds(0),
+                                           &DdlApplication::checkAndStartApplication,
+                                           job);
+        }
+    }
+}
+
+void
+DdlAppManager::setAgentEnv(string shmName, Time tick, double timeoutSeconds)
+{
+    m_agentShmName = shmName;
+    m_agentTick = tick;
+    m_agentTimeout = timeoutSeconds;
+}
+
+void
+DdlAppManager::agentStep(DdlAgentDecision decision, DdlAgentEvent event, DdlApplication* job)
+{
+    NS_LOG_FUNCTION(this);
+    auto stepStart = chrono::steady_clock::now();
+    DdlAgentHeader* header = m_agentEnv->header();
+    uint32_t linkNum = header->linkNum;
+    // a row per running job, its comm ms of an iteration on every link of its flows' paths
+    fill(m_agentLinkLoad.begin(), m_agentLinkLoad.end(), 0);
+    uint32_t row = 0;
+    for (auto& [jobId, runningJob] : m_runningApps)
+    {
+        m_agentEnv->jobIds()[row] = jobId;
+        m_agentEnv->progress()[row] =
+            (float)runningJob->getFinishedIterNum() / max(1u, runningJob->getIterNum());
+        float* rowLink = m_agentEnv->jobLink() + (size_t)row * linkNum;
+        fill(rowLink, rowLink + linkNum, 0.0f);
+        const auto& flowTimes = runningJob->getFlowCompCommTimes();
+        const vector<uint32_t>& gpuIndex = m_jobGPU[jobId];
+        for (uint32_t i = 0; i + 1 < gpuIndex.size() && i / 2 < flowTimes.size(); i += 2)
+        {
+            for (uint32_t link : m_topo->getPathLinks(gpuIndex[i], gpuIndex[i + 1]))
+            {
+                rowLink[link] += flowTimes[i / 2].second;
+                m_agentLinkLoad[link] += flowTimes[i / 2].second;
+            }
+        }
+        row++;
+    }
+    uint32_t* queueBytes = m_agentEnv->queueBytes();
+    for (uint32_t i = 0; i < m_agentQueues.size(); i++)
+    {
+        queueBytes[i] = m_agentQueues[i] ? m_agentQueues[i]->GetNBytes() : 0;
+    }
+    uint8_t* gpuFree = m_agentEnv->gpuFree();
+    for (uint32_t i = 0; i < m_gpuStates.size(); i++)
+    {
+        gpuFree[i] = m_gpuStates[i] == GpuState::FREE;
+    }
+    header->decision = decision;
+    header->event = event;
+    header->jobId = job ? job->getJobId() : 0;
+    header->workerNum = job ? job->getWorkerNum() : 0;
+    header->jobNum = row;
+    header->placementNum = 0;
+    header->timeNs = Simulator::Now().GetNanoSeconds();
+    if (!m_agentEnv->step(m_agentTimeout))
+    {
+        NS_FATAL_ERROR("No action of the agent within " << m_agentTimeout << " s");
+    }
+    m_agentSeconds += chrono::duration<double>(chrono::steady_clock::now() - stepStart).count();
+}
+
+void
+DdlAppManager::agentTick()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_finishedApps.size() == m_allApps.size())
+    {
+        return;
+    }
+    if (m_tosStrategy == "agent" && !m_runningApps.empty())
+    {
+        m_agentEvent = DDL_AGENT_TICK;
+        adaptJobsFlowTos();
+    }
+    else
+    {
+        agentStep(DDL_AGENT_OBSERVE, DDL_AGENT_TICK, nullptr);
+    }
+    Simulator::Schedule(m_agentTick, &DdlAppManager::agentTick, this);
+}
+
+void
+DdlAppManager::sendControl(uint32_t target, DdlControlMessage message)
+{
+    message.time = Simulator::Now().GetMicroSeconds();
+    if (!m_distributed)
+    {
+        handleControl(target, message);
+        return;
+    }
+    bool toCoordinator = target == DDL_COORDINATOR;
+    uint32_t systemId =
+        toCoordinator ? m_topo->getCoordinatorSystemId() : m_topo->getGpuSystemId(target);
+    if (!m_remoteRanks || systemId == Simulator::GetSystemId())
+    {
+        // the simulator carries the message to the partition of the target
+        uint32_t nodeId =
+            toCoordinator ? m_topo->getCoordinatorNodeId() : m_topo->getGpuNodeId(target);
+        Simulator::ScheduleWithContext(nodeId,
+                                       m_controlDelay,
+                                       &DdlAppManager::handleControl,
+                                       this,
+                                       target,
+                                       message);
+        return;
+    }
+
+    // another rank, the message goes through the fabric from the current node
+    auto it = m_controlSockets.find(Simulator::GetContext());
+    if (it == m_controlSockets.end())
+    {
+        NS_FATAL_ERROR("Control messages to other ranks are sent from a gpu or the coordinator");
+    }
+    Ipv4Address address;
+    if (toCoordinator)
+    {
+        uint32_t gpu = m_topo->getGpuIndexOfNode(Simulator::GetContext());
+        address = m_topo->getCoordinatorAddress(gpu / m_topo->getGpuNumPerLeaf());
+    }
+    else
+    {
+        address = m_topo->getGpuAddress(target);
+    }
+    DdlControlHeader header;
+    header.setMessage(message);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    it->second->SendTo(packet, 0, InetSocketAddress(address, DDL_CONTROL_PORT));
+}
+
+void
+DdlAppManager::handleControl(uint32_t target, DdlControlMessage message)
+{
+    NS_LOG_FUNCTION(this);
+    auto it = m_allApps.find(message.jobId);
+    if (it == m_allApps.end())
+    {
+        NS_LOG_INFO("Control message of unknown Job[" << message.jobId << "] at " << target);
+        return;
+    }
+    it->second->handleControl(message);
+}
+
+void
+DdlAppManager::installControlSockets()
+{
+    NS_LOG_FUNCTION(this);
+    // only the nodes of this rank, the other ranks install theirs
+    uint32_t systemId = Simulator::GetSystemId();
+    vector<Ptr<Node>> nodes;
+    if (m_topo->getCoordinatorSystemId() == systemId)
+    {
+        nodes.push_back(m_topo->getSpineNodes().Get(0));
+    }
+    for (uint32_t i = 0; i < m_topo->getGpuNum(); i++)
+    {
+        if (m_topo->getGpuSystemId(i) == systemId)
+        {
+            nodes.push_back(m_topo->getGpuNode(i));
+        }
+    }
+    for (auto node : nodes)
+    {
+        Ptr<Socket> socket = Socket::CreateSocket(node, UdpSocketFactory::GetTypeId());
+        socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), DDL_CONTROL_PORT));
+        socket->SetRecvCallback(MakeCallback(&DdlAppManager::handleControlPacket, this));
+        m_controlSockets[node->GetId()] = socket;
+    }
+}
+
+void
+DdlAppManager::handleControlPacket(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this);
+    uint32_t nodeId = socket->GetNode()->GetId();
+    uint32_t target = nodeId == m_topo->getCoordinatorNodeId()
+                          ? DDL_COORDINATOR
+                          : m_topo->getGpuIndexOfNode(nodeId);
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        DdlControlHeader header;
+        packet->RemoveHeader(header);
+        handleControl(target, header.getMessage());
     }
 }
 
@@ -585,10 +1187,291 @@ DdlAppManager::stopApp(uint32_t jobId)
     m_jobStatistics[jobId]["finishTime"] = (uint32_t)Simulator::Now().GetMilliSeconds();
     m_jobStatistics[jobId]["gpuUtilization"] = m_allApps[jobId]->getGpuUtilizationSum();
     // every time a job finishs, we should adapt the flow tos again
-    if ((m_tosStrategy == "crux" || m_tosStrategy == "JFP") && m_runningApps.size() > 0)
+    bool agentTos = m_tosStrategy == "agent";
+    if ((m_tosStrategy == "crux" || m_tosStrategy == "JFP" || agentTos) &&
+        m_runningApps.size() > 0)
     {
+        m_agentEvent = DDL_AGENT_FINISH;
         adaptJobsFlowTos();
     }
+    if (m_agentEnv)
+    {
+        if (!agentTos || m_runningApps.empty())
+        {
+            agentStep(DDL_AGENT_OBSERVE, DDL_AGENT_FINISH, m_allApps[jobId]);
+        }
+        if (m_finishedApps.size() == m_allApps.size())
+        {
+            m_agentEnv->end();
+        }
+    }
+}
+
+double
+DdlAppManager::getMeanJct()
+{
+    double jctSum = 0;
+    for (auto& [jobId, job] : m_finishedApps)
+    {
+        jctSum += get<uint32_t>(m_jobStatistics[jobId]["finishTime"]) -
+                  get<uint32_t>(m_jobStatistics[jobId]["arriveTime"]);
+    }
+    return m_finishedApps.empty() ? 0 : jctSum / m_finishedApps.size();
+}
+
+double
+DdlAppManager::getGpuUtilization()
+{
+    // up to the last finish, or to now while a job runs
+    double endTime = 0;
+    for (auto& [jobId, statistics] : m_jobStatistics)
+    {
+        if (statistics.find("startTime") == statistics.end())
+        {
+            continue;
+        }
+        if (statistics.find("finishTime") == statistics.end())
+        {
+            endTime = Simulator::Now().GetMilliSeconds();
+            break;
+        }
+        endTime = max(endTime, (double)get<uint32_t>(statistics["finishTime"]));
+    }
+    double busyTime = 0;
+    for (auto& [jobId, statistics] : m_jobStatistics)
+    {
+        if (statistics.find("startTime") == statistics.end())
+        {
+            continue;
+        }
+        double finishTime = statistics.find("finishTime") == statistics.end()
+                                ? endTime
+                                : get<uint32_t>(statistics["finishTime"]);
+        uint32_t gpuNum = get<vector<uint32_t>>(statistics["placement"]).size();
+        busyTime += gpuNum * (finishTime - get<uint32_t>(statistics["startTime"]));
+    }
+    return endTime > 0 ? busyTime / (m_gpuStates.size() * endTime) : 0;
+}
+
+void
+DdlAppManager::setIterTimelineFile(string filename)
+{
+    NS_LOG_FUNCTION(this);
+    // a large buffer, the rows are flushed in big writes instead of one per iteration
+    m_iterTimelineBuffer.resize(1 << 20);
+    m_iterTimelineFile.rdbuf()->pubsetbuf(m_iterTimelineBuffer.data(), m_iterTimelineBuffer.size());
+    m_iterTimelineFileName = filename;
+    m_iterTimelineFile.open(filename);
+    if (!m_iterTimelineFile.is_open())
+    {
+        cerr << "Failed to open file: " << filename << endl;
+        exit(0);
+    }
+    // the per-flow columns are joined by "-" in the same flow order
+    m_iterTimelineFile << "jobId,iter,startTime,endTime,iterTime,flowIds,transferTimes,flowTos\n";
+}
+
+void
+DdlAppManager::registerFlowPort(uint32_t dstGpu, uint16_t port, uint32_t jobId, uint32_t flowId)
+{
+    uint32_t address = m_topo->getGpuAddress(dstGpu).Get();
+    m_flowPorts[{address, port}] = {jobId, flowId};
+}
+
+bool
+DdlAppManager::findFlowByPort(Ipv4Address address,
+                              uint16_t port,
+                              uint32_t& jobId,
+                              uint32_t& flowId)
+{
+    auto it = m_flowPorts.find({address.Get(), port});
+    if (it == m_flowPorts.end())
+    {
+        return false;
+    }
+    jobId = it->second.first;
+    flowId = it->second.second;
+    return true;
+}
+
+void
+DdlAppManager::setTosBranches(vector<string> strategies, Time branchTime)
+{
+    NS_LOG_FUNCTION(this);
+    for (const auto& strategy : strategies)
+    {
+        // JFP and crux+ share one python solver connection, a fork cannot split it
+        if (strategy != "crux" && strategy != "equal")
+        {
+            NS_FATAL_ERROR("Only the crux and equal tos strategies can branch, not " << strategy);
+        }
+    }
+    if (m_distributed)
+    {
+        NS_FATAL_ERROR("A partitioned fabric runs on several threads or ranks, it cannot fork");
+    }
+    m_branchStrategies = strategies;
+    m_branchTime = branchTime;
+}
+
+void
+DdlAppManager::forkTosBranches()
+{
+    NS_LOG_FUNCTION(this);
+    vector<string> strategies = m_branchStrategies;
+    m_branchStrategies.clear();
+    // the buffered output would otherwise be written once by every process
+    cout.flush();
+    if (m_iterTimelineFile.is_open())
+    {
+        m_iterTimelineFile.flush();
+    }
+    for (const auto& strategy : strategies)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            NS_FATAL_ERROR("Failed to create the pipe of the " << strategy << " branch");
+        }
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            NS_FATAL_ERROR("Failed to fork the " << strategy << " branch");
+        }
+        if (pid == 0)
+        {
+            close(fds[0]);
+            for (auto& [otherStrategy, child] : m_branchChildren)
+            {
+                close(child.second);
+            }
+            m_branchChildren.clear();
+            m_branchPipe = fds[1];
+            m_tosBranch = strategy;
+            m_tosStrategy = strategy;
+            if (m_iterTimelineFile.is_open())
+            {
+                // the branch goes on in its own copy of the timeline
+                string filename = m_iterTimelineFileName;
+                size_t dot = filename.find_last_of('.');
+                size_t slash = filename.find_last_of('/');
+                if (dot == string::npos || (slash != string::npos && dot < slash))
+                {
+                    dot = filename.size();
+                }
+                filename.insert(dot, "-" + strategy);
+                m_iterTimelineFile.close();
+                ifstream prefix(m_iterTimelineFileName);
+                m_iterTimelineFile.open(filename);
+                m_iterTimelineFile << prefix.rdbuf();
+                m_iterTimelineFileName = filename;
+            }
+            NS_LOG_INFO("Branch " << getpid() << " goes on with the tos strategy " << strategy);
+            return;
+        }
+        close(fds[1]);
+        m_branchChildren[strategy] = {pid, fds[0]};
+    }
+    // the parent has no decision of its own past this point
+    Simulator::Stop();
+}
+
+void
+DdlAppManager::sendBranchResult(string result)
+{
+    NS_LOG_FUNCTION(this);
+    if (m_branchPipe < 0)
+    {
+        NS_FATAL_ERROR("Only a branch sends its result");
+    }
+    if (m_iterTimelineFile.is_open())
+    {
+        m_iterTimelineFile.flush();
+    }
+    size_t written = 0;
+    while (written < result.size())
+    {
+        ssize_t n = write(m_branchPipe, result.data() + written, result.size() - written);
+        if (n <= 0)
+        {
+            break;
+        }
+        written += n;
+    }
+    close(m_branchPipe);
+    m_branchPipe = -1;
+}
+
+map<string, string>
+DdlAppManager::collectBranchResults()
+{
+    NS_LOG_FUNCTION(this);
+    map<string, string> results;
+    // a branch only writes when it ends, reading them in turn cannot block one another
+    for (auto& [strategy, child] : m_branchChildren)
+    {
+        string result;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(child.second, buffer, sizeof(buffer))) > 0)
+        {
+            result.append(buffer, n);
+        }
+        close(child.second);
+        int status = 0;
+        waitpid(child.first, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            NS_LOG_INFO("The " << strategy << " branch failed with status " << status);
+            result.clear();
+        }
+        results[strategy] = result;
+    }
+    m_branchChildren.clear();
+    return results;
+}
+
+uint64_t
+DdlAppManager::getDeliveredBytes()
+{
+    uint64_t deliveredBytes = 0;
+    for (auto& [jobId, job] : m_allApps)
+    {
+        deliveredBytes += (uint64_t)job->getFinishedIterNum() * job->getIterCommBytes();
+    }
+    return deliveredBytes;
+}
+
+void
+DdlAppManager::writeIterRecord(const DdlIterRecord& record)
+{
+    if (!m_iterTimelineFile.is_open())
+    {
+        return;
+    }
+    m_iterTimelineFile << record.jobId << "," << record.iter << "," << record.startTime << ","
+                       << record.endTime << "," << record.endTime - record.startTime << ",";
+    string sep;
+    for (const auto& [flowId, transferTime] : record.flowTransferTime)
+    {
+        m_iterTimelineFile << sep << flowId;
+        sep = "-";
+    }
+    m_iterTimelineFile << ",";
+    sep = "";
+    for (const auto& [flowId, transferTime] : record.flowTransferTime)
+    {
+        m_iterTimelineFile << sep << transferTime;
+        sep = "-";
+    }
+    m_iterTimelineFile << ",";
+    sep = "";
+    for (const auto& [flowId, transferTime] : record.flowTransferTime)
+    {
+        m_iterTimelineFile << sep << record.flowTos.at(flowId);
+        sep = "-";
+    }
+    m_iterTimelineFile << "\n";
 }
 
 void
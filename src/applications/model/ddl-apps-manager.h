@@ -2,9 +2,12 @@
 #define DDL_APPS_MANAGER_H
 #include "../helper/ddl-flow-recv-helper.h"
 #include "../helper/ddl-flow-send-helper.h"
+#include "ddl-agent-env.h"
 #include "ddl-app.h"
+#include "ddl-control.h"
 #include "ddl-flow-recv.h"
 #include "ddl-flow-send.h"
+#include "ddl-placement-score.h"
 #include "ddl-state.h"
 #include "ddl-topo.h"
 
@@ -23,6 +26,9 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 
+#include <chrono>
+#include <fstream>
+#include <random>
 #include <unistd.h>
 #include <variant>
 #include <vector>
@@ -31,6 +37,12 @@ using namespace std;
 namespace ns3
 {
 class DdlApplication;
+struct DdlIterRecord;
+
+// the target of a control message sent to the coordinator instead of a gpu
+const uint32_t DDL_COORDINATOR = UINT32_MAX;
+// the udp port of the control messages between the ranks of the MPI simulator
+const uint16_t DDL_CONTROL_PORT = 1999;
 
 class DdlAppManager
 {
@@ -53,11 +65,20 @@ class DdlAppManager
     // placement strategy related functions
     vector<uint32_t> getJobPlacement(DdlApplication* job);
     bool jobIsFirstArrived(DdlApplication* job);
+    // FIFO, or a later job backfills if it delays no reserved earlier job
+    bool jobMayStart(DdlApplication* job);
+    // none keeps the FIFO order, easy reserves gpus for the head pending job,
+    // conservative for every pending job before the one to start
+    void setBackfilling(string backfilling);
+    // the ms a running job is predicted to finish at, from its iterations so far
+    // or from its oracle running time before the first one
+    double predictFinishTime(uint32_t jobId);
     void adaptJobsFlowTos();
     void adaptJobsFlowTosCrux();
     void adaptJobsFlowTosEqual();
     void adaptJobsFlowTosJFP();
-    
+    // the tos of a flow is the agent's tos of its job at the most loaded link of its path
+    void adaptJobsFlowTosAgent();
 
     void startPythonSolver(bool cruxPlus)
     { 
@@ -85,15 +106,173 @@ class DdlAppManager
     vector<uint32_t> consolidatePlacement(DdlApplication* job);
     vector<uint32_t> sequencePlacement(DdlApplication* job);
     vector<uint32_t> loadBalancePlacement(DdlApplication* job);
+    // the candidate with the least mean slowdown of the running jobs and the job
+    vector<uint32_t> scorePlacement(DdlApplication* job);
+    // the workers the agent picks, empty if it defers the job or picks gpus it cannot get
+    vector<uint32_t> agentPlacement(DdlApplication* job);
+
+    // the candidates scorePlacement draws per arrival, at least the lb and sequence ones
+    void setPlacementCandidates(uint32_t candidateNum)
+    {
+        m_placementCandidates = candidateNum;
+    }
+
+    // wall-clock seconds spent scoring placements, and the candidates scored
+    double getPlacementSeconds()
+    {
+        return m_placementSeconds;
+    }
+
+    uint64_t getScoredCandidates()
+    {
+        return m_scoredCandidates;
+    }
+
+    // the jobs started by backfilling, ahead of an earlier pending job
+    uint32_t getBackfilledJobs()
+    {
+        return m_backfilledJobs;
+    }
+
+    // the mean ms from arrival to finish of the finished jobs
+    double getMeanJct();
+    // the share of the gpu time the started jobs held, from 0 to the last finish
+    double getGpuUtilization();
 
     void dumpJobStatistics(string filename);
 
+    // stream one row per finished iteration to filename, set before runApp
+    void setIterTimelineFile(string filename);
+    void writeIterRecord(const DdlIterRecord& record);
+
     spineLeafTopo* getTopo()
     {
         return m_topo;
     }
 
+    // 0 disables the small flow fusion when jobs generate their flows
+    void setSmallFlowFusionBytes(uint32_t maxFusedBytes)
+    {
+        m_smallFlowFusionBytes = maxFusedBytes;
+    }
+
+    uint32_t getSmallFlowFusionBytes()
+    {
+        return m_smallFlowFusionBytes;
+    }
+
+    // the transfers inside a host complete after a delay of the topo's intra-host rate,
+    // without packets, disabled by default
+    void setIntraHostTransfer(bool intraHost)
+    {
+        m_intraHost = intraHost;
+    }
+
+    // 0 if the transfer between the gpus goes through the fabric
+    DataRate getIntraHostRate(uint32_t srcGpu, uint32_t dstGpu)
+    {
+        return m_intraHost ? m_topo->getIntraHostRate(srcGpu, dstGpu) : DataRate(0);
+    }
+
+    // the dir holding the ddl-job-<jobId>.csv files, must be set before the jobs are created
+    // empty by default, the files are then read from the working dir
+    void setJobTraceDir(string jobTraceDir)
+    {
+        m_jobTraceDir = jobTraceDir;
+    }
+
+    string getJobTraceDir()
+    {
+        return m_jobTraceDir;
+    }
+
+    // bytes sent by the finished iterations of all the jobs
+    uint64_t getDeliveredBytes();
+
+    // wall-clock seconds spent in the tos solvers since the manager was created
+    double getSolverSeconds()
+    {
+        return m_solverSeconds;
+    }
+
+    // with a partitioned fabric the jobs and the flow apps run in different partitions,
+    // they only talk through control messages
+    bool isDistributed()
+    {
+        return m_distributed;
+    }
+
+    // the delay of the control messages within a process, at least the lookahead
+    void setControlDelay(Time controlDelay)
+    {
+        m_controlDelay = controlDelay;
+    }
+
+    // deliver a message to a gpu or to DDL_COORDINATOR, it is handled at once
+    // unless the fabric is partitioned
+    void sendControl(uint32_t target, DdlControlMessage message);
+    void handleControl(uint32_t target, DdlControlMessage message);
+
+    // the packets of a flow go to its recv gpu at the port of the flow, a fused chain uses
+    // the port of its head flow, so the ns-3 flows are mapped back to (job, flow) ids
+    void registerFlowPort(uint32_t dstGpu, uint16_t port, uint32_t jobId, uint32_t flowId);
+    // false if no flow is sent to the address and port, a later job may reuse the port
+    bool findFlowByPort(Ipv4Address address, uint16_t port, uint32_t& jobId, uint32_t& flowId);
+
+    // fork one process per tos strategy at the first tos decision at or after branchTime,
+    // the branches share the simulated prefix and each one goes on with its strategy,
+    // the parent stops its simulation there and waits for their results
+    // only the in-process strategies (crux, equal) can branch, and not a partitioned fabric
+    void setTosBranches(vector<string> strategies, Time branchTime);
+
+    // the tos strategy of this process once it branched, empty in the parent
+    string getTosBranch()
+    {
+        return m_tosBranch;
+    }
+
+    // true in the parent once the branches are forked
+    bool hasTosBranches()
+    {
+        return !m_branchChildren.empty();
+    }
+
+    // step an agent process through the shared memory /dev/shm/<shmName>, set before runApp:
+    // at each arrival, start and finish of a job and every tick, 0 disables the ticks
+    // the agent place and tos strategies take its actions, the others let it only observe
+    // the simulator waits timeoutSeconds at most for an action, 0 waits forever
+    void setAgentEnv(string shmName, Time tick, double timeoutSeconds = 0);
+
+    uint64_t getAgentSteps()
+    {
+        return m_agentEnv ? m_agentEnv->getStepNum() : 0;
+    }
+
+    // wall-clock seconds spent in the agent steps, the observation included
+    double getAgentSeconds()
+    {
+        return m_agentSeconds;
+    }
+
+    // in a branch, hand its result to the parent
+    void sendBranchResult(string result);
+    // in the parent, wait for the branches, strategy -> result, empty if the branch failed
+    map<string, string> collectBranchResults();
+
   private:
+    void installControlSockets();
+    void handleControlPacket(Ptr<Socket> socket);
+    void forkTosBranches();
+    // the dense topo indices of the links the tos solvers and the scorer see for a flow:
+    // the switch links of its path, or the link of the sender gpu inside a leaf
+    vector<uint32_t> getSolverLinks(uint32_t srcGpu, uint32_t dstGpu);
+    // (linkId, comm time) of the flows of a job placed on gpuIndex, a flow on each of its links
+    vector<pair<uint32_t, float>> getPlacementLinkComm(DdlApplication* job,
+                                                       const vector<uint32_t>& gpuIndex);
+    // write the observation, publish the step and wait for the action
+    void agentStep(DdlAgentDecision decision, DdlAgentEvent event, DdlApplication* job);
+    void agentTick();
+
     string m_placeStrategy;
     string m_tosStrategy;
 
@@ -116,6 +295,57 @@ class DdlAppManager
 
     // python solver port
     uint16_t m_solverPort;
+
+    // the max comm size of a zero-compute flow fused into its upstream flow
+    uint32_t m_smallFlowFusionBytes;
+    // same gpu and nvlink transfers skip the fabric
+    bool m_intraHost;
+
+    string m_jobTraceDir;
+    double m_solverSeconds;
+
+    ofstream m_iterTimelineFile;
+    vector<char> m_iterTimelineBuffer;
+    string m_iterTimelineFileName;
+
+    bool m_distributed;
+    // the partitions run in other processes, the messages to them go as packets
+    bool m_remoteRanks;
+    Time m_controlDelay;
+    // node id -> the control socket of the local nodes, only with remote ranks
+    map<uint32_t, Ptr<Socket>> m_controlSockets;
+    // (recv gpu address, port) -> (jobId, flowId) of the last flow sent there
+    map<pair<uint32_t, uint16_t>, pair<uint32_t, uint32_t>> m_flowPorts;
+
+    // the strategies to branch to, cleared once forked
+    vector<string> m_branchStrategies;
+    Time m_branchTime;
+    string m_tosBranch;
+    // the write end of the pipe to the parent, -1 out of a branch
+    int m_branchPipe;
+    // strategy -> (pid, read end of its pipe) of the branches, in the parent
+    map<string, pair<pid_t, int>> m_branchChildren;
+
+    uint32_t m_placementCandidates;
+    // the random candidates, apart from rand() so the other strategies see the same runs
+    mt19937 m_placementRng;
+    double m_placementSeconds;
+    uint64_t m_scoredCandidates;
+
+    string m_backfilling;
+    uint32_t m_backfilledJobs;
+
+    string m_agentShmName;
+    Time m_agentTick;
+    double m_agentTimeout;
+    unique_ptr<DdlAgentEnv> m_agentEnv;
+    // what the next tos step of the agent answers
+    DdlAgentEvent m_agentEvent;
+    // the dense link index -> the root queue disc sending into it, empty if partitioned
+    vector<Ptr<QueueDisc>> m_agentQueues;
+    // the comm ms of all the observed jobs on each link, the load the tos decision sees
+    vector<float> m_agentLinkLoad;
+    double m_agentSeconds;
 };
 } // namespace ns3
 #endif
\ No newline at end of file
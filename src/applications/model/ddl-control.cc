@@ -0,0 +1,77 @@
+#include "ddl-control.h"
+
+#include "ns3/log.h"
+
+using namespace std;
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("DdlControlHeader");
+NS_OBJECT_ENSURE_REGISTERED(DdlControlHeader);
+
+TypeId
+DdlControlHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::DdlControlHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<DdlControlHeader>();
+    return tid;
+}
+
+DdlControlHeader::DdlControlHeader()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+TypeId
+DdlControlHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+void
+DdlControlHeader::Print(std::ostream& os) const
+{
+    os << "(type=" << (uint32_t)m_message.type << " job=" << m_message.jobId
+       << " flow=" << m_message.flowId << " peer=" << m_message.peerFlowId
+       << " src=" << m_message.srcGpu << " dst=" << m_message.dstGpu
+       << " value=" << m_message.value << " time=" << m_message.time << ")";
+}
+
+uint32_t
+DdlControlHeader::GetSerializedSize() const
+{
+    return 1 + 5 * 4 + 2 * 8;
+}
+
+void
+DdlControlHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8((uint8_t)m_message.type);
+    i.WriteHtonU32(m_message.jobId);
+    i.WriteHtonU32(m_message.flowId);
+    i.WriteHtonU32(m_message.peerFlowId);
+    i.WriteHtonU32(m_message.srcGpu);
+    i.WriteHtonU32(m_message.dstGpu);
+    i.WriteHtonU64(m_message.value);
+    i.WriteHtonU64(m_message.time);
+}
+
+uint32_t
+DdlControlHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_message.type = (DdlControlType)i.ReadU8();
+    m_message.jobId = i.ReadNtohU32();
+    m_message.flowId = i.ReadNtohU32();
+    m_message.peerFlowId = i.ReadNtohU32();
+    m_message.srcGpu = i.ReadNtohU32();
+    m_message.dstGpu = i.ReadNtohU32();
+    m_message.value = i.ReadNtohU64();
+    m_message.time = i.ReadNtohU64();
+    return GetSerializedSize();
+}
+
+} // namespace ns3
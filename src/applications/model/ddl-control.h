@@ -0,0 +1,70 @@
+#ifndef DDL_CONTROL_H
+#define DDL_CONTROL_H
+#include "ns3/header.h"
+
+#include <cstdint>
+#include <ostream>
+using namespace std;
+
+namespace ns3
+{
+
+// the gpus talk to the coordinator through these messages when the fabric is partitioned,
+// the coordinator owns the job states, the gpus own the flow apps
+enum class DdlControlType : uint8_t
+{
+    FLOW_SEND,       // gpu -> coordinator, a head flow sends an iteration
+    FLOW_FINISH,     // gpu -> coordinator, a tail flow receives an iteration
+    UPSTREAM_FINISH, // coordinator -> gpu, an upstream flow of a sender finished
+    STOP_SEND,       // coordinator -> gpu, the job finished, stop a sender
+    STOP_RECV,       // coordinator -> gpu, the job finished, stop a recv
+    SET_TOS,         // coordinator -> gpu, the tos of a sender changed
+    INSTALL_SEND,    // coordinator -> gpu, create the sender of a flow
+    INSTALL_RECV,    // coordinator -> gpu, create the recv of a flow
+};
+
+struct DdlControlMessage
+{
+    DdlControlType type = DdlControlType::FLOW_SEND;
+    uint32_t jobId = 0;
+    uint32_t flowId = 0;
+    // the upstream flow of UPSTREAM_FINISH, the head flow of INSTALL_RECV,
+    // 1 if FLOW_FINISH stops the job
+    uint32_t peerFlowId = 0;
+    uint32_t srcGpu = 0;
+    uint32_t dstGpu = 0;
+    // the iteration of FLOW_FINISH, the tos of SET_TOS, the bytes of INSTALL_*
+    uint64_t value = 0;
+    // the time in us the message is sent at
+    uint64_t time = 0;
+};
+
+// carries a DdlControlMessage in a packet between the ranks of the MPI simulator
+class DdlControlHeader : public Header
+{
+  public:
+    static TypeId GetTypeId();
+    DdlControlHeader();
+
+    void setMessage(const DdlControlMessage& message)
+    {
+        m_message = message;
+    }
+
+    DdlControlMessage getMessage() const
+    {
+        return m_message;
+    }
+
+    TypeId GetInstanceTypeId() const override;
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+
+  private:
+    DdlControlMessage m_message;
+};
+
+} // namespace ns3
+#endif
@@ -8,7 +8,7 @@
 
 using namespace std;
 
-DdlCrux::DdlCrux(map<uint32_t, vector<string>> jobsLinkId,
+DdlCrux::DdlCrux(map<uint32_t, vector<uint32_t>> jobsLinkId,
                  map<uint32_t, float> jobsIntensity,
                  uint32_t iterNum,
                  uint32_t maxPrioNum)
@@ -47,19 +47,30 @@ DdlCrux::constructDAG()
     set<pair<uint32_t, uint32_t>> addedEdges; // 记录已添加的边，防止重复
 
     // 构建链路到任务的映射：每个链路上有哪些任务
-    map<string, set<uint32_t>> linkToJobs;
+    // the links are dense indices, the jobs come in increasing id order
+    uint32_t linkNum = 0;
     for (const auto& [job, links] : m_jobsLinkId)
     {
-        for (const string& link : links)
+        for (uint32_t link : links)
         {
-            linkToJobs[link].insert(job);
+            linkNum = max(linkNum, link + 1);
+        }
+    }
+    vector<vector<uint32_t>> linkToJobs(linkNum);
+    for (const auto& [job, links] : m_jobsLinkId)
+    {
+        for (uint32_t link : links)
+        {
+            if (linkToJobs[link].empty() || linkToJobs[link].back() != job)
+            {
+                linkToJobs[link].push_back(job);
+            }
         }
     }
 
     // 遍历所有链路，找出共享同一链路的任务
-    for (const auto& [link, jobs] : linkToJobs)
+    for (const auto& jobList : linkToJobs)
     {
-        vector<uint32_t> jobList(jobs.begin(), jobs.end());
 
         // 任务之间两两比较，建立边
         for (size_t i = 0; i < jobList.size(); ++i)
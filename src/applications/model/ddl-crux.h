@@ -25,7 +25,8 @@ struct Edge
 class DdlCrux
 {
   public:
-    DdlCrux(map<uint32_t, vector<string>>, map<uint32_t, float>, uint32_t, uint32_t);
+    // jobId -> the dense topo indices of the links its flows take, a link may repeat
+    DdlCrux(map<uint32_t, vector<uint32_t>>, map<uint32_t, float>, uint32_t, uint32_t);
     void constructDAG();
     void solveDAG();
 
@@ -52,7 +53,7 @@ class DdlCrux
     }
 
   private:
-    map<uint32_t, vector<string>> m_jobsLinkId;
+    map<uint32_t, vector<uint32_t>> m_jobsLinkId;
     map<uint32_t, float> m_jobsIntensity;
 
     vector<uint32_t> m_nodeSeq;
@@ -69,6 +69,11 @@ DdlFlowRecvApplication::GetTypeId()
                           "The last flow of the application",
                           BooleanValue(false),
                           MakeBooleanAccessor(&DdlFlowRecvApplication::m_isLastFlow),
+                          MakeBooleanChecker())
+            .AddAttribute("IntraHost",
+                          "The transfers come from the same host, no socket is opened",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&DdlFlowRecvApplication::m_intraHost),
                           MakeBooleanChecker());
 
     return tid;
@@ -105,6 +110,10 @@ void
 DdlFlowRecvApplication::StartApplication()
 {
     NS_LOG_FUNCTION(this);
+    if (m_intraHost)
+    {
+        return;
+    }
     if (!m_socket)
     {
         m_socket = Socket::CreateSocket(GetNode(), TypeId::LookupByName("ns3::UdpSocketFactory"));
@@ -148,33 +157,40 @@ DdlFlowRecvApplication::HandleRead(Ptr<Socket> socket)
         Address from;
 
         Ptr<Packet> packet = socket->RecvFrom(from);
-        m_receivedBytes += packet->GetSize();
-        // NS_LOG_INFO("Flow[" << m_flowid << "]" << "At time " << Simulator::Now().As(Time::S)
-        //                     << " Received " << m_receivedBytes << " bytes");
-        if (m_receivedBytes >= m_expectedBytes)
+        ReceiveBytes(packet->GetSize());
+    }
+}
+
+void
+DdlFlowRecvApplication::receiveIntraHost(uint32_t bytes)
+{
+    NS_LOG_FUNCTION(this << bytes);
+    ReceiveBytes(bytes);
+}
+
+void
+DdlFlowRecvApplication::ReceiveBytes(uint32_t bytes)
+{
+    m_receivedBytes += bytes;
+    // NS_LOG_INFO("Flow[" << m_flowid << "]" << "At time " << Simulator::Now().As(Time::S)
+    //                     << " Received " << m_receivedBytes << " bytes");
+    if (m_receivedBytes >= m_expectedBytes)
+    {
+        detailedLog(" Received " + std::to_string(m_receivedBytes) + " bytes");
+
+        // tell the parent app that this flow has finished
+
+        m_receivedBytes = 0;
+
+        m_iterCnt++;
+        bool stopJob = false;
+        if (m_isLastFlow)
         {
-            detailedLog(" Received " + std::to_string(m_receivedBytes) + " bytes");
-
-            // tell the parent app that this flow has finished
-
-            m_receivedBytes = 0;
-
-            m_iterCnt++;
-            bool notifyNextFlow = true;
-            if (m_isLastFlow)
-            {
-                detailedLog(" Iteration " + std::to_string(m_iterCnt) + " finished===========");
-                if (m_iterCnt >= m_iterNum)
-                {
-                    notifyNextFlow = false;
-                    m_parentDdlApp->stopAllFlows(m_flowid);
-                }
-            }
-            if (notifyNextFlow)
-            {
-                m_parentDdlApp->notifyFinish(m_flowid);
-            }
+            detailedLog(" Iteration " + std::to_string(m_iterCnt) + " finished===========");
+            stopJob = m_iterCnt >= m_iterNum;
         }
+        // the parent app stops the job or notifies the next flows
+        m_parentDdlApp->flowReceived(m_flowid, m_iterCnt - 1, stopJob);
     }
 }
 
@@ -30,10 +30,15 @@ class DdlFlowRecvApplication : public SinkApplication
         StopApplication();
     }
 
+    // the bytes of an intra-host transfer, delivered without packets
+    void receiveIntraHost(uint32_t bytes);
+
   private:
     void StartApplication() override;
     void StopApplication() override;
     void HandleRead(Ptr<Socket> socket);
+    // count the bytes, the flow finishes an iteration once it has the expected bytes
+    void ReceiveBytes(uint32_t bytes);
     void detailedLog(std::string info);
     Ptr<Socket> m_socket;
     Address m_local;
@@ -53,6 +58,8 @@ class DdlFlowRecvApplication : public SinkApplication
     uint32_t m_iterCnt;
     uint32_t m_iterNum;
     bool m_isLastFlow;
+    // the transfers come from the same host, the recv needs no socket
+    bool m_intraHost;
 
     DdlApplication *m_parentDdlApp;
 };
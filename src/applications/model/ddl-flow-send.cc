@@ -75,7 +75,14 @@ DdlFlowSendApplication::GetTypeId()
                                           "The type of protocol to use.",
                                           TypeIdValue(UdpSocketFactory::GetTypeId()),
                                           MakeTypeIdAccessor(&DdlFlowSendApplication::m_tid),
-                                          MakeTypeIdChecker());
+                                          MakeTypeIdChecker())
+                            .AddAttribute("IntraHostRate",
+                                          "The rate of a transfer inside the host, 0 to send "
+                                          "the packets through the fabric",
+                                          DataRateValue(DataRate(0)),
+                                          MakeDataRateAccessor(
+                                              &DdlFlowSendApplication::m_intraHostRate),
+                                          MakeDataRateChecker());
     return tid;
 }
 
@@ -83,7 +90,9 @@ DdlFlowSendApplication::DdlFlowSendApplication()
     : m_socket(nullptr),
       m_ackSocket(nullptr),
       m_waitingAck(false),
-      m_send_cnt(0)
+      m_send_cnt(0),
+      m_flowTos(0),
+      m_intraHostRecvFlowId(0)
 {
     NS_LOG_FUNCTION(this);
     // m_peer = InetSocketAddress(AddressValue(m_ddlRemote), m_ddlPort);
@@ -104,8 +113,17 @@ DdlFlowSendApplication::PrintInfo()
 void
 DdlFlowSendApplication::StartApplication()
 {
-    m_peer = addressUtils::ConvertToSocketAddress(m_ddlRemote, m_ddlPort);
     NS_LOG_FUNCTION(this);
+    if (m_intraHostRate.GetBitRate() > 0)
+    {
+        // no socket, the transfers never reach the ip stack
+        if (isAllTrue(m_upstreamFinishState))
+        {
+            Simulator::Schedule(m_comptime, &DdlFlowSendApplication::SendPacket, this);
+        }
+        return;
+    }
+    m_peer = addressUtils::ConvertToSocketAddress(m_ddlRemote, m_ddlPort);
     if (!m_socket)
     {
         m_socket = Socket::CreateSocket(GetNode(), TypeId::LookupByName("ns3::UdpSocketFactory"));
@@ -158,16 +176,26 @@ DdlFlowSendApplication::SendFragmentPacket()
     uint32_t packet_sent = 0;
     while (packet_sent <= m_commsize)
     {
-        // adapt the tos to the flow tos, tos is from the parent app
+        // adapt the tos to the flow tos, tos is pushed by the parent app
         // only here we assign tos
         // not the time when flow created, for the tos need to be modified
-        m_socket->SetIpTos(m_parentDdlApp->getFlowTos()[m_flowid]);
+        m_socket->SetIpTos(m_flowTos);
         Ptr<Packet> packet = Create<Packet>(std::min(packet_size, m_commsize - packet_sent));
         m_socket->Send(packet);
         packet_sent += packet_size;
     }
 }
 
+void
+DdlFlowSendApplication::SendIntraHost()
+{
+    Simulator::Schedule(m_intraHostRate.CalculateBytesTxTime(m_commsize),
+                        &DdlApplication::flowReceivedIntraHost,
+                        m_parentDdlApp,
+                        m_intraHostRecvFlowId,
+                        m_commsize);
+}
+
 void
 DdlFlowSendApplication::detailedLog(std::string info)
 {
@@ -181,7 +209,15 @@ DdlFlowSendApplication::SendPacket()
 {
     NS_LOG_FUNCTION(this);
 
-    SendFragmentPacket();
+    m_parentDdlApp->flowSent(m_flowid);
+    if (m_intraHostRate.GetBitRate() > 0)
+    {
+        SendIntraHost();
+    }
+    else
+    {
+        SendFragmentPacket();
+    }
 
     detailedLog(" Send packet " + std::to_string(m_commsize) + " bytes");
     m_send_cnt++;
@@ -40,6 +40,18 @@ class DdlFlowSendApplication : public SourceApplication
         m_parentDdlApp = parentDdlApp;
     }
 
+    // the tos of the next sends, pushed by the parent app
+    void setFlowTos(uint8_t flowTos)
+    {
+        m_flowTos = flowTos;
+    }
+
+    // the recv flow of an intra-host transfer, the parent app delivers the bytes to it
+    void setIntraHostRecvFlowId(uint32_t recvFlowId)
+    {
+        m_intraHostRecvFlowId = recvFlowId;
+    }
+
   private:
     void StartApplication() override;
     void StopApplication() override;
@@ -50,6 +62,8 @@ class DdlFlowSendApplication : public SourceApplication
     void HandleAck(Ptr<Socket> socket);
     // send the fragment packets to avoid the overflow of somewhere
     void SendFragmentPacket();
+    // an intra-host transfer reaches the recv at once after its transfer time, without packets
+    void SendIntraHost();
     void detailedLog(std::string info);
 
     // connection related params
@@ -84,6 +98,11 @@ class DdlFlowSendApplication : public SourceApplication
     uint32_t m_startTime;
 
     DdlApplication* m_parentDdlApp;
+    uint8_t m_flowTos;
+
+    // 0 if the flow goes through the fabric
+    DataRate m_intraHostRate;
+    uint32_t m_intraHostRecvFlowId;
 };
 
 } // namespace ns3
@@ -0,0 +1,72 @@
+#include "ddl-placement-score.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// the excess of a link over its time, weighted by the load it stretches
+static inline double
+linkExcess(double load)
+{
+    return load * max(0.0, load - 1.0);
+}
+
+DdlPlacementScorer::DdlPlacementScorer(uint32_t linkNum)
+    : m_jobNum(0),
+      m_load(linkNum, 0),
+      m_candidateLoad(linkNum, 0),
+      m_excessSum(0)
+{
+}
+
+void
+DdlPlacementScorer::addJob(float iterTime, const vector<pair<uint32_t, float>>& linkComm)
+{
+    m_jobNum++;
+    if (iterTime <= 0)
+    {
+        return;
+    }
+    for (const auto& [linkId, commTime] : linkComm)
+    {
+        m_load[linkId] += commTime / iterTime;
+    }
+}
+
+void
+DdlPlacementScorer::prepare()
+{
+    // a plain loop over the links, the compiler vectorizes it
+    double excessSum = 0;
+    const double* load = m_load.data();
+    for (size_t i = 0; i < m_load.size(); i++)
+    {
+        excessSum += linkExcess(load[i]);
+    }
+    m_excessSum = excessSum;
+}
+
+double
+DdlPlacementScorer::score(float iterTime, const vector<pair<uint32_t, float>>& linkComm)
+{
+    if (iterTime > 0)
+    {
+        for (const auto& [linkId, commTime] : linkComm)
+        {
+            m_candidateLoad[linkId] += commTime / iterTime;
+        }
+    }
+    // only the links of the candidate change, a link used twice is counted once
+    double excessSum = m_excessSum;
+    for (const auto& [linkId, commTime] : linkComm)
+    {
+        double added = m_candidateLoad[linkId];
+        if (added == 0)
+        {
+            continue;
+        }
+        excessSum += linkExcess(m_load[linkId] + added) - linkExcess(m_load[linkId]);
+        m_candidateLoad[linkId] = 0;
+    }
+    return (m_jobNum + 1 + excessSum) / (m_jobNum + 1);
+}
@@ -0,0 +1,40 @@
+#ifndef DDL_PLACEMENT_SCORE_H
+#define DDL_PLACEMENT_SCORE_H
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// scores the candidate placements of an arriving job by the slowdown they cause,
+// with the link-scale model of JFP: a link asked for more than its time by the jobs
+// stretches the comm of every job on it by its load
+//
+// a job of contention-free iteration time T = sum(comp + comm) of its flows puts a load of
+// comm / T on each link of its flows, its slowdown is
+// 1 + sum over its links of comm / T * (max(1, load) - 1)
+// so the slowdown summed over the jobs is jobNum + sum over the links of
+// load * max(0, load - 1), and a candidate only changes the terms of its own links
+class DdlPlacementScorer
+{
+  public:
+    explicit DdlPlacementScorer(uint32_t linkNum);
+
+    // a running job, linkComm holds (linkId, comm time) of its flows on each of their links,
+    // times in ms
+    void addJob(float iterTime, const vector<pair<uint32_t, float>>& linkComm);
+    // sum the terms of the running jobs, call it once they are added
+    void prepare();
+    // the mean slowdown of the running jobs and of the job placed on linkComm
+    double score(float iterTime, const vector<pair<uint32_t, float>>& linkComm);
+
+  private:
+    uint32_t m_jobNum;
+    // linkId -> busy fraction asked by the running jobs
+    vector<double> m_load;
+    // the load the candidate adds to each link, zero between two scores
+    vector<double> m_candidateLoad;
+    double m_excessSum;
+};
+
+#endif // DDL_PLACEMENT_SCORE_H
@@ -0,0 +1,231 @@
+#include "ddl-telemetry.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+
+using namespace std;
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("DdlFabricTelemetry");
+
+DdlFabricTelemetry::DdlFabricTelemetry(string filename,
+                                       Time interval,
+                                       uint64_t blockBytes,
+                                       uint32_t bandNum)
+    : m_filename(filename),
+      m_interval(interval),
+      m_blockBytes(blockBytes),
+      m_chunkSamples(0),
+      m_bandNum(bandNum),
+      m_sampleCnt(0),
+      m_blockStartNs(0),
+      m_writeSampleCnt(0),
+      m_writeStartNs(0),
+      m_writePending(false),
+      m_writerStop(false),
+      m_finished(false)
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(blockBytes == 0, "blockBytes must be positive");
+}
+
+DdlFabricTelemetry::~DdlFabricTelemetry()
+{
+    NS_LOG_FUNCTION(this);
+    finish();
+}
+
+void
+DdlFabricTelemetry::addLink(Ptr<NetDevice> device, DdlLinkKind kind, uint32_t from, uint32_t to)
+{
+    NS_LOG_FUNCTION(this);
+    LinkProbe probe;
+    Ptr<TrafficControlLayer> tc = device->GetNode()->GetObject<TrafficControlLayer>();
+    probe.rootQueueDisc = tc ? tc->GetRootQueueDiscOnDevice(device) : nullptr;
+    Ptr<PointToPointNetDevice> p2pDevice = DynamicCast<PointToPointNetDevice>(device);
+    probe.deviceQueue = p2pDevice ? p2pDevice->GetQueue() : nullptr;
+    DataRateValue dataRate;
+    device->GetAttribute("DataRate", dataRate);
+    probe.kind = kind;
+    probe.from = from;
+    probe.to = to;
+    probe.dataRate = dataRate.Get().GetBitRate();
+    probe.lastSentBytes = 0;
+    probe.lastDrops = 0;
+    m_links.push_back(probe);
+}
+
+bool
+DdlFabricTelemetry::start(Time stopTime)
+{
+    NS_LOG_FUNCTION(this);
+    m_stopTime = stopTime;
+    m_file.open(m_filename, ios::binary);
+    if (!m_file.is_open())
+    {
+        return false;
+    }
+    // the samples of every link fill one block, at least one sample per block
+    uint64_t sampleBytes =
+        m_links.size() * (sizeof(uint64_t) + (1 + m_bandNum) * sizeof(uint32_t));
+    m_chunkSamples = max<uint64_t>(1, m_blockBytes / max<uint64_t>(1, sampleBytes));
+    NS_LOG_INFO("Fabric telemetry block of " << m_chunkSamples << " samples");
+    // preallocate both blocks, the sampler never allocates afterwards
+    m_txBlock.assign(m_links.size() * m_chunkSamples, 0);
+    m_writeTxBlock.assign(m_txBlock.size(), 0);
+    m_block.assign((1 + m_bandNum) * m_links.size() * m_chunkSamples, 0);
+    m_writeBlock.assign(m_block.size(), 0);
+    writeHeader();
+    m_writer = thread(&DdlFabricTelemetry::writerLoop, this);
+    Simulator::Schedule(m_interval, &DdlFabricTelemetry::sample, this);
+    Simulator::ScheduleDestroy(&DdlFabricTelemetry::finish, this);
+    return true;
+}
+
+void
+DdlFabricTelemetry::writeHeader()
+{
+    uint32_t linkNum = m_links.size();
+    uint32_t version = 2;
+    uint64_t intervalNs = m_interval.GetNanoSeconds();
+    m_file.write("DDLT", 4);
+    m_file.write((char*)&version, sizeof(version));
+    m_file.write((char*)&linkNum, sizeof(linkNum));
+    m_file.write((char*)&m_bandNum, sizeof(m_bandNum));
+    m_file.write((char*)&m_chunkSamples, sizeof(m_chunkSamples));
+    m_file.write((char*)&intervalNs, sizeof(intervalNs));
+    for (const auto& link : m_links)
+    {
+        uint32_t kind = static_cast<uint32_t>(link.kind);
+        m_file.write((char*)&kind, sizeof(kind));
+        m_file.write((char*)&link.from, sizeof(link.from));
+        m_file.write((char*)&link.to, sizeof(link.to));
+        m_file.write((char*)&link.dataRate, sizeof(link.dataRate));
+    }
+}
+
+void
+DdlFabricTelemetry::sample()
+{
+    if (m_sampleCnt == 0)
+    {
+        m_blockStartNs = Simulator::Now().GetNanoSeconds();
+    }
+    for (uint32_t i = 0; i < m_links.size(); i++)
+    {
+        LinkProbe& link = m_links[i];
+        uint64_t sentBytes = 0;
+        uint64_t drops = 0;
+        if (link.rootQueueDisc)
+        {
+            const QueueDisc::Stats& stats = link.rootQueueDisc->GetStats();
+            sentBytes = stats.nTotalSentBytes;
+            drops = stats.nTotalDroppedPackets;
+            // the bands of the prio queue disc, one child queue disc per class
+            uint32_t classNum = link.rootQueueDisc->GetNQueueDiscClasses();
+            for (uint32_t band = 0; band < m_bandNum; band++)
+            {
+                column(1 + band, i) =
+                    band < classNum
+                        ? link.rootQueueDisc->GetQueueDiscClass(band)->GetQueueDisc()->GetNBytes()
+                        : 0;
+            }
+        }
+        if (link.deviceQueue)
+        {
+            drops += link.deviceQueue->GetTotalDroppedPackets();
+        }
+        txBytesColumn(i) = sentBytes - link.lastSentBytes;
+        column(0, i) = drops - link.lastDrops;
+        link.lastSentBytes = sentBytes;
+        link.lastDrops = drops;
+    }
+    m_sampleCnt++;
+    if (m_sampleCnt == m_chunkSamples)
+    {
+        flushBlock();
+    }
+    if (Simulator::Now() + m_interval <= m_stopTime)
+    {
+        Simulator::Schedule(m_interval, &DdlFabricTelemetry::sample, this);
+    }
+}
+
+void
+DdlFabricTelemetry::flushBlock()
+{
+    if (m_sampleCnt == 0)
+    {
+        return;
+    }
+    unique_lock lock(m_writeMutex);
+    // only wait when the writer is still busy with the previous block
+    m_writeCv.wait(lock, [this] { return !m_writePending; });
+    m_txBlock.swap(m_writeTxBlock);
+    m_block.swap(m_writeBlock);
+    m_writeSampleCnt = m_sampleCnt;
+    m_writeStartNs = m_blockStartNs;
+    m_writePending = true;
+    m_sampleCnt = 0;
+    m_writeCv.notify_all();
+}
+
+void
+DdlFabricTelemetry::writerLoop()
+{
+    unique_lock lock(m_writeMutex);
+    while (true)
+    {
+        m_writeCv.wait(lock, [this] { return m_writePending || m_writerStop; });
+        if (m_writePending)
+        {
+            // the sampler only touches the block after m_writePending is cleared
+            lock.unlock();
+            m_file.write((char*)&m_writeSampleCnt, sizeof(m_writeSampleCnt));
+            m_file.write((char*)&m_writeStartNs, sizeof(m_writeStartNs));
+            for (uint32_t c = 0; c < m_links.size(); c++)
+            {
+                m_file.write((char*)&m_writeTxBlock[c * m_chunkSamples],
+                             m_writeSampleCnt * sizeof(uint64_t));
+            }
+            uint32_t columnNum = (1 + m_bandNum) * m_links.size();
+            for (uint32_t c = 0; c < columnNum; c++)
+            {
+                m_file.write((char*)&m_writeBlock[c * m_chunkSamples],
+                             m_writeSampleCnt * sizeof(uint32_t));
+            }
+            lock.lock();
+            m_writePending = false;
+            m_writeCv.notify_all();
+        }
+        else if (m_writerStop)
+        {
+            return;
+        }
+    }
+}
+
+void
+DdlFabricTelemetry::finish()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_finished || !m_writer.joinable())
+    {
+        return;
+    }
+    m_finished = true;
+    flushBlock();
+    {
+        unique_lock lock(m_writeMutex);
+        m_writerStop = true;
+        m_writeCv.notify_all();
+    }
+    m_writer.join();
+    m_file.close();
+    NS_LOG_INFO("Fabric telemetry of " << m_links.size() << " links written to " << m_filename);
+}
+
+} // namespace ns3
@@ -0,0 +1,124 @@
+#ifndef DDL_TELEMETRY_H
+#define DDL_TELEMETRY_H
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace ns3
+{
+
+// the kind of a sampled link direction
+enum class DdlLinkKind : uint32_t
+{
+    SPINE_TO_LEAF = 0,
+    LEAF_TO_SPINE = 1,
+    LEAF_TO_GPU = 2,
+    GPU_TO_LEAF = 3,
+    CORE_TO_SPINE = 4,
+    SPINE_TO_CORE = 5
+};
+
+// sample every link direction of the fabric at a fixed sim-time interval
+// each sample holds the bytes sent, the packets dropped and the queue bytes of every priority band
+// samples go to a preallocated columnar block, a full block is handed to a writer thread
+// the samples per block are derived from a byte budget per block, two blocks are allocated
+//
+// file layout, all little endian:
+//   header: "DDLT", version 2, linkNum, bandNum, chunkSamples (uint32), interval ns (uint64)
+//   link table: kind, from, to (uint32), data rate bps (uint64) per link
+//   chunks: sampleNum (uint32), first sample time ns (uint64), then the columns
+//           txBytes[link][sample] (uint64), drops[link][sample] (uint32),
+//           band b bytes[link][sample] (uint32) for each band
+class DdlFabricTelemetry
+{
+  public:
+    DdlFabricTelemetry(string filename, Time interval, uint64_t blockBytes, uint32_t bandNum);
+    ~DdlFabricTelemetry();
+
+    // must be called before start
+    void addLink(Ptr<NetDevice> device, DdlLinkKind kind, uint32_t from, uint32_t to);
+
+    // sample until stopTime, then flush and close the file
+    // return false if the file cannot be opened, nothing is sampled then
+    bool start(Time stopTime);
+    void finish();
+
+    uint32_t getLinkNum()
+    {
+        return m_links.size();
+    }
+
+    uint32_t getChunkSamples()
+    {
+        return m_chunkSamples;
+    }
+
+  private:
+    struct LinkProbe
+    {
+        Ptr<QueueDisc> rootQueueDisc;
+        Ptr<Queue<Packet>> deviceQueue;
+        DdlLinkKind kind;
+        uint32_t from;
+        uint32_t to;
+        uint64_t dataRate;
+        uint64_t lastSentBytes;
+        uint64_t lastDrops;
+    };
+
+    void sample();
+    void writeHeader();
+    // hand the current block to the writer thread
+    void flushBlock();
+    void writerLoop();
+
+    // field 0 is drops, field 1 + b the bytes of band b
+    uint32_t& column(uint32_t field, uint32_t link)
+    {
+        return m_block[(field * m_links.size() + link) * m_chunkSamples + m_sampleCnt];
+    }
+
+    uint64_t& txBytesColumn(uint32_t link)
+    {
+        return m_txBlock[link * m_chunkSamples + m_sampleCnt];
+    }
+
+    string m_filename;
+    ofstream m_file;
+    Time m_interval;
+    Time m_stopTime;
+    uint64_t m_blockBytes;
+    uint32_t m_chunkSamples;
+    uint32_t m_bandNum;
+    vector<LinkProbe> m_links;
+
+    // the block being filled by the sampler
+    vector<uint64_t> m_txBlock;
+    vector<uint32_t> m_block;
+    uint32_t m_sampleCnt;
+    uint64_t m_blockStartNs;
+
+    // the block being written by the writer thread
+    vector<uint64_t> m_writeTxBlock;
+    vector<uint32_t> m_writeBlock;
+    uint32_t m_writeSampleCnt;
+    uint64_t m_writeStartNs;
+    bool m_writePending;
+    bool m_writerStop;
+    mutex m_writeMutex;
+    condition_variable m_writeCv;
+    thread m_writer;
+
+    bool m_finished;
+};
+
+} // namespace ns3
+
+#endif // DDL_TELEMETRY_H
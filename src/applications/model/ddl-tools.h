@@ -127,6 +127,92 @@ duplicateMiddleElements(const std::vector<uint32_t>& input)
     return result;
 }
 
+// fuse chains of tiny zero-compute flows into their upstream flow
+// a flow joins the chain of its single upstream flow when it has no compute, is not larger than
+// maxFusedBytes, is not a first flow and continues the path of the chain: it starts at the gpu
+// the chain ends at (the ring placement g_i -> g_i+1) or uses the same (src, dst) gpu pair
+// the fused transfer goes from the src of the head to the dst of the tail, so a chain stops
+// before it would return to the gpu it starts at
+// return headFlowId -> [headFlowId, member1, member2, ...], an unfused flow is a chain of its own
+inline std::map<uint32_t, std::vector<uint32_t>>
+fuseSmallFlowChains(FlowFeatureMap& flowFeatures,
+                    std::map<uint32_t, std::pair<uint32_t, uint32_t>>& flowGpuPair,
+                    uint32_t maxFusedBytes)
+{
+    std::map<uint32_t, std::vector<uint32_t>> chains;
+    std::unordered_set<uint32_t> absorbed;
+
+    auto canAbsorb = [&](uint32_t cur, uint32_t next) {
+        auto& nextFeature = flowFeatures[next];
+        bool onPath = flowGpuPair[next].first == flowGpuPair[cur].second ||
+                      flowGpuPair[next] == flowGpuPair[cur];
+        return std::get<uint32_t>(nextFeature["comp_time"]) == 0 &&
+               std::get<uint32_t>(nextFeature["comm_size"]) <= maxFusedBytes &&
+               !std::get<bool>(nextFeature["first_flow"]) &&
+               std::get<std::vector<uint32_t>>(nextFeature["upstream"]).size() == 1 && onPath;
+    };
+    // a gpu sending to itself is kept as it is, a chain must not turn into one
+    auto closesRing = [&](uint32_t head, uint32_t tail) {
+        return flowGpuPair[tail].second == flowGpuPair[head].first &&
+               flowGpuPair[head].first != flowGpuPair[head].second;
+    };
+
+    for (const auto& [flowId, features] : flowFeatures)
+    {
+        if (absorbed.count(flowId))
+        {
+            continue;
+        }
+        std::vector<uint32_t> chain = {flowId};
+        uint32_t cur = flowId;
+        while (true)
+        {
+            auto& curFeature = flowFeatures[cur];
+            // the recv of a last flow stops the job, it must stay the tail of its chain
+            if (std::get<bool>(curFeature["last_flow"]))
+            {
+                break;
+            }
+            auto downstream = std::get<std::vector<uint32_t>>(curFeature["downstream"]);
+            if (downstream.size() != 1)
+            {
+                break;
+            }
+            uint32_t next = downstream[0];
+            if (next == flowId || absorbed.count(next) || !canAbsorb(cur, next))
+            {
+                break;
+            }
+            // the next flow may already head a chain built before, splice it
+            auto it = chains.find(next);
+            if (it != chains.end())
+            {
+                if (closesRing(flowId, it->second.back()))
+                {
+                    break;
+                }
+                for (auto member : it->second)
+                {
+                    chain.push_back(member);
+                    absorbed.insert(member);
+                }
+                chains.erase(it);
+                cur = chain.back();
+                continue;
+            }
+            if (closesRing(flowId, next))
+            {
+                break;
+            }
+            chain.push_back(next);
+            absorbed.insert(next);
+            cur = next;
+        }
+        chains[flowId] = chain;
+    }
+    return chains;
+}
+
 inline bool
 isAllTrue(std::map<uint32_t, bool>& m)
 {
@@ -17,15 +17,134 @@ namespace ns3
 {
 NS_LOG_COMPONENT_DEFINE("spineLeafTopo");
 
-spineLeafTopo::spineLeafTopo(string topoConfigFilename)
+DdlFabricConfig
+DdlFabricConfig::spineLeaf(uint32_t spineNum,
+                           uint32_t leafNum,
+                           uint32_t gpuNumPerLeaf,
+                           float spineLeafBandwidth,
+                           float leafGpuBandwidth)
+{
+    DdlFabricConfig config;
+    config.spineNum = spineNum;
+    config.leafNum = leafNum;
+    config.gpuNumPerLeaf = gpuNumPerLeaf;
+    config.spineLeafBandwidth = spineLeafBandwidth;
+    config.leafGpuBandwidth = leafGpuBandwidth;
+    return config;
+}
+
+DdlFabricConfig
+DdlFabricConfig::fatTree(uint32_t k, float bandwidth)
+{
+    if (k < 2 || k % 2 != 0)
+    {
+        cout << "A fat-tree needs an even k, got " << k << endl;
+        exit(0);
+    }
+    DdlFabricConfig config = spineLeaf(k / 2, k * k / 2, k / 2, bandwidth, bandwidth);
+    config.podNum = k;
+    config.coreNum = k * k / 4;
+    config.coreSpineBandwidth = bandwidth;
+    return config;
+}
+
+DdlFabricConfig
+DdlFabricConfig::clos(uint32_t podNum,
+                      uint32_t leafNumPerPod,
+                      uint32_t spineNumPerPod,
+                      uint32_t coreNum,
+                      uint32_t gpuNumPerLeaf,
+                      float leafGpuBandwidth,
+                      float oversubscription)
+{
+    if (spineNumPerPod == 0 || coreNum % spineNumPerPod != 0 || oversubscription <= 0)
+    {
+        cout << "A clos needs the cores to be a multiple of the spines of a pod, "
+                "and a positive oversubscription"
+             << endl;
+        exit(0);
+    }
+    // a leaf splits its gpus' bandwidth over its spines, a spine its leafs' over its cores
+    float spineLeafBandwidth =
+        gpuNumPerLeaf * leafGpuBandwidth / (spineNumPerPod * oversubscription);
+    DdlFabricConfig config = spineLeaf(spineNumPerPod,
+                                       podNum * leafNumPerPod,
+                                       gpuNumPerLeaf,
+                                       spineLeafBandwidth,
+                                       leafGpuBandwidth);
+    config.podNum = podNum;
+    config.coreNum = coreNum;
+    config.coreSpineBandwidth =
+        leafNumPerPod * spineLeafBandwidth / (coreNum / spineNumPerPod * oversubscription);
+    return config;
+}
+
+DdlFabricConfig
+DdlFabricConfig::railOptimized(uint32_t groupNum,
+                               uint32_t railNum,
+                               uint32_t hostNumPerGroup,
+                               uint32_t spineNum,
+                               float bandwidth,
+                               float nvlinkBandwidth)
+{
+    // the spines take all the bandwidth of the rails, the fabric is not oversubscribed
+    DdlFabricConfig config = spineLeaf(spineNum,
+                                       groupNum * railNum,
+                                       hostNumPerGroup,
+                                       bandwidth * hostNumPerGroup / spineNum,
+                                       bandwidth);
+    config.nvlinkGroupSize = railNum;
+    config.nvlinkBandwidth = nvlinkBandwidth;
+    config.railLayout = true;
+    return config;
+}
+
+string
+DdlLinkId::name() const
+{
+    switch (kind)
+    {
+    case DdlLinkKind::LEAF_TO_SPINE:
+        return "leaf-spine" + to_string(from) + "-" + to_string(to);
+    case DdlLinkKind::GPU_TO_LEAF:
+        return "gpu-leaf" + to_string(from) + "-" + to_string(to);
+    case DdlLinkKind::SPINE_TO_LEAF:
+        return "spine-leaf" + to_string(from) + "-" + to_string(to);
+    case DdlLinkKind::LEAF_TO_GPU:
+        return "leaf-gpu" + to_string(from) + "-" + to_string(to);
+    case DdlLinkKind::CORE_TO_SPINE:
+        return "core-spine" + to_string(from) + "-" + to_string(to);
+    case DdlLinkKind::SPINE_TO_CORE:
+        return "spine-core" + to_string(from) + "-" + to_string(to);
+    }
+    return "";
+}
+
+spineLeafTopo::spineLeafTopo(string topoConfigFilename, uint32_t partitionNum)
+    : m_partitionNum(partitionNum)
 {
     NS_LOG_FUNCTION(this);
     InitTopoConfig(topoConfigFilename);
+    Build();
+}
+
+spineLeafTopo::spineLeafTopo(const DdlFabricConfig& config, uint32_t partitionNum)
+    : m_partitionNum(partitionNum)
+{
+    NS_LOG_FUNCTION(this);
+    InitTopoConfig(config);
+    Build();
+}
+
+void
+spineLeafTopo::Build()
+{
     // create nodes and link them
     CreateNodes();
     SetupLink();
     // install device and netstack
     InstallSpineLeafLinks();
+    InstallCoreSpineLinks();
     InstallLeafGpuLinks();
     InstallInternetStack();
 
@@ -52,6 +171,7 @@ spineLeafTopo::InitTopoConfig(std::string topoConfigFilename)
         exit(0);
     }
 
+    DdlFabricConfig config;
     std::string line;
     std::getline(m_topoConfig, line); // 读取并跳过表头
     while (std::getline(m_topoConfig, line))
@@ -59,35 +179,192 @@ spineLeafTopo::InitTopoConfig(std::string topoConfigFilename)
         std::stringstream ss(line);
         std::string token;
         std::getline(ss, token, ',');
-        m_spineNum = std::stoi(token);
+        config.spineNum = std::stoi(token);
         std::getline(ss, token, ',');
-        m_leafNum = std::stoi(token);
+        config.leafNum = std::stoi(token);
         std::getline(ss, token, ',');
-        m_gpuNumPerLeaf = std::stoi(token);
+        config.gpuNumPerLeaf = std::stoi(token);
         std::getline(ss, token, ',');
-        m_spineLeafBandwidth = std::stof(token);
+        config.spineLeafBandwidth = std::stof(token);
         std::getline(ss, token, ',');
-        m_leafGpuBandwidth = std::stof(token);
+        config.leafGpuBandwidth = std::stof(token);
         std::getline(ss, token, ',');
-        m_loadBalanceStrategy = token;
+        config.loadBalance = token;
+        // the nvlink and the tier columns may be missing in the older configs:
+        // nvlink_group_size,nvlink_bandwidth,pod_num,core_num,core_spine_bandwidth,layout
+        if (std::getline(ss, token, ',') && !token.empty())
+        {
+            config.nvlinkGroupSize = std::stoi(token);
+        }
+        if (std::getline(ss, token, ',') && !token.empty())
+        {
+            config.nvlinkBandwidth = std::stof(token);
+        }
+        if (std::getline(ss, token, ',') && !token.empty())
+        {
+            config.podNum = std::stoi(token);
+        }
+        if (std::getline(ss, token, ',') && !token.empty())
+        {
+            config.coreNum = std::stoi(token);
+        }
+        if (std::getline(ss, token, ',') && !token.empty())
+        {
+            config.coreSpineBandwidth = std::stof(token);
+        }
+        if (std::getline(ss, token, ',') && !token.empty())
+        {
+            config.railLayout = token == "rail";
+        }
     }
     m_topoConfig.close();
+    InitTopoConfig(config);
+}
+
+void
+spineLeafTopo::InitTopoConfig(const DdlFabricConfig& config)
+{
+    m_podNum = config.podNum;
+    m_spineNum = config.spineNum;
+    m_leafNum = config.leafNum;
+    m_gpuNumPerLeaf = config.gpuNumPerLeaf;
+    m_coreNum = config.coreNum;
+    m_spineLeafBandwidth = config.spineLeafBandwidth;
+    m_leafGpuBandwidth = config.leafGpuBandwidth;
+    m_coreSpineBandwidth = config.coreSpineBandwidth;
+    m_loadBalanceStrategy = config.loadBalance;
+    m_nvlinkGroupSize = config.nvlinkGroupSize;
+    m_nvlinkBandwidth = config.nvlinkBandwidth;
+    m_railLayout = config.railLayout;
+    if (m_podNum == 0 || m_spineNum == 0 || m_gpuNumPerLeaf == 0 || m_leafNum == 0 ||
+        m_leafNum % m_podNum != 0)
+    {
+        cout << "The leafs must be split evenly over the pods, and every tier be non empty"
+             << endl;
+        exit(0);
+    }
+    if (m_podNum > 1 && m_coreNum == 0)
+    {
+        cout << "The pods need cores to reach each other" << endl;
+        exit(0);
+    }
+    if (m_coreNum % m_spineNum != 0 || (m_coreNum > 0 && m_coreSpineBandwidth <= 0))
+    {
+        cout << "The cores must be a multiple of the spines of a pod, with a bandwidth" << endl;
+        exit(0);
+    }
+    if (m_nvlinkGroupSize > 0 && m_nvlinkBandwidth <= 0)
+    {
+        cout << "The nvlink groups need a nvlink bandwidth" << endl;
+        exit(0);
+    }
+    if (m_railLayout && (m_nvlinkGroupSize == 0 || m_leafNum / m_podNum % m_nvlinkGroupSize))
+    {
+        cout << "The rails of a host are nvlink_group_size leafs of one pod" << endl;
+        exit(0);
+    }
+    // the smallest block of 10.0.0.0/8 holding a /30 subnet per gpu of the leaf
+    m_leafGpuBlockPrefix = 30;
+    while ((1u << (32 - m_leafGpuBlockPrefix)) < m_gpuNumPerLeaf * 4)
+    {
+        m_leafGpuBlockPrefix--;
+    }
+    // the cores route to a pod with one prefix, so its leaf blocks span a power of two
+    m_leafSlotsPerPod = m_leafNum / m_podNum;
+    if (m_coreNum > 0)
+    {
+        m_leafSlotsPerPod = 1;
+        while (m_leafSlotsPerPod < m_leafNum / m_podNum)
+        {
+            m_leafSlotsPerPod *= 2;
+        }
+    }
+    if ((uint64_t)m_podNum * m_leafSlotsPerPod << (32 - m_leafGpuBlockPrefix) > (1u << 24))
+    {
+        cout << "Too many gpus to address in 10.0.0.0/8" << endl;
+        exit(0);
+    }
+    // a /30 subnet per switch link
+    if ((uint64_t)m_spineNum * m_leafNum + m_coreNum * m_podNum > (1u << 18))
+    {
+        cout << "Too many switch links to address in 172.16.0.0/12" << endl;
+        exit(0);
+    }
     printColoredText("************Spine-Leaf Topo Config************", "blue");
-    printColoredText("Spine Num: " + to_string(m_spineNum), "green");
+    if (m_coreNum > 0)
+    {
+        printColoredText("Pod Num: " + to_string(m_podNum), "green");
+        printColoredText("Core Num: " + to_string(m_coreNum), "green");
+        printColoredText("Core-Spine Bandwidth: " + to_string(m_coreSpineBandwidth) + "MBps",
+                         "green");
+    }
+    printColoredText("Spine Num: " + to_string(getSpineNum()), "green");
     printColoredText("Leaf Num: " + to_string(m_leafNum), "green");
     printColoredText("GPU Num Per Leaf: " + to_string(m_gpuNumPerLeaf), "green");
     printColoredText("Spine-Leaf Bandwidth: " + to_string(m_spineLeafBandwidth) + "MBps", "green");
     printColoredText("Leaf-GPU Bandwidth: " + to_string(m_leafGpuBandwidth) + "MBps", "green");
     printColoredText("Load Balance Strategy: " + m_loadBalanceStrategy, "green");
+    if (m_nvlinkGroupSize > 0)
+    {
+        printColoredText("NVLink Group Size: " + to_string(m_nvlinkGroupSize) +
+                             (m_railLayout ? ", one gpu per rail leaf" : ""),
+                         "green");
+        printColoredText("NVLink Bandwidth: " + to_string(m_nvlinkBandwidth) + "MBps", "green");
+    }
 }
 
 void
 spineLeafTopo::CreateNodes()
 {
     NS_LOG_FUNCTION(this);
-    m_spineNodes.Create(m_spineNum);
-    m_leafNodes.Create(m_leafNum);
-    m_gpuNodes.Create(m_leafNum * m_gpuNumPerLeaf);
+    // with a parallel simulator a leaf and its gpus run in the partition of the leaf,
+    // the spines are spread over the partitions, so only the spine-leaf links cross them
+    string simulatorType = Simulator::GetImplementation()->GetInstanceTypeId().GetName();
+    bool distributed = simulatorType == "ns3::DistributedSimulatorImpl" ||
+                       simulatorType == "ns3::NullMessageSimulatorImpl";
+    m_partitioned =
+        distributed ||
+        DynamicCast<MultithreadedSimulatorImpl>(Simulator::GetImplementation()) != nullptr;
+    if (m_partitioned && m_partitionNum == 0)
+    {
+        if (distributed)
+        {
+            cout << "The MPI simulator needs the number of ranks as partitionNum" << endl;
+            exit(0);
+        }
+        m_partitionNum = m_leafNum;
+    }
+    if (distributed && m_podNum > 1)
+    {
+        // the coordinator is a spine of pod 0, the other pods have no link to it
+        cout << "The MPI simulator only runs the fabrics of a single pod" << endl;
+        exit(0);
+    }
+    // the cores come first, so the gpus keep the last, consecutive node ids
+    for (uint32_t i = 0; i < m_coreNum; ++i)
+    {
+        m_coreNodes.Create(1, getCoreSystemId(i));
+    }
+    for (uint32_t i = 0; i < getSpineNum(); ++i)
+    {
+        m_spineNodes.Create(1, getSpineSystemId(i));
+    }
+    for (uint32_t i = 0; i < m_leafNum; ++i)
+    {
+        m_leafNodes.Create(1, getLeafSystemId(i));
+    }
+    for (uint32_t i = 0; i < m_leafNum * m_gpuNumPerLeaf; ++i)
+    {
+        m_gpuNodes.Create(1, getGpuSystemId(i));
+        m_gpuNodeIds.push_back(m_gpuNodes.Get(i)->GetId());
+    }
+    m_coordinatorNodeId = m_spineNodes.Get(0)->GetId();
+    if (m_partitioned)
+    {
+        printColoredText("Partitions: " + to_string(min(m_partitionNum, m_leafNum)) +
+                             ", leafs spread by id",
+                         "green");
+    }
     for (uint32_t i = 0; i < m_leafNum * m_gpuNumPerLeaf; ++i)
     {
         m_freeNodeIndex.push_back(i);
@@ -100,7 +377,11 @@ spineLeafTopo::SetupLink()
     NS_LOG_FUNCTION(this);
     m_spineLeafLink.SetDeviceAttribute("DataRate",
                                        StringValue(to_string(m_spineLeafBandwidth) + "MBps"));
-    m_spineLeafLink.SetChannelAttribute("Delay", StringValue("0ms"));
+    // the spine-leaf delay is the lookahead of the partitions, it cannot be zero
+    m_spineLeafLink.SetChannelAttribute("Delay", StringValue(m_partitioned ? "1us" : "0ms"));
+    m_coreSpineLink.SetDeviceAttribute("DataRate",
+                                       StringValue(to_string(m_coreSpineBandwidth) + "MBps"));
+    m_coreSpineLink.SetChannelAttribute("Delay", StringValue(m_partitioned ? "1us" : "0ms"));
     m_leafGpuLink.SetDeviceAttribute("DataRate",
                                      StringValue(to_string(m_leafGpuBandwidth) + "MBps"));
     m_leafGpuLink.SetChannelAttribute("Delay", StringValue("0ms"));
@@ -110,21 +391,34 @@ void
 spineLeafTopo::InstallSpineLeafLinks()
 {
     NS_LOG_FUNCTION(this);
-    m_spineLeafDevices.resize(m_spineNum, std::vector<NetDeviceContainer>(m_leafNum));
+    // a spine links to every leaf of its pod
+    uint32_t leafNumPerPod = m_leafNum / m_podNum;
+    m_spineLeafDevices.resize(getSpineNum(), std::vector<NetDeviceContainer>(leafNumPerPod));
     uint32_t spineIndex = 0;
     for (auto spineNode = m_spineNodes.Begin(); spineNode != m_spineNodes.End();
          ++spineNode, ++spineIndex)
     {
+        uint32_t firstLeaf = spineIndex / m_spineNum * leafNumPerPod;
+        for (uint32_t leafIndex = 0; leafIndex < leafNumPerPod; ++leafIndex)
         {
-            uint32_t leafIndex = 0;
-            for (auto leafNode = m_leafNodes.Begin(); leafNode != m_leafNodes.End();
-                 ++leafNode, ++leafIndex)
-            {
-                NetDeviceContainer spineLeafDevice = m_spineLeafLink.Install(*spineNode, *leafNode);
-                m_spineLeafDevices[spineIndex][leafIndex] = spineLeafDevice;
-                Ptr<NetDevice> d = spineLeafDevice.Get(0);
-                Ptr<Node> n = d->GetNode();
-            }
+            m_spineLeafDevices[spineIndex][leafIndex] =
+                m_spineLeafLink.Install(*spineNode, m_leafNodes.Get(firstLeaf + leafIndex));
+        }
+    }
+}
+
+void
+spineLeafTopo::InstallCoreSpineLinks()
+{
+    NS_LOG_FUNCTION(this);
+    m_coreSpineDevices.resize(m_coreNum, std::vector<NetDeviceContainer>(m_podNum));
+    for (uint32_t i = 0; i < m_coreNum; ++i)
+    {
+        for (uint32_t j = 0; j < m_podNum; ++j)
+        {
+            m_coreSpineDevices[i][j] =
+                m_coreSpineLink.Install(m_coreNodes.Get(i),
+                                        m_spineNodes.Get(getPodSpine(j, i % m_spineNum)));
         }
     }
 }
@@ -179,11 +473,18 @@ spineLeafTopo::InitQueueDisp()
 void
 spineLeafTopo::ConfigureQueueDisp()
 {
-    for (uint32_t i = 0; i < m_spineNum; ++i)
+    for (auto& spineDevices : m_spineLeafDevices)
     {
-        for (uint32_t j = 0; j < m_leafNum; ++j)
+        for (auto& devices : spineDevices)
         {
-            m_queueDisp.Install(m_spineLeafDevices[i][j]);
+            m_queueDisp.Install(devices);
+        }
+    }
+    for (auto& coreDevices : m_coreSpineDevices)
+    {
+        for (auto& devices : coreDevices)
+        {
+            m_queueDisp.Install(devices);
         }
     }
     for (uint32_t i = 0; i < m_leafNum; ++i)
@@ -200,33 +501,318 @@ spineLeafTopo::AssignIpAddresses()
 {
     NS_LOG_FUNCTION(this);
     Ipv4AddressHelper ipHelper;
-    m_spineLeafInterfaces.resize(m_spineNum, std::vector<Ipv4InterfaceContainer>(m_leafNum));
+    m_spineLeafInterfaces.resize(getSpineNum(),
+                                 std::vector<Ipv4InterfaceContainer>(m_leafNum / m_podNum));
+    m_coreSpineInterfaces.resize(m_coreNum, std::vector<Ipv4InterfaceContainer>(m_podNum));
     m_leafGpuInterfaces.resize(m_leafNum, std::vector<Ipv4InterfaceContainer>(m_gpuNumPerLeaf));
 
-    for (uint32_t i = 0; i < m_spineNum; ++i)
+    // spine-leaf links, then core-spine links, are /30 subnets taken one by one
+    // from 172.16.0.0/12
+    ipHelper.SetBase("172.16.0.0", "255.255.255.252");
+    for (uint32_t i = 0; i < getSpineNum(); ++i)
     {
-        for (uint32_t j = 0; j < m_leafNum; ++j)
+        for (uint32_t j = 0; j < m_leafNum / m_podNum; ++j)
         {
             // cout << "Subnet between Spine " << i << " and Leaf " << j << ": " << endl;
-            // 一定要+1!!!
-            std::string subnet = "10." + std::to_string(i + 1) + "." + std::to_string(j + 1) + ".0";
-            ipHelper.SetBase(subnet.c_str(), "255.255.255.0");
             m_spineLeafInterfaces[i][j] = ipHelper.Assign(m_spineLeafDevices[i][j]);
+            ipHelper.NewNetwork();
+        }
+    }
+    for (uint32_t i = 0; i < m_coreNum; ++i)
+    {
+        for (uint32_t j = 0; j < m_podNum; ++j)
+        {
+            m_coreSpineInterfaces[i][j] = ipHelper.Assign(m_coreSpineDevices[i][j]);
+            ipHelper.NewNetwork();
         }
     }
 
+    // each leaf owns a block of 10.0.0.0/8, its gpus are /30 subnets inside the block,
+    // so the spines route to a leaf with one prefix instead of one route per gpu
     for (uint32_t i = 0; i < m_leafNum; ++i)
     {
         for (uint32_t j = 0; j < m_gpuNumPerLeaf; ++j)
         {
             // cout << "Subnet between Leaf " << i << " and GPU " << j << ": " << endl;
-            // 一定要加1!!!
-            std::string subnet = "192.168." + std::to_string(i * m_gpuNumPerLeaf + j + 1) + ".0";
-            ipHelper.SetBase(subnet.c_str(), "255.255.255.0");
+            Ipv4Address subnet(getLeafGpuBlock(i).Get() + j * 4);
+            ipHelper.SetBase(subnet, "255.255.255.252");
 
             m_leafGpuInterfaces[i][j] = ipHelper.Assign(m_leafGpuDevices[i][j]);
+            m_gpuAddresses.push_back(m_leafGpuInterfaces[i][j].GetAddress(1));
+        }
+        // only the leafs of pod 0 link to the coordinator
+        m_coordinatorAddresses.push_back(getLeafPod(i) == 0
+                                             ? m_spineLeafInterfaces[0][i].GetAddress(0)
+                                             : Ipv4Address());
+    }
+}
+
+uint32_t
+spineLeafTopo::getGpuIndexOfNode(uint32_t nodeId)
+{
+    // the gpu nodes are created last, with consecutive ids
+    if (m_gpuNodeIds.empty() || nodeId < m_gpuNodeIds[0] || nodeId - m_gpuNodeIds[0] >= getGpuNum())
+    {
+        return getGpuNum();
+    }
+    return nodeId - m_gpuNodeIds[0];
+}
+
+uint32_t
+spineLeafTopo::getGpuHost(uint32_t gpuIndex)
+{
+    uint32_t leafId = getGpuLeaf(gpuIndex);
+    if (m_railLayout)
+    {
+        // the gpus of a host sit at the same position of the rail leafs of its group
+        return leafId / m_nvlinkGroupSize * m_gpuNumPerLeaf + gpuIndex % m_gpuNumPerLeaf;
+    }
+    // without nvlink a host holds a single gpu
+    uint32_t groupSize = max(m_nvlinkGroupSize, 1u);
+    uint32_t hostNumPerLeaf = (m_gpuNumPerLeaf + groupSize - 1) / groupSize;
+    return leafId * hostNumPerLeaf + gpuIndex % m_gpuNumPerLeaf / groupSize;
+}
+
+DataRate
+spineLeafTopo::getIntraHostRate(uint32_t srcGpu, uint32_t dstGpu)
+{
+    // without nvlink a gpu sends to itself at the rate of its own link
+    float bandwidth = m_nvlinkGroupSize > 0 ? m_nvlinkBandwidth : m_leafGpuBandwidth;
+    bool sameGroup = m_nvlinkGroupSize > 1 && getGpuHost(srcGpu) == getGpuHost(dstGpu);
+    if (srcGpu != dstGpu && !sameGroup)
+    {
+        return DataRate(0);
+    }
+    return DataRate(static_cast<uint64_t>(bandwidth * 8e6));
+}
+
+Ipv4Address
+spineLeafTopo::getLeafGpuBlock(uint32_t leafId)
+{
+    uint32_t slot = getLeafPod(leafId) * m_leafSlotsPerPod + leafId % (m_leafNum / m_podNum);
+    return Ipv4Address(Ipv4Address("10.0.0.0").Get() + (slot << (32 - m_leafGpuBlockPrefix)));
+}
+
+DdlLinkId
+spineLeafTopo::getLeafUplink(uint32_t leafId)
+{
+    return {DdlLinkKind::LEAF_TO_SPINE, leafId, m_leafSpineMap[leafId]};
+}
+
+vector<DdlLinkId>
+spineLeafTopo::getLinkIds()
+{
+    vector<DdlLinkId> linkIds;
+    for (uint32_t i = 0; i < m_coreNum; ++i)
+    {
+        for (uint32_t j = 0; j < m_podNum; ++j)
+        {
+            uint32_t spineId = getPodSpine(j, i % m_spineNum);
+            linkIds.push_back({DdlLinkKind::CORE_TO_SPINE, i, spineId});
+            linkIds.push_back({DdlLinkKind::SPINE_TO_CORE, spineId, i});
         }
     }
+    for (uint32_t i = 0; i < getSpineNum(); ++i)
+    {
+        for (uint32_t j = 0; j < m_leafNum / m_podNum; ++j)
+        {
+            uint32_t leafId = i / m_spineNum * (m_leafNum / m_podNum) + j;
+            linkIds.push_back({DdlLinkKind::SPINE_TO_LEAF, i, leafId});
+            linkIds.push_back({DdlLinkKind::LEAF_TO_SPINE, leafId, i});
+        }
+    }
+    for (uint32_t i = 0; i < getGpuNum(); ++i)
+    {
+        linkIds.push_back({DdlLinkKind::LEAF_TO_GPU, getGpuLeaf(i), i});
+        linkIds.push_back({DdlLinkKind::GPU_TO_LEAF, i, getGpuLeaf(i)});
+    }
+    return linkIds;
+}
+
+uint32_t
+spineLeafTopo::getLinkIndex(const DdlLinkId& linkId)
+{
+    // the same layout as getLinkIds: core-spine pairs, spine-leaf pairs, leaf-gpu pairs,
+    // the downward direction of a pair first
+    uint32_t leafNumPerPod = m_leafNum / m_podNum;
+    uint32_t spineLeafBase = 2 * m_coreNum * m_podNum;
+    uint32_t leafGpuBase = spineLeafBase + 2 * getSpineNum() * leafNumPerPod;
+    switch (linkId.kind)
+    {
+    case DdlLinkKind::CORE_TO_SPINE:
+        return 2 * (linkId.from * m_podNum + linkId.to / m_spineNum);
+    case DdlLinkKind::SPINE_TO_CORE:
+        return 2 * (linkId.to * m_podNum + linkId.from / m_spineNum) + 1;
+    case DdlLinkKind::SPINE_TO_LEAF:
+        return spineLeafBase + 2 * (linkId.from * leafNumPerPod + linkId.to % leafNumPerPod);
+    case DdlLinkKind::LEAF_TO_SPINE:
+        return spineLeafBase + 2 * (linkId.to * leafNumPerPod + linkId.from % leafNumPerPod) + 1;
+    case DdlLinkKind::LEAF_TO_GPU:
+        return leafGpuBase + 2 * linkId.to;
+    case DdlLinkKind::GPU_TO_LEAF:
+        return leafGpuBase + 2 * linkId.from + 1;
+    }
+    return getLinkNum();
+}
+
+DdlLinkKind
+spineLeafTopo::getLinkKind(uint32_t linkIndex)
+{
+    uint32_t spineLeafBase = 2 * m_coreNum * m_podNum;
+    uint32_t leafGpuBase = spineLeafBase + 2 * getSpineNum() * (m_leafNum / m_podNum);
+    bool up = linkIndex % 2 == 1;
+    if (linkIndex < spineLeafBase)
+    {
+        return up ? DdlLinkKind::SPINE_TO_CORE : DdlLinkKind::CORE_TO_SPINE;
+    }
+    if (linkIndex < leafGpuBase)
+    {
+        return up ? DdlLinkKind::LEAF_TO_SPINE : DdlLinkKind::SPINE_TO_LEAF;
+    }
+    return up ? DdlLinkKind::GPU_TO_LEAF : DdlLinkKind::LEAF_TO_GPU;
+}
+
+vector<uint32_t>
+spineLeafTopo::getPathLinks(uint32_t srcGpu, uint32_t dstGpu)
+{
+    vector<uint32_t> path;
+    if (srcGpu == dstGpu)
+    {
+        return path;
+    }
+    uint32_t srcLeaf = getGpuLeaf(srcGpu);
+    uint32_t dstLeaf = getGpuLeaf(dstGpu);
+    path.push_back(getLinkIndex(getGpuUplink(srcGpu)));
+    if (srcLeaf != dstLeaf)
+    {
+        uint32_t spineId = m_leafSpineMap[srcLeaf];
+        path.push_back(getLinkIndex({DdlLinkKind::LEAF_TO_SPINE, srcLeaf, spineId}));
+        uint32_t dstPod = getLeafPod(dstLeaf);
+        if (dstPod != getLeafPod(srcLeaf))
+        {
+            // the core goes down to the spine of the destination pod it links to
+            uint32_t coreId = m_spineCoreMap[spineId];
+            path.push_back(getLinkIndex({DdlLinkKind::SPINE_TO_CORE, spineId, coreId}));
+            spineId = getPodSpine(dstPod, coreId % m_spineNum);
+            path.push_back(getLinkIndex({DdlLinkKind::CORE_TO_SPINE, coreId, spineId}));
+        }
+        path.push_back(getLinkIndex({DdlLinkKind::SPINE_TO_LEAF, spineId, dstLeaf}));
+    }
+    path.push_back(getLinkIndex({DdlLinkKind::LEAF_TO_GPU, dstLeaf, dstGpu}));
+    return path;
+}
+
+Ptr<NetDevice>
+spineLeafTopo::getLinkSendDevice(const DdlLinkId& linkId)
+{
+    // the downward direction of a link is sent by its upper node, device 0
+    bool down = linkId.kind == DdlLinkKind::CORE_TO_SPINE ||
+                linkId.kind == DdlLinkKind::SPINE_TO_LEAF ||
+                linkId.kind == DdlLinkKind::LEAF_TO_GPU;
+    NetDeviceContainer devices = down ? getLinkDevices(linkId.kind, linkId.from, linkId.to)
+                                      : getLinkDevices(linkId.kind, linkId.to, linkId.from);
+    return devices.Get(down ? 0 : 1);
+}
+
+NetDeviceContainer
+spineLeafTopo::getLinkDevices(DdlLinkKind kind, uint32_t upper, uint32_t lower)
+{
+    switch (kind)
+    {
+    case DdlLinkKind::SPINE_TO_LEAF:
+    case DdlLinkKind::LEAF_TO_SPINE:
+        if (upper < getSpineNum() && lower < m_leafNum &&
+            getLeafPod(lower) == upper / m_spineNum)
+        {
+            return m_spineLeafDevices[upper][lower % (m_leafNum / m_podNum)];
+        }
+        break;
+    case DdlLinkKind::CORE_TO_SPINE:
+    case DdlLinkKind::SPINE_TO_CORE:
+        if (upper < m_coreNum && lower < getSpineNum() && lower % m_spineNum == upper % m_spineNum)
+        {
+            return getCoreSpineDevices(upper, lower);
+        }
+        break;
+    case DdlLinkKind::LEAF_TO_GPU:
+    case DdlLinkKind::GPU_TO_LEAF:
+        if (lower < getGpuNum() && getGpuLeaf(lower) == upper)
+        {
+            return m_leafGpuDevices[upper][lower % m_gpuNumPerLeaf];
+        }
+        break;
+    }
+    return NetDeviceContainer();
+}
+
+void
+spineLeafTopo::loadLinkConfig(string linkConfigFile)
+{
+    NS_LOG_FUNCTION(this << linkConfigFile);
+    ifstream file(linkConfigFile);
+    if (!file.is_open())
+    {
+        cerr << "Failed to open file: " << linkConfigFile << endl;
+        exit(0);
+    }
+    map<string, DdlLinkKind> linkKinds = {{"spine-leaf", DdlLinkKind::SPINE_TO_LEAF},
+                                          {"core-spine", DdlLinkKind::CORE_TO_SPINE},
+                                          {"leaf-gpu", DdlLinkKind::LEAF_TO_GPU}};
+    uint32_t linkNum = 0;
+    string line;
+    getline(file, line); // the header
+    while (getline(file, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        stringstream ss(line);
+        string kind;
+        string from;
+        string to;
+        string bandwidth;
+        string delay;
+        getline(ss, kind, ',');
+        getline(ss, from, ',');
+        getline(ss, to, ',');
+        getline(ss, bandwidth, ',');
+        getline(ss, delay, ',');
+        NetDeviceContainer devices;
+        if (linkKinds.count(kind) && !from.empty() && !to.empty())
+        {
+            devices = getLinkDevices(linkKinds[kind], stoi(from), stoi(to));
+        }
+        if (devices.GetN() == 0)
+        {
+            cout << "No fabric link for the row: " << line << endl;
+            exit(0);
+        }
+        if (!bandwidth.empty())
+        {
+            for (uint32_t i = 0; i < devices.GetN(); ++i)
+            {
+                devices.Get(i)->SetAttribute("DataRate", StringValue(bandwidth + "MBps"));
+            }
+        }
+        if (!delay.empty())
+        {
+            // the links between the partitions carry the lookahead
+            bool crossing = kind != "leaf-gpu" &&
+                            devices.Get(0)->GetNode()->GetSystemId() !=
+                                devices.Get(1)->GetNode()->GetSystemId();
+            if (crossing && Time(delay).IsZero())
+            {
+                cout << "A link between two partitions needs a delay: " << line << endl;
+                exit(0);
+            }
+            devices.Get(0)->GetChannel()->SetAttribute("Delay", StringValue(delay));
+        }
+        linkNum++;
+    }
+    printColoredText("Link config of " + to_string(linkNum) + " links read from " +
+                         linkConfigFile,
+                     "green");
 }
 
 void
@@ -257,11 +843,14 @@ spineLeafTopo::ConfigureRoute()
     mmap[1] = 1;
     mmap[2] = 0;
     mmap[3] = 1;
+    uint32_t leafNumPerPod = m_leafNum / m_podNum;
     // configure leaf default route, here various strategies can be used
     for (uint32_t i = 0; i < m_leafNum; ++i)
     {
         Ptr<Ipv4StaticRouting> staticRouting =
             staticRoutingHelper.GetStaticRouting(m_leafNodes.Get(i)->GetObject<Ipv4>());
+        // a leaf only links to the spines of its pod
+        uint32_t podId = getLeafPod(i);
 
         // UP direction
         if (m_loadBalanceStrategy == "to0")
@@ -272,18 +861,21 @@ spineLeafTopo::ConfigureRoute()
             // we will set it. Now all the traffic from the leaf will be routed to the spine[0]
             // the second 0 in GetAddress(0) means the first address in the subnet, that is the
             // first ip of the spine 0
-            Ipv4Address spineIp = m_spineLeafInterfaces[0][i].GetAddress(0);
+            uint32_t spineId = getPodSpine(podId, 0);
+            Ipv4Address spineIp = m_spineLeafInterfaces[spineId][i % leafNumPerPod].GetAddress(0);
             // we set it. interface index start from 1 not 0
             staticRouting->SetDefaultRoute(spineIp, 1);
+            m_leafSpineMap[i] = spineId;
         }
         else if (m_loadBalanceStrategy == "random")
         {
             // here we route the traffic to spine selected randomly
             uint32_t spineIndex = rand() % m_spineNum;
             // uint32_t spineIndex = mmap[i];
-            Ipv4Address spineIp = m_spineLeafInterfaces[spineIndex][i].GetAddress(0);
+            uint32_t spineId = getPodSpine(podId, spineIndex);
+            Ipv4Address spineIp = m_spineLeafInterfaces[spineId][i % leafNumPerPod].GetAddress(0);
             staticRouting->SetDefaultRoute(spineIp, spineIndex + 1);
-            m_leafSpineMap[i] = spineIndex;
+            m_leafSpineMap[i] = spineId;
         }
         else
         {
@@ -299,25 +891,55 @@ spineLeafTopo::ConfigureRoute()
     }
 
     // configure spine default route, decide the leaf to route through the dst ip
-    for (uint32_t i = 0; i < m_spineNum; ++i)
+    uint32_t coreNumPerSpine = m_coreNum / m_spineNum;
+    for (uint32_t i = 0; i < getSpineNum(); ++i)
     {
         Ipv4StaticRoutingHelper staticRoutingHelper;
-        Ptr<Ipv4StaticRouting> staticRouting =
-            staticRoutingHelper.GetStaticRouting(m_spineNodes.Get(i)->GetObject<Ipv4>());
-        // iter all the leaf's subnets
-        for (uint32_t j = 0; j < m_leafNum; ++j)
+        Ptr<Ipv4> ipv4 = m_spineNodes.Get(i)->GetObject<Ipv4>();
+        Ptr<Ipv4StaticRouting> staticRouting = staticRoutingHelper.GetStaticRouting(ipv4);
+        // iter all the leaf's gpu blocks of the pod
+        uint32_t podId = i / m_spineNum;
+        for (uint32_t j = 0; j < leafNumPerPod; ++j)
         {
             Ipv4Address leafIp = m_spineLeafInterfaces[i][j].GetAddress(1);
-            for (uint32_t k = 0; k < m_gpuNumPerLeaf; ++k)
-            {
-                Ipv4Address gpuIp = m_leafGpuInterfaces[j][k].GetAddress(1);
-                Ipv4Mask gpuSubnetsMask = Ipv4Mask("255.255.255.0");
-                Ipv4Address gpuSubnets = gpuIp.CombineMask(gpuSubnetsMask);
-                staticRouting->AddNetworkRouteTo(gpuSubnets, gpuSubnetsMask, leafIp, j + 1);
-                // // Add route to each GPU via the corresponding leaf node, it is the same with
-                // the above Ipv4Address gpuIp = m_leafGpuInterfaces[j][k].GetAddress(1);
-                // staticRouting->AddHostRouteTo(gpuIp, leafIp, j + 1);
-            }
+            Ipv4Mask leafBlockMask(("/" + to_string(m_leafGpuBlockPrefix)).c_str());
+            staticRouting->AddNetworkRouteTo(getLeafGpuBlock(podId * leafNumPerPod + j),
+                                             leafBlockMask,
+                                             leafIp,
+                                             j + 1);
+        }
+        if (m_coreNum == 0)
+        {
+            continue;
+        }
+        // the other pods are reached through one of the cores of the spine,
+        // cores i % m_spineNum, i % m_spineNum + m_spineNum, ...
+        uint32_t coreIndex = m_loadBalanceStrategy == "random" ? rand() % coreNumPerSpine : 0;
+        uint32_t coreId = i % m_spineNum + coreIndex * m_spineNum;
+        NetDeviceContainer& devices = getCoreSpineDevices(coreId, i);
+        staticRouting->SetDefaultRoute(m_coreSpineInterfaces[coreId][podId].GetAddress(0),
+                                       ipv4->GetInterfaceForDevice(devices.Get(1)));
+        m_spineCoreMap[i] = coreId;
+    }
+
+    // configure core routes, one prefix holds the leaf blocks of a pod
+    uint32_t podBlockPrefix = m_leafGpuBlockPrefix;
+    for (uint32_t slots = m_leafSlotsPerPod; slots > 1; slots /= 2)
+    {
+        podBlockPrefix--;
+    }
+    Ipv4Mask podBlockMask(("/" + to_string(podBlockPrefix)).c_str());
+    for (uint32_t i = 0; i < m_coreNum; ++i)
+    {
+        Ptr<Ipv4> ipv4 = m_coreNodes.Get(i)->GetObject<Ipv4>();
+        Ptr<Ipv4StaticRouting> staticRouting = staticRoutingHelper.GetStaticRouting(ipv4);
+        for (uint32_t j = 0; j < m_podNum; ++j)
+        {
+            staticRouting->AddNetworkRouteTo(getLeafGpuBlock(j * leafNumPerPod),
+                                             podBlockMask,
+                                             m_coreSpineInterfaces[i][j].GetAddress(1),
+                                             ipv4->GetInterfaceForDevice(
+                                                 m_coreSpineDevices[i][j].Get(0)));
         }
     }
 }
@@ -326,7 +948,7 @@ void
 spineLeafTopo::captureSpineLeafPackets(uint32_t spineId, uint32_t leafId)
 {
     m_spineLeafLink.EnablePcap(string("spine-leaf-" + to_string(spineId) + "-" + to_string(leafId)),
-                               m_spineLeafDevices[spineId][leafId],
+                               m_spineLeafDevices[spineId][leafId % (m_leafNum / m_podNum)],
                                true);
 }
 
@@ -340,6 +962,28 @@ spineLeafTopo::captureLeafGpuPackets(uint32_t leafId, uint32_t gpuId)
     //                          m_leafGpuDevices[leafId][gpuId], true);
 }
 
+void
+spineLeafTopo::enableTelemetry(string filename, Time interval, Time stopTime, uint64_t blockBytes)
+{
+    NS_LOG_FUNCTION(this);
+    // one band per child queue disc of the prio root queue disc
+    m_telemetry = make_unique<DdlFabricTelemetry>(filename, interval, blockBytes, 8);
+    for (const DdlLinkId& linkId : getLinkIds())
+    {
+        m_telemetry->addLink(getLinkSendDevice(linkId), linkId.kind, linkId.from, linkId.to);
+    }
+    if (!m_telemetry->start(stopTime))
+    {
+        printColoredText("Failed to open the fabric telemetry file " + filename, "red");
+        m_telemetry.reset();
+        return;
+    }
+    printColoredText("Fabric telemetry of " + to_string(m_telemetry->getLinkNum()) +
+                         " links written to " + filename + ", " +
+                         to_string(m_telemetry->getChunkSamples()) + " samples per chunk",
+                     "green");
+}
+
 void
 spineLeafTopo::pingAllGpuTest()
 {
@@ -399,7 +1043,7 @@ spineLeafTopo::PrintTopo()
 {
     NS_LOG_FUNCTION(this);
     cout << "Spine-Leaf Topology: " << endl;
-    cout << "Spine Number: " << m_spineNum << endl;
+    cout << "Spine Number: " << getSpineNum() << endl;
     cout << "Leaf Number: " << m_leafNum << endl;
     cout << "GPU Number Per Leaf: " << m_gpuNumPerLeaf << endl;
     cout << "Spine-Leaf Bandwidth: " << m_spineLeafBandwidth << " Gbps" << endl;
@@ -411,11 +1055,12 @@ spineLeafTopo::PrintSpineLeafSubnets()
 {
     NS_LOG_FUNCTION(this);
     cout << "Spine-Leaf Subnets: " << endl;
-    for (uint32_t i = 0; i < m_spineNum; ++i)
+    for (uint32_t i = 0; i < getSpineNum(); ++i)
     {
-        for (uint32_t j = 0; j < m_leafNum; ++j)
+        for (uint32_t j = 0; j < m_leafNum / m_podNum; ++j)
         {
-            cout << "Subnet between Spine " << i << " and Leaf " << j << ": ";
+            uint32_t leafId = i / m_spineNum * (m_leafNum / m_podNum) + j;
+            cout << "Subnet between Spine " << i << " and Leaf " << leafId << ": ";
             cout << m_spineLeafInterfaces[i][j].GetAddress(0) << " - ";
             cout << m_spineLeafInterfaces[i][j].GetAddress(1) << endl;
         }
@@ -1,5 +1,7 @@
 #ifndef DDL_TOPO_H
 #define DDL_TOPO_H
+#include "ddl-telemetry.h"
+
 #include "ns3/core-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/ipv4-address-helper.h"
@@ -10,24 +12,103 @@
 #include "ns3/traffic-control-helper.h"
 
 #include <iostream>
+#include <memory>
+#include <tuple>
 using namespace std;
 
 namespace ns3
 {
 
+// the shape of the fabric, a two-tier spine-leaf unless it has pods and cores
+// the gpus are numbered leaf by leaf in every layout, the leafs pod by pod
+struct DdlFabricConfig
+{
+    uint32_t podNum = 1;
+    // the spines of each pod, the aggregation tier when there are cores
+    uint32_t spineNum = 0;
+    // all the leafs, split evenly over the pods
+    uint32_t leafNum = 0;
+    uint32_t gpuNumPerLeaf = 0;
+    // 0 for a two-tier fabric, a core links to spine (core % spineNum) of every pod
+    uint32_t coreNum = 0;
+    // MBps
+    float spineLeafBandwidth = 0;
+    float leafGpuBandwidth = 0;
+    float coreSpineBandwidth = 0;
+    string loadBalance = "random";
+    // the gpus of a host share a nvlink group, 0 without nvlink
+    uint32_t nvlinkGroupSize = 0;
+    float nvlinkBandwidth = 0;
+    // a host has one gpu on each of nvlinkGroupSize consecutive leafs, the rails,
+    // instead of nvlinkGroupSize consecutive gpus of one leaf
+    bool railLayout = false;
+
+    static DdlFabricConfig spineLeaf(uint32_t spineNum,
+                                     uint32_t leafNum,
+                                     uint32_t gpuNumPerLeaf,
+                                     float spineLeafBandwidth,
+                                     float leafGpuBandwidth);
+    // k pods of k/2 leafs and k/2 spines, (k/2)^2 cores, k/2 gpus per leaf, k^3/4 gpus
+    static DdlFabricConfig fatTree(uint32_t k, float bandwidth);
+    // a 3-tier clos whose leaf and spine tiers take oversubscription times more bandwidth
+    // from below than they have above, coreNum must be a multiple of spineNumPerPod
+    static DdlFabricConfig clos(uint32_t podNum,
+                                uint32_t leafNumPerPod,
+                                uint32_t spineNumPerPod,
+                                uint32_t coreNum,
+                                uint32_t gpuNumPerLeaf,
+                                float leafGpuBandwidth,
+                                float oversubscription);
+    // railNum leafs per rail group, gpu r of each host of a group on the leaf of rail r,
+    // the gpus of a host talk through nvlink
+    static DdlFabricConfig railOptimized(uint32_t groupNum,
+                                         uint32_t railNum,
+                                         uint32_t hostNumPerGroup,
+                                         uint32_t spineNum,
+                                         float bandwidth,
+                                         float nvlinkBandwidth);
+};
+
+// a link direction of the fabric, from and to are the indices of the nodes in their tier
+struct DdlLinkId
+{
+    DdlLinkKind kind;
+    uint32_t from;
+    uint32_t to;
+
+    // a readable name of the link direction, for the logs
+    string name() const;
+
+    bool operator<(const DdlLinkId& other) const
+    {
+        return tie(kind, from, to) < tie(other.kind, other.from, other.to);
+    }
+
+    bool operator==(const DdlLinkId& other) const
+    {
+        return kind == other.kind && from == other.from && to == other.to;
+    }
+};
+
 class spineLeafTopo
 {
   public:
-    spineLeafTopo(string topoConfigFile);
+    // partitionNum is the number of ranks under the MPI distributed simulator,
+    // 0 gives one partition per leaf under the multithreaded simulator
+    spineLeafTopo(string topoConfigFile, uint32_t partitionNum = 0);
+    spineLeafTopo(const DdlFabricConfig& config, uint32_t partitionNum = 0);
     void InitTopoConfig(string topoConfigFile);
+    void InitTopoConfig(const DdlFabricConfig& config);
 
     void CreateNodes();
     void SetupLink();
 
     void InstallSpineLeafLinks();
+    void InstallCoreSpineLinks();
     void InstallLeafGpuLinks();
     void InstallInternetStack();
     void AssignIpAddresses();
+    Ipv4Address getLeafGpuBlock(uint32_t leafId);
 
     void PrintTopo();
     void PrintSpineLeafSubnets();
@@ -41,8 +122,20 @@ class spineLeafTopo
     void InitQueueDisp();
     void ConfigureQueueDisp();
 
+    // override the bandwidth and the delay of single links, one link per row:
+    //   link,from,to,bandwidth,delay
+    // link is spine-leaf, core-spine or leaf-gpu, from and to the indices of the upper and
+    // the lower node, bandwidth in MBps and delay as a time string, an empty field is kept
+    void loadLinkConfig(string linkConfigFile);
+
     void captureSpineLeafPackets(uint32_t spineId, uint32_t leafId);
     void captureLeafGpuPackets(uint32_t leafId, uint32_t gpuId);
+    // sample every link direction of the fabric into a binary columnar file
+    // the telemetry holds two blocks of at most blockBytes in memory
+    void enableTelemetry(string filename,
+                         Time interval,
+                         Time stopTime,
+                         uint64_t blockBytes = 64 * 1024 * 1024);
 
     NodeContainer getSpineNodes()
     {
@@ -64,9 +157,25 @@ class spineLeafTopo
         return m_leafNum * m_gpuNumPerLeaf;
     }
 
+    NodeContainer getCoreNodes()
+    {
+        return m_coreNodes;
+    }
+
+    // the spines of all the pods
     uint32_t getSpineNum()
     {
-        return m_spineNum;
+        return m_spineNum * m_podNum;
+    }
+
+    uint32_t getPodNum()
+    {
+        return m_podNum;
+    }
+
+    uint32_t getCoreNum()
+    {
+        return m_coreNum;
     }
 
     uint32_t getLeafNum()
@@ -89,30 +198,186 @@ class spineLeafTopo
         return m_leafSpineMap;
     }
 
+    uint32_t getGpuLeaf(uint32_t gpuIndex)
+    {
+        return gpuIndex / m_gpuNumPerLeaf;
+    }
+
+    uint32_t getLeafPod(uint32_t leafId)
+    {
+        return leafId / (m_leafNum / m_podNum);
+    }
+
+    // the host of a gpu, the gpus of a host share its nvlink group
+    uint32_t getGpuHost(uint32_t gpuIndex);
+
+    // the link a leaf sends through to the other leafs, to the spine it routes to
+    DdlLinkId getLeafUplink(uint32_t leafId);
+
+    // the link of a gpu to its leaf
+    DdlLinkId getGpuUplink(uint32_t gpuIndex)
+    {
+        return {DdlLinkKind::GPU_TO_LEAF, gpuIndex, getGpuLeaf(gpuIndex)};
+    }
+
+    // every link direction of the fabric, tier by tier from the cores down,
+    // a link direction's position in it is its dense index
+    vector<DdlLinkId> getLinkIds();
+
+    uint32_t getLinkNum()
+    {
+        return 2 * (m_coreNum * m_podNum + getSpineNum() * (m_leafNum / m_podNum) + getGpuNum());
+    }
+
+    // the dense index of a link direction of the fabric, computed without a lookup
+    uint32_t getLinkIndex(const DdlLinkId& linkId);
+    DdlLinkKind getLinkKind(uint32_t linkIndex);
+
+    // the dense indices of the link directions a packet from srcGpu to dstGpu takes under the
+    // static routes: the gpu uplink, the leaf uplink, the core hops between two pods,
+    // the spine downlink and the gpu downlink, empty for a gpu to itself
+    vector<uint32_t> getPathLinks(uint32_t srcGpu, uint32_t dstGpu);
+
+    // the device that sends into a link direction, its queue disc holds the queued bytes
+    Ptr<NetDevice> getLinkSendDevice(const DdlLinkId& linkId);
+
+    // whether the nodes are split in partitions of a parallel simulator
+    bool isPartitioned()
+    {
+        return m_partitioned;
+    }
+
+    // only from the partition of the gpu, the node refcount is not shared across threads
+    Ptr<Node> getGpuNode(uint32_t gpuIndex)
+    {
+        return m_gpuNodes.Get(gpuIndex);
+    }
+
+    // the lookups below touch no node object, so any partition can call them
+    uint32_t getGpuNodeId(uint32_t gpuIndex)
+    {
+        return m_gpuNodeIds[gpuIndex];
+    }
+
+    uint32_t getGpuSystemId(uint32_t gpuIndex)
+    {
+        return getLeafSystemId(gpuIndex / m_gpuNumPerLeaf);
+    }
+
+    Ipv4Address getGpuAddress(uint32_t gpuIndex)
+    {
+        return m_gpuAddresses[gpuIndex];
+    }
+
+    // the gpu index of a node id, or getGpuNum() if the node is not a gpu
+    uint32_t getGpuIndexOfNode(uint32_t nodeId);
+
+    // the rate of a transfer that stays inside a host: a gpu to itself, or two gpus of the
+    // same nvlink group, 0 if the transfer crosses the fabric
+    DataRate getIntraHostRate(uint32_t srcGpu, uint32_t dstGpu);
+
+    // the coordinator runs the placement and the tos solvers, it is spine 0
+    uint32_t getCoordinatorNodeId()
+    {
+        return m_coordinatorNodeId;
+    }
+
+    uint32_t getCoordinatorSystemId()
+    {
+        return getSpineSystemId(0);
+    }
+
+    // the address of the coordinator on its link to a leaf
+    Ipv4Address getCoordinatorAddress(uint32_t leafId)
+    {
+        return m_coordinatorAddresses[leafId];
+    }
+
+    uint32_t getLeafSystemId(uint32_t leafId)
+    {
+        return m_partitioned ? leafId % m_partitionNum : 0;
+    }
+
+    uint32_t getSpineSystemId(uint32_t spineId)
+    {
+        return m_partitioned ? spineId % m_partitionNum : 0;
+    }
+
+    uint32_t getCoreSystemId(uint32_t coreId)
+    {
+        return m_partitioned ? coreId % m_partitionNum : 0;
+    }
+
   private:
+    // the spine of a pod, and the devices of a core-spine link
+    uint32_t getPodSpine(uint32_t podId, uint32_t spineId)
+    {
+        return podId * m_spineNum + spineId;
+    }
+
+    NetDeviceContainer& getCoreSpineDevices(uint32_t coreId, uint32_t spineId)
+    {
+        return m_coreSpineDevices[coreId][spineId / m_spineNum];
+    }
+
+    // the devices of a link, (upper node, lower node)
+    NetDeviceContainer getLinkDevices(DdlLinkKind kind, uint32_t upper, uint32_t lower);
+
+    void Build();
+
+    uint32_t m_podNum;
+    // per pod
     uint32_t m_spineNum;
     uint32_t m_leafNum;
     uint32_t m_gpuNumPerLeaf;
+    uint32_t m_coreNum;
     vector<uint32_t> m_freeNodeIndex;
     float m_spineLeafBandwidth;
     float m_leafGpuBandwidth;
+    float m_coreSpineBandwidth;
+    // optional columns, the gpus of a host are grouped by nvlink, 0 without nvlink
+    uint32_t m_nvlinkGroupSize;
+    float m_nvlinkBandwidth;
+    bool m_railLayout;
 
+    NodeContainer m_coreNodes;
     NodeContainer m_spineNodes;
     NodeContainer m_leafNodes;
     NodeContainer m_gpuNodes;
 
     PointToPointHelper m_spineLeafLink;
+    PointToPointHelper m_coreSpineLink;
     PointToPointHelper m_leafGpuLink;
 
+    // [spine][leaf of the pod of the spine]
     std::vector<std::vector<NetDeviceContainer>> m_spineLeafDevices;
+    // [core][pod], the core links to one spine of each pod
+    std::vector<std::vector<NetDeviceContainer>> m_coreSpineDevices;
     std::vector<std::vector<NetDeviceContainer>> m_leafGpuDevices;
     std::vector<std::vector<Ipv4InterfaceContainer>> m_spineLeafInterfaces;
+    std::vector<std::vector<Ipv4InterfaceContainer>> m_coreSpineInterfaces;
     std::vector<std::vector<Ipv4InterfaceContainer>> m_leafGpuInterfaces;
 
     map<uint32_t, uint32_t> m_leafSpineMap;
+    // spine -> the core it routes up to, only with cores
+    map<uint32_t, uint32_t> m_spineCoreMap;
+    // the nodes are split in partitions of the multithreaded or the MPI simulator
+    bool m_partitioned;
+    uint32_t m_partitionNum;
+    // cached at setup, reading them from the nodes is not safe across partitions
+    vector<uint32_t> m_gpuNodeIds;
+    vector<Ipv4Address> m_gpuAddresses;
+    uint32_t m_coordinatorNodeId;
+    vector<Ipv4Address> m_coordinatorAddresses;
+    // prefix length of the address block of each leaf's gpus
+    uint32_t m_leafGpuBlockPrefix;
+    // the leaf blocks of a pod are aligned to a power of two, one route per pod at the cores
+    uint32_t m_leafSlotsPerPod;
 
     TrafficControlHelper m_queueDisp;
     string m_loadBalanceStrategy;
+
+    unique_ptr<DdlFabricTelemetry> m_telemetry;
 };
 
 } // namespace ns3
@@ -0,0 +1,377 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "ns3/ddl-control.h"
+#include "ns3/ddl-placement-score.h"
+#include "ns3/ddl-tools.h"
+#include "ns3/ddl-topo.h"
+#include "ns3/ipv4-address-generator.h"
+#include "ns3/packet.h"
+#include "ns3/test.h"
+#include "ns3/udp-echo-helper.h"
+
+using namespace ns3;
+
+/**
+ * @ingroup applications-test
+ * @ingroup tests
+ *
+ * Check which flows of a placed job DAG are fused by fuseSmallFlowChains.
+ */
+class DdlSmallFlowFusionTestCase : public TestCase
+{
+  public:
+    DdlSmallFlowFusionTestCase();
+
+  private:
+    void DoRun() override;
+    /**
+     * Add a flow to the DAG
+     * @param flowId the flow id
+     * @param compTime the compute time in ms
+     * @param commSize the comm size in bytes
+     * @param firstFlow whether the flow starts an iteration
+     * @param lastFlow whether the flow ends an iteration
+     * @param upstream the upstream flows
+     * @param downstream the downstream flows
+     */
+    void AddFlow(uint32_t flowId,
+                 uint32_t compTime,
+                 uint32_t commSize,
+                 bool firstFlow,
+                 bool lastFlow,
+                 std::vector<uint32_t> upstream,
+                 std::vector<uint32_t> downstream);
+    /**
+     * Place the flows one after the other on the gpus, as DdlApplication::generateFlow does
+     * @param gpuIndex the gpus, as returned by duplicateMiddleElements
+     */
+    void Place(const std::vector<uint32_t>& gpuIndex);
+    /**
+     * Sum the comm size of a chain
+     * @param chain the flows of the chain
+     * @return the bytes of the fused transfer
+     */
+    uint32_t ChainBytes(const std::vector<uint32_t>& chain);
+
+    FlowFeatureMap m_flowFeatures;                                  //!< the job DAG
+    std::map<uint32_t, std::pair<uint32_t, uint32_t>> m_flowGpuPair; //!< the placement
+};
+
+DdlSmallFlowFusionTestCase::DdlSmallFlowFusionTestCase()
+    : TestCase("Check the small flow fusion along the ring placement")
+{
+}
+
+void
+DdlSmallFlowFusionTestCase::AddFlow(uint32_t flowId,
+                                    uint32_t compTime,
+                                    uint32_t commSize,
+                                    bool firstFlow,
+                                    bool lastFlow,
+                                    std::vector<uint32_t> upstream,
+                                    std::vector<uint32_t> downstream)
+{
+    auto& features = m_flowFeatures[flowId];
+    features["comp_time"] = compTime;
+    features["comm_size"] = commSize;
+    features["first_flow"] = firstFlow;
+    features["last_flow"] = lastFlow;
+    features["upstream"] = upstream;
+    features["downstream"] = downstream;
+}
+
+void
+DdlSmallFlowFusionTestCase::Place(const std::vector<uint32_t>& gpuIndex)
+{
+    m_flowGpuPair.clear();
+    uint32_t resourceCnt = 0;
+    for (const auto& [flowId, features] : m_flowFeatures)
+    {
+        m_flowGpuPair[flowId] = {gpuIndex[resourceCnt], gpuIndex[resourceCnt + 1]};
+        resourceCnt += 2;
+    }
+}
+
+uint32_t
+DdlSmallFlowFusionTestCase::ChainBytes(const std::vector<uint32_t>& chain)
+{
+    uint32_t bytes = 0;
+    for (auto flowId : chain)
+    {
+        bytes += std::get<uint32_t>(m_flowFeatures[flowId]["comm_size"]);
+    }
+    return bytes;
+}
+
+void
+DdlSmallFlowFusionTestCase::DoRun()
+{
+    // gpt3-tp2pp2: two compute flows, each followed by a small zero-compute flow
+    AddFlow(0, 10, 38000000, true, false, {3}, {1});
+    AddFlow(1, 0, 1000000, false, false, {0}, {2});
+    AddFlow(2, 10, 38000000, false, false, {1}, {3});
+    AddFlow(3, 0, 5000000, false, true, {2}, {0});
+    Place(duplicateMiddleElements({4, 5, 6, 7}));
+
+    auto chains = fuseSmallFlowChains(m_flowFeatures, m_flowGpuPair, 5000000);
+    NS_TEST_ASSERT_MSG_EQ(chains.size(), 2, "Both small flows are fused");
+    NS_TEST_ASSERT_MSG_EQ((chains[0] == std::vector<uint32_t>{0, 1}), true, "Flow 1 follows 0");
+    NS_TEST_ASSERT_MSG_EQ((chains[2] == std::vector<uint32_t>{2, 3}), true, "Flow 3 follows 2");
+    NS_TEST_ASSERT_MSG_EQ(ChainBytes(chains[0]), 39000000, "The fused transfer sums the flows");
+    NS_TEST_ASSERT_MSG_EQ(ChainBytes(chains[2]), 43000000, "The fused transfer sums the flows");
+    // the fused transfers go from the head src to the tail dst along the ring
+    NS_TEST_ASSERT_MSG_EQ(m_flowGpuPair[0].first, 4, "Chain 0 starts at gpu 4");
+    NS_TEST_ASSERT_MSG_EQ(m_flowGpuPair[1].second, 6, "Chain 0 ends at gpu 6");
+
+    // too large to fuse
+    chains = fuseSmallFlowChains(m_flowFeatures, m_flowGpuPair, 999999);
+    NS_TEST_ASSERT_MSG_EQ(chains.size(), 4, "No flow is fused below its size");
+
+    // only flow 1 is small enough
+    chains = fuseSmallFlowChains(m_flowFeatures, m_flowGpuPair, 1000000);
+    NS_TEST_ASSERT_MSG_EQ(chains.size(), 3, "Only flow 1 is fused");
+    NS_TEST_ASSERT_MSG_EQ(chains[3].size(), 1, "Flow 3 is not fused");
+
+    // a chain stops before it returns to the gpu it starts at
+    m_flowFeatures.clear();
+    AddFlow(0, 5, 2000000, true, false, {2}, {1});
+    AddFlow(1, 0, 1000, false, false, {0}, {2});
+    AddFlow(2, 0, 1000, false, true, {1}, {0});
+    Place(duplicateMiddleElements({0, 1, 2}));
+    chains = fuseSmallFlowChains(m_flowFeatures, m_flowGpuPair, 1000000);
+    NS_TEST_ASSERT_MSG_EQ(chains.size(), 2, "The ring is not closed");
+    NS_TEST_ASSERT_MSG_EQ((chains[0] == std::vector<uint32_t>{0, 1}), true, "Flow 1 follows 0");
+    NS_TEST_ASSERT_MSG_EQ(chains[2].size(), 1, "Flow 2 would send back to gpu 0");
+
+    // a single gpu job sends to itself, its flows share the pair
+    m_flowFeatures.clear();
+    AddFlow(0, 5, 2000000, true, false, {1}, {1});
+    AddFlow(1, 0, 1000, false, true, {0}, {0});
+    Place({3, 3, 3, 3});
+    chains = fuseSmallFlowChains(m_flowFeatures, m_flowGpuPair, 1000000);
+    NS_TEST_ASSERT_MSG_EQ(chains.size(), 1, "The flows of the same pair are fused");
+    NS_TEST_ASSERT_MSG_EQ(ChainBytes(chains[0]), 2001000, "The fused transfer sums the flows");
+}
+
+/**
+ * @ingroup applications-test
+ * @ingroup tests
+ *
+ * Check that a control message crosses the ranks unchanged.
+ */
+class DdlControlHeaderTestCase : public TestCase
+{
+  public:
+    DdlControlHeaderTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+DdlControlHeaderTestCase::DdlControlHeaderTestCase()
+    : TestCase("Check the serialization of the DDL control messages")
+{
+}
+
+void
+DdlControlHeaderTestCase::DoRun()
+{
+    DdlControlMessage message;
+    message.type = DdlControlType::INSTALL_RECV;
+    message.jobId = 7;
+    message.flowId = 3;
+    message.peerFlowId = 2;
+    message.srcGpu = 100000;
+    message.dstGpu = 65537;
+    message.value = 5000000000ULL;
+    message.time = 123456789012ULL;
+
+    DdlControlHeader header;
+    header.setMessage(message);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 37, "The header has a fixed size");
+
+    DdlControlHeader received;
+    packet->RemoveHeader(received);
+    DdlControlMessage copy = received.getMessage();
+    NS_TEST_ASSERT_MSG_EQ((copy.type == DdlControlType::INSTALL_RECV), true, "Wrong type");
+    NS_TEST_ASSERT_MSG_EQ(copy.jobId, 7, "Wrong job");
+    NS_TEST_ASSERT_MSG_EQ(copy.flowId, 3, "Wrong flow");
+    NS_TEST_ASSERT_MSG_EQ(copy.peerFlowId, 2, "Wrong peer flow");
+    NS_TEST_ASSERT_MSG_EQ(copy.srcGpu, 100000, "Wrong src gpu");
+    NS_TEST_ASSERT_MSG_EQ(copy.dstGpu, 65537, "Wrong dst gpu");
+    NS_TEST_ASSERT_MSG_EQ(copy.value, 5000000000ULL, "Wrong value");
+    NS_TEST_ASSERT_MSG_EQ(copy.time, 123456789012ULL, "Wrong time");
+}
+
+/**
+ * @ingroup applications-test
+ * @ingroup tests
+ *
+ * Check the slowdown the placement scorer gives to the candidates.
+ */
+class DdlPlacementScoreTestCase : public TestCase
+{
+  public:
+    DdlPlacementScoreTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+DdlPlacementScoreTestCase::DdlPlacementScoreTestCase()
+    : TestCase("Check the link-scale slowdown of the placement candidates")
+{
+}
+
+void
+DdlPlacementScoreTestCase::DoRun()
+{
+    DdlPlacementScorer scorer(3);
+    // a running job of 10 ms compute and 10 ms comm asks half of link 0
+    scorer.addJob(20, {{0, 10}});
+    scorer.prepare();
+
+    // link 0 is asked 1.5 times its time: the running job takes 25 ms instead of 20,
+    // the new job 15 ms instead of 10
+    NS_TEST_ASSERT_MSG_EQ_TOL(scorer.score(10, {{0, 10}}), 1.375, 1e-9, "Link 0 is overloaded");
+    NS_TEST_ASSERT_MSG_EQ_TOL(scorer.score(10, {{1, 10}}), 1, 1e-9, "Link 1 is free");
+    // a link used by two flows of the candidate adds both
+    NS_TEST_ASSERT_MSG_EQ_TOL(scorer.score(10, {{0, 5}, {0, 5}}),
+                              1.375,
+                              1e-9,
+                              "The flows of a link add up");
+    // a full link is not slowed down yet
+    NS_TEST_ASSERT_MSG_EQ_TOL(scorer.score(20, {{0, 10}}), 1, 1e-9, "Link 0 is just full");
+    // a flow on two links loads both with its whole comm
+    NS_TEST_ASSERT_MSG_EQ_TOL(scorer.score(10, {{1, 10}, {0, 10}}),
+                              1.375,
+                              1e-9,
+                              "Every link of a path is loaded");
+    // the scores do not change the scorer
+    NS_TEST_ASSERT_MSG_EQ_TOL(scorer.score(10, {{0, 10}}), 1.375, 1e-9, "The score is repeatable");
+}
+
+/**
+ * @ingroup applications-test
+ * @ingroup tests
+ *
+ * Check the routes of a fat-tree across its pods and the hosts of a rail-optimized fabric.
+ */
+class DdlFabricTestCase : public TestCase
+{
+  public:
+    DdlFabricTestCase();
+
+  private:
+    void DoRun() override;
+    /**
+     * Count an echo reply
+     * @param packet the reply
+     */
+    void ReceiveReply(Ptr<const Packet> packet);
+
+    uint32_t m_replies; //!< the echo replies received
+};
+
+DdlFabricTestCase::DdlFabricTestCase()
+    : TestCase("Check the multi-tier and rail-optimized fabrics"),
+      m_replies(0)
+{
+}
+
+void
+DdlFabricTestCase::ReceiveReply(Ptr<const Packet> packet)
+{
+    m_replies++;
+}
+
+void
+DdlFabricTestCase::DoRun()
+{
+    Ipv4AddressGenerator::Reset();
+    spineLeafTopo fatTree(DdlFabricConfig::fatTree(4, 12500));
+    NS_TEST_ASSERT_MSG_EQ(fatTree.getGpuNum(), 16, "A 4-ary fat-tree has 16 gpus");
+    NS_TEST_ASSERT_MSG_EQ(fatTree.getCoreNum(), 4, "A 4-ary fat-tree has 4 cores");
+    NS_TEST_ASSERT_MSG_EQ(fatTree.getLinkIds().size(), 2 * (16 + 16 + 16), "Links of all tiers");
+    for (uint32_t leafId = 0; leafId < fatTree.getLeafNum(); leafId++)
+    {
+        DdlLinkId uplink = fatTree.getLeafUplink(leafId);
+        NS_TEST_ASSERT_MSG_EQ(uplink.to / 2, fatTree.getLeafPod(leafId), "A spine of the pod");
+    }
+    vector<DdlLinkId> linkIds = fatTree.getLinkIds();
+    NS_TEST_ASSERT_MSG_EQ(linkIds.size(), fatTree.getLinkNum(), "Dense indices of all the links");
+    for (uint32_t i = 0; i < linkIds.size(); i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(fatTree.getLinkIndex(linkIds[i]), i, "Index of " + linkIds[i].name());
+        NS_TEST_ASSERT_MSG_EQ((fatTree.getLinkKind(i) == linkIds[i].kind), true, "Kind of a link");
+    }
+    // up to a core and down to the other pod
+    vector<DdlLinkKind> pathKinds = {DdlLinkKind::GPU_TO_LEAF,
+                                     DdlLinkKind::LEAF_TO_SPINE,
+                                     DdlLinkKind::SPINE_TO_CORE,
+                                     DdlLinkKind::CORE_TO_SPINE,
+                                     DdlLinkKind::SPINE_TO_LEAF,
+                                     DdlLinkKind::LEAF_TO_GPU};
+    vector<uint32_t> path = fatTree.getPathLinks(0, 15);
+    NS_TEST_ASSERT_MSG_EQ(path.size(), pathKinds.size(), "Six hops between two pods");
+    for (uint32_t i = 0; i < path.size() && i < pathKinds.size(); i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ((linkIds[path[i]].kind == pathKinds[i]), true, "The hops in order");
+    }
+    NS_TEST_ASSERT_MSG_EQ(linkIds[path.back()].to, 15, "The path ends at the receiver");
+    NS_TEST_ASSERT_MSG_EQ(fatTree.getPathLinks(0, 1).size(), 2, "Two hops inside a leaf");
+
+    // gpu 0 and gpu 15 are in the first and the last pod, the echo crosses a core twice
+    UdpEchoServerHelper server(9);
+    ApplicationContainer serverApps = server.Install(fatTree.getGpuNode(15));
+    serverApps.Start(Seconds(0));
+    UdpEchoClientHelper client(fatTree.getGpuAddress(15), 9);
+    client.SetAttribute("MaxPackets", UintegerValue(3));
+    client.SetAttribute("Interval", TimeValue(MilliSeconds(1)));
+    ApplicationContainer clientApps = client.Install(fatTree.getGpuNode(0));
+    clientApps.Start(Seconds(0));
+    clientApps.Get(0)->TraceConnectWithoutContext(
+        "Rx",
+        MakeCallback(&DdlFabricTestCase::ReceiveReply, this));
+    Simulator::Stop(MilliSeconds(100));
+    Simulator::Run();
+    Simulator::Destroy();
+    NS_TEST_ASSERT_MSG_EQ(m_replies, 3, "Every echo crosses the pods and comes back");
+
+    // two rail groups of two hosts with two gpus, the gpus of a host are on two leafs
+    Ipv4AddressGenerator::Reset();
+    spineLeafTopo rail(DdlFabricConfig::railOptimized(2, 2, 2, 1, 12500, 150000));
+    NS_TEST_ASSERT_MSG_EQ(rail.getGpuHost(0), rail.getGpuHost(2), "A host spans the rails");
+    NS_TEST_ASSERT_MSG_NE(rail.getGpuHost(0), rail.getGpuHost(1), "A leaf holds two hosts");
+    NS_TEST_ASSERT_MSG_NE(rail.getGpuHost(0), rail.getGpuHost(4), "Another rail group");
+    NS_TEST_ASSERT_MSG_GT(rail.getIntraHostRate(1, 3).GetBitRate(), 0, "Nvlink inside a host");
+    NS_TEST_ASSERT_MSG_EQ(rail.getIntraHostRate(0, 1).GetBitRate(), 0, "Two hosts of a leaf");
+    Simulator::Destroy();
+}
+
+/**
+ * @ingroup applications-test
+ * @ingroup tests
+ *
+ * @brief DDL tools TestSuite
+ */
+class DdlToolsTestSuite : public TestSuite
+{
+  public:
+    DdlToolsTestSuite();
+};
+
+DdlToolsTestSuite::DdlToolsTestSuite()
+    : TestSuite("applications-ddl-tools", Type::UNIT)
+{
+    AddTestCase(new DdlSmallFlowFusionTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new DdlControlHeaderTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new DdlPlacementScoreTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new DdlFabricTestCase, TestCase::Duration::QUICK);
+}
+
+static DdlToolsTestSuite g_ddlToolsTestSuite; //!< Static variable for test initialization
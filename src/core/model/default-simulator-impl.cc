@@ -9,11 +9,15 @@
 #include "default-simulator-impl.h"
 
 #include "assert.h"
+#include "event-profiler.h"
 #include "log.h"
+#include "scheduler-trace.h"
 #include "scheduler.h"
 #include "simulator.h"
+#include "string.h"
 
 #include <cmath>
+#include <fstream>
 
 /**
  * @file
@@ -37,7 +41,29 @@ DefaultSimulatorImpl::GetTypeId()
     static TypeId tid = TypeId("ns3::DefaultSimulatorImpl")
                             .SetParent<SimulatorImpl>()
                             .SetGroupName("Core")
-                            .AddConstructor<DefaultSimulatorImpl>();
+                            .AddConstructor<DefaultSimulatorImpl>()
+                            .AddAttribute("EventProfileBucket",
+                                          "Width of the simulation time buckets of the "
+                                          "event profile timeline.",
+                                          TimeValue(MilliSeconds(1)),
+                                          MakeTimeAccessor(&DefaultSimulatorImpl::m_profileBucket),
+                                          MakeTimeChecker(TimeStep(1)))
+                            .AddAttribute("EventProfileFile",
+                                          "If not empty, profile the wall-clock time spent in "
+                                          "each event type and write the flat profile and the "
+                                          "timeline to this file at the end of Run().",
+                                          StringValue(""),
+                                          MakeStringAccessor(
+                                              &DefaultSimulatorImpl::SetEventProfileFile),
+                                          MakeStringChecker())
+                            .AddAttribute("SchedulerTraceFile",
+                                          "If not empty, record every insert and removal "
+                                          "of the event scheduler to this file, to replay "
+                                          "with utils/bench-scheduler.",
+                                          StringValue(""),
+                                          MakeStringAccessor(
+                                              &DefaultSimulatorImpl::SetSchedulerTraceFile),
+                                          MakeStringChecker());
     return tid;
 }
 
@@ -53,6 +79,9 @@ DefaultSimulatorImpl::DefaultSimulatorImpl()
     m_eventCount = 0;
     m_eventsWithContextEmpty = true;
     m_mainThreadId = std::this_thread::get_id();
+    m_profileBucket = MilliSeconds(1);
+    m_profileWallTime = std::chrono::steady_clock::duration::zero();
+    m_profileWallTicks = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl()
@@ -72,6 +101,7 @@ DefaultSimulatorImpl::DoDispose()
         next.impl->Unref();
     }
     m_events = nullptr;
+    m_schedulerTrace.reset();
     SimulatorImpl::DoDispose();
 }
 
@@ -108,6 +138,53 @@ DefaultSimulatorImpl::SetScheduler(ObjectFactory schedulerFactory)
     m_events = scheduler;
 }
 
+void
+DefaultSimulatorImpl::SetEventProfileFile(std::string filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+    m_profileFile = filename;
+    if (filename.empty())
+    {
+        m_profiler.reset();
+    }
+    else if (!m_profiler)
+    {
+        m_profiler = std::make_unique<EventProfiler>(m_profileBucket.GetTimeStep());
+    }
+}
+
+void
+DefaultSimulatorImpl::WriteEventProfile()
+{
+    NS_LOG_FUNCTION(this);
+    std::ofstream os(m_profileFile);
+    if (!os.is_open())
+    {
+        NS_LOG_WARN("Failed to open the event profile file " << m_profileFile);
+        return;
+    }
+    m_profiler->Report(os,
+                       std::chrono::duration<double>(m_profileWallTime).count(),
+                       m_profileWallTicks);
+}
+
+void
+DefaultSimulatorImpl::SetSchedulerTraceFile(std::string filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+    m_schedulerTrace.reset();
+    if (filename.empty())
+    {
+        return;
+    }
+    m_schedulerTrace = std::make_unique<SchedulerTrace>();
+    if (!m_schedulerTrace->Open(filename))
+    {
+        NS_LOG_WARN("Failed to open the scheduler trace file " << filename);
+        m_schedulerTrace.reset();
+    }
+}
+
 // System ID for non-distributed simulation is always zero
 uint32_t
 DefaultSimulatorImpl::GetSystemId() const
@@ -119,6 +196,10 @@ void
 DefaultSimulatorImpl::ProcessOneEvent()
 {
     Scheduler::Event next = m_events->RemoveNext();
+    if (m_schedulerTrace)
+    {
+        m_schedulerTrace->Add(SchedulerTrace::REMOVE_NEXT, next.key.m_ts, next.key.m_uid);
+    }
 
     PreEventHook(EventId(next.impl, next.key.m_ts, next.key.m_context, next.key.m_uid));
 
@@ -130,7 +211,18 @@ DefaultSimulatorImpl::ProcessOneEvent()
     m_currentTs = next.key.m_ts;
     m_currentContext = next.key.m_context;
     m_currentUid = next.key.m_uid;
-    next.impl->Invoke();
+    if (m_profiler)
+    {
+        uint64_t start = EventProfiler::ReadCounter();
+        next.impl->Invoke();
+        m_profiler->RecordExecute(next.impl,
+                                  next.key.m_ts,
+                                  EventProfiler::ReadCounter() - start);
+    }
+    else
+    {
+        next.impl->Invoke();
+    }
     next.impl->Unref();
 
     ProcessEventsWithContext();
@@ -169,6 +261,14 @@ DefaultSimulatorImpl::ProcessEventsWithContext()
         m_uid++;
         m_unscheduledEvents++;
         m_events->Insert(ev);
+        if (m_profiler)
+        {
+            m_profiler->RecordSchedule(ev.impl);
+        }
+        if (m_schedulerTrace)
+        {
+            m_schedulerTrace->Add(SchedulerTrace::INSERT, ev.key.m_ts, ev.key.m_uid);
+        }
     }
 }
 
@@ -181,11 +281,25 @@ DefaultSimulatorImpl::Run()
     ProcessEventsWithContext();
     m_stop = false;
 
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t ticksStart = EventProfiler::ReadCounter();
+
     while (!m_events->IsEmpty() && !m_stop)
     {
         ProcessOneEvent();
     }
 
+    if (m_profiler)
+    {
+        m_profileWallTime += std::chrono::steady_clock::now() - wallStart;
+        m_profileWallTicks += EventProfiler::ReadCounter() - ticksStart;
+        WriteEventProfile();
+    }
+    if (m_schedulerTrace)
+    {
+        m_schedulerTrace->Flush();
+    }
+
     // If the simulator stopped naturally by lack of events, make a
     // consistency test to check that we didn't lose any events along the way.
     NS_ASSERT(!m_events->IsEmpty() || m_unscheduledEvents == 0);
@@ -226,6 +340,14 @@ DefaultSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
     m_uid++;
     m_unscheduledEvents++;
     m_events->Insert(ev);
+    if (m_profiler)
+    {
+        m_profiler->RecordSchedule(event);
+    }
+    if (m_schedulerTrace)
+    {
+        m_schedulerTrace->Add(SchedulerTrace::INSERT, ev.key.m_ts, ev.key.m_uid);
+    }
     return EventId(event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
 }
 
@@ -245,6 +367,14 @@ DefaultSimulatorImpl::ScheduleWithContext(uint32_t context, const Time& delay, E
         m_uid++;
         m_unscheduledEvents++;
         m_events->Insert(ev);
+        if (m_profiler)
+        {
+            m_profiler->RecordSchedule(event);
+        }
+        if (m_schedulerTrace)
+        {
+            m_schedulerTrace->Add(SchedulerTrace::INSERT, ev.key.m_ts, ev.key.m_uid);
+        }
     }
     else
     {
@@ -328,6 +458,10 @@ DefaultSimulatorImpl::Remove(const EventId& id)
     event.key.m_context = id.GetContext();
     event.key.m_uid = id.GetUid();
     m_events->Remove(event);
+    if (m_schedulerTrace)
+    {
+        m_schedulerTrace->Add(SchedulerTrace::REMOVE, event.key.m_ts, event.key.m_uid);
+    }
     event.impl->Cancel();
     // whenever we remove an event from the event list, we have to unref it.
     event.impl->Unref();
@@ -341,6 +475,10 @@ DefaultSimulatorImpl::Cancel(const EventId& id)
     if (!IsExpired(id))
     {
         id.PeekEventImpl()->Cancel();
+        if (m_schedulerTrace && id.GetUid() != EventId::UID::DESTROY)
+        {
+            m_schedulerTrace->Add(SchedulerTrace::CANCEL, id.GetTs(), id.GetUid());
+        }
     }
 }
 
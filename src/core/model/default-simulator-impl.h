@@ -11,7 +11,9 @@
 
 #include "simulator-impl.h"
 
+#include <chrono>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <thread>
 
@@ -26,6 +28,8 @@ namespace ns3
 
 // Forward
 class Scheduler;
+class EventProfiler;
+class SchedulerTrace;
 
 /**
  * @ingroup simulator
@@ -74,6 +78,18 @@ class DefaultSimulatorImpl : public SimulatorImpl
     void ProcessOneEvent();
     /** Move events from a different context into the main event queue. */
     void ProcessEventsWithContext();
+    /**
+     * Enable the event profiler.
+     * @param [in] filename The profile report file, empty to disable.
+     */
+    void SetEventProfileFile(std::string filename);
+    /** Write the event profile report. */
+    void WriteEventProfile();
+    /**
+     * Enable the recording of the scheduler operations.
+     * @param [in] filename The trace file, empty to disable.
+     */
+    void SetSchedulerTraceFile(std::string filename);
 
     /** Wrap an event with its execution context. */
     struct EventWithContext
@@ -125,6 +141,20 @@ class DefaultSimulatorImpl : public SimulatorImpl
 
     /** Main execution thread. */
     std::thread::id m_mainThreadId;
+
+    /** The event profiler, null unless profiling is enabled. */
+    std::unique_ptr<EventProfiler> m_profiler;
+    /** The event profile report file. */
+    std::string m_profileFile;
+    /** Width of the event profile timeline buckets. */
+    Time m_profileBucket;
+    /** Wall-clock time spent in Run() while profiling. */
+    std::chrono::steady_clock::duration m_profileWallTime;
+    /** Profiler counter ticks spent in Run() while profiling. */
+    uint64_t m_profileWallTicks;
+
+    /** The scheduler operation log, null unless recording is enabled. */
+    std::unique_ptr<SchedulerTrace> m_schedulerTrace;
 };
 
 } // namespace ns3
@@ -10,6 +10,8 @@
 
 #include "log.h"
 
+#include <new>
+
 /**
  * @file
  * @ingroup events
@@ -21,6 +23,56 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("EventImpl");
 
+/** Size class granularity of the event pool, in bytes. */
+static constexpr std::size_t EVENT_POOL_GRANULARITY = 16;
+/** Number of size classes, larger events bypass the pool. */
+static constexpr std::size_t EVENT_POOL_CLASSES = 16;
+
+/** A free block, linked through its first bytes. */
+struct EventPoolBlock
+{
+    EventPoolBlock* next; /**< The next free block of the size class. */
+};
+
+/**
+ * False once the calling thread has released its pool.
+ *
+ * Kept outside of the pool: it is trivially destructible, so it can still
+ * be read by the events freed after the pool destructor ran.
+ */
+static thread_local bool g_eventPoolAlive = true;
+
+/** The event pool of one thread. */
+struct EventPool
+{
+    /** The free lists, one per size class. */
+    EventPoolBlock* heads[EVENT_POOL_CLASSES]{};
+    /** The allocation statistics. */
+    EventImpl::PoolStats stats{};
+    /** Whether freed events are recycled. */
+    bool enabled{true};
+
+    /** Release the free blocks to the global allocator. */
+    ~EventPool()
+    {
+        // events freed after this, at static destruction, bypass the pool
+        g_eventPoolAlive = false;
+        for (auto& head : heads)
+        {
+            while (head != nullptr)
+            {
+                EventPoolBlock* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+        stats.cached = 0;
+    }
+};
+
+/** The event pool of the calling thread. */
+static thread_local EventPool g_eventPool;
+
 EventImpl::~EventImpl()
 {
     NS_LOG_FUNCTION(this);
@@ -56,4 +108,66 @@ EventImpl::IsCancelled()
     return m_cancel;
 }
 
+const void*
+EventImpl::GetFunctionAddress() const
+{
+    return nullptr;
+}
+
+void*
+EventImpl::operator new(std::size_t size)
+{
+    std::size_t index = (size - 1) / EVENT_POOL_GRANULARITY;
+    if (!g_eventPoolAlive)
+    {
+        return ::operator new(size);
+    }
+    EventPool& pool = g_eventPool;
+    if (index >= EVENT_POOL_CLASSES)
+    {
+        pool.stats.allocated++;
+        return ::operator new(size);
+    }
+    EventPoolBlock* block = pool.heads[index];
+    if (block != nullptr && pool.enabled)
+    {
+        pool.heads[index] = block->next;
+        pool.stats.reused++;
+        pool.stats.cached--;
+        return block;
+    }
+    // always round up, the block may be recycled by any event of its class
+    pool.stats.allocated++;
+    return ::operator new((index + 1) * EVENT_POOL_GRANULARITY);
+}
+
+void
+EventImpl::operator delete(void* p, std::size_t size)
+{
+    std::size_t index = (size - 1) / EVENT_POOL_GRANULARITY;
+    if (!g_eventPoolAlive || index >= EVENT_POOL_CLASSES || !g_eventPool.enabled)
+    {
+        ::operator delete(p);
+        return;
+    }
+    EventPool& pool = g_eventPool;
+    auto block = static_cast<EventPoolBlock*>(p);
+    block->next = pool.heads[index];
+    pool.heads[index] = block;
+    pool.stats.cached++;
+}
+
+EventImpl::PoolStats
+EventImpl::GetPoolStats()
+{
+    return g_eventPool.stats;
+}
+
+void
+EventImpl::SetPoolEnabled(bool enabled)
+{
+    NS_LOG_FUNCTION(enabled);
+    g_eventPool.enabled = enabled;
+}
+
 } // namespace ns3
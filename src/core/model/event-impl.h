@@ -10,6 +10,7 @@
 
 #include "simple-ref-count.h"
 
+#include <cstddef>
 #include <stdint.h>
 
 /**
@@ -30,6 +31,14 @@ namespace ns3
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from a thread-local pool with one free list
+ * per size class of 16 bytes, up to 256 bytes.  The last Unref()
+ * puts the memory of the event back on the free list of the deleting
+ * thread, so a simulation reaching a steady event population
+ * stops calling the global allocator for its events.  Freed blocks
+ * are kept until the thread exits.  Larger events use the global
+ * allocator directly.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -55,6 +64,50 @@ class EventImpl : public SimpleRefCount<EventImpl>
      * Checked by the simulation engine before calling Invoke().
      */
     bool IsCancelled();
+    /**
+     * Get the code address of the function run by the event.
+     *
+     * Used by profilers to attribute the event to its handler; a virtual
+     * member function is resolved on the bound object.
+     * @returns The address, or nullptr if it is not known.
+     */
+    virtual const void* GetFunctionAddress() const;
+
+    /**
+     * Allocate an event from the pool of the calling thread.
+     * @param [in] size The size of the event object.
+     * @returns The memory for the event.
+     */
+    static void* operator new(std::size_t size);
+    /**
+     * Give the memory of an event back to the pool of the calling thread.
+     * @param [in] p The memory of the event.
+     * @param [in] size The size of the event object.
+     */
+    static void operator delete(void* p, std::size_t size);
+
+    /** Event allocation statistics of the calling thread. */
+    struct PoolStats
+    {
+        uint64_t allocated; /**< Events allocated by the global allocator. */
+        uint64_t reused;    /**< Events recycled from a free list. */
+        uint64_t cached;    /**< Blocks currently on the free lists. */
+    };
+
+    /**
+     * Get the event allocation statistics of the calling thread.
+     * @returns The statistics.
+     */
+    static PoolStats GetPoolStats();
+    /**
+     * Enable or disable the event pool of the calling thread.
+     *
+     * When disabled every event is allocated and freed by the global
+     * allocator, as a baseline for benchmarks.  The pool is enabled
+     * by default.
+     * @param [in] enabled Whether to recycle events.
+     */
+    static void SetPoolEnabled(bool enabled);
 
   protected:
     /**
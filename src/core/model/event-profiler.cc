@@ -0,0 +1,197 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "event-profiler.h"
+
+#include "demangle.h"
+#include "event-impl.h"
+#include "nstime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @file
+ * @ingroup simulator
+ * ns3::EventProfiler implementation.
+ */
+
+namespace ns3
+{
+
+/** Above this many buckets the timeline halves its resolution. */
+static constexpr std::size_t EVENT_PROFILER_MAX_BUCKETS = 1 << 16;
+
+EventProfiler::EventProfiler(uint64_t bucketWidth)
+    : m_lastKey(nullptr),
+      m_lastStats(nullptr),
+      m_bucketWidth(std::max<uint64_t>(bucketWidth, 1))
+{
+}
+
+uint64_t
+EventProfiler::ReadCounter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+EventProfiler::Stats&
+EventProfiler::Lookup(const EventImpl* event)
+{
+    const void* function = event->GetFunctionAddress();
+    const void* key = function != nullptr ? function : &typeid(*event);
+    if (key != m_lastKey)
+    {
+        m_lastKey = key;
+        Entry& entry = m_stats[key];
+        if (entry.type == nullptr)
+        {
+            entry.type = &typeid(*event);
+            entry.function = function;
+        }
+        m_lastStats = &entry.stats;
+    }
+    return *m_lastStats;
+}
+
+std::string
+EventProfiler::GetName(const Entry& entry)
+{
+    if (entry.function == nullptr)
+    {
+        return Demangle(entry.type->name());
+    }
+#ifndef _WIN32
+    Dl_info info;
+    if (dladdr(entry.function, &info) != 0 && info.dli_sname != nullptr)
+    {
+        return Demangle(info.dli_sname);
+    }
+#endif
+    std::ostringstream oss;
+    oss << Demangle(entry.type->name()) << " @" << entry.function;
+    return oss.str();
+}
+
+void
+EventProfiler::RecordSchedule(const EventImpl* event)
+{
+    Lookup(event).scheduled++;
+}
+
+void
+EventProfiler::RecordExecute(const EventImpl* event, uint64_t ts, uint64_t ticks)
+{
+    Stats& stats = Lookup(event);
+    stats.executed++;
+    stats.ticks += ticks;
+
+    uint64_t index = ts / m_bucketWidth;
+    while (index >= EVENT_PROFILER_MAX_BUCKETS)
+    {
+        // merge pairs of buckets to keep the timeline bounded
+        std::size_t half = (m_timeline.size() + 1) / 2;
+        for (std::size_t i = 0; i < half; i++)
+        {
+            Bucket merged = m_timeline[2 * i];
+            if (2 * i + 1 < m_timeline.size())
+            {
+                merged.executed += m_timeline[2 * i + 1].executed;
+                merged.ticks += m_timeline[2 * i + 1].ticks;
+            }
+            m_timeline[i] = merged;
+        }
+        m_timeline.resize(half);
+        m_bucketWidth *= 2;
+        index = ts / m_bucketWidth;
+    }
+    if (index >= m_timeline.size())
+    {
+        m_timeline.resize(index + 1);
+    }
+    m_timeline[index].executed++;
+    m_timeline[index].ticks += ticks;
+}
+
+std::unordered_map<std::string, EventProfiler::Stats>
+EventProfiler::GetStats() const
+{
+    // the same type may have one type_info per shared library
+    std::unordered_map<std::string, Stats> merged;
+    for (const auto& [key, entry] : m_stats)
+    {
+        Stats& stats = merged[GetName(entry)];
+        stats.scheduled += entry.stats.scheduled;
+        stats.executed += entry.stats.executed;
+        stats.ticks += entry.stats.ticks;
+    }
+    return merged;
+}
+
+const std::vector<EventProfiler::Bucket>&
+EventProfiler::GetTimeline() const
+{
+    return m_timeline;
+}
+
+void
+EventProfiler::Report(std::ostream& os, double wallSeconds, uint64_t wallTicks) const
+{
+    auto merged = GetStats();
+    std::vector<std::pair<std::string, Stats>> sorted(merged.begin(), merged.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second.ticks > b.second.ticks;
+    });
+
+    uint64_t totalTicks = 0;
+    uint64_t totalExecuted = 0;
+    for (const auto& [name, stats] : sorted)
+    {
+        totalTicks += stats.ticks;
+        totalExecuted += stats.executed;
+    }
+    double secondsPerTick = wallTicks > 0 ? wallSeconds / wallTicks : 0;
+
+    os << "# flat profile: " << totalExecuted << " events, " << wallSeconds << " s, "
+       << totalTicks * secondsPerTick << " s in events" << std::endl;
+    os << "# percent\tseconds\texecuted\tscheduled\tticks/event\thandler" << std::endl;
+    for (const auto& [name, stats] : sorted)
+    {
+        double percent = totalTicks > 0 ? 100.0 * stats.ticks / totalTicks : 0;
+        uint64_t perEvent = stats.executed > 0 ? stats.ticks / stats.executed : 0;
+        os << std::fixed << std::setprecision(2) << percent << "\t" << std::setprecision(6)
+           << stats.ticks * secondsPerTick << "\t" << stats.executed << "\t" << stats.scheduled
+           << "\t" << perEvent << "\t" << name << std::endl;
+    }
+
+    os << "# timeline: bucket width " << TimeStep(m_bucketWidth).GetSeconds() << " s" << std::endl;
+    os << "# start(s)\texecuted\tseconds" << std::endl;
+    for (std::size_t i = 0; i < m_timeline.size(); i++)
+    {
+        if (m_timeline[i].executed == 0)
+        {
+            continue;
+        }
+        os << std::setprecision(6) << TimeStep(i * m_bucketWidth).GetSeconds() << "\t"
+           << m_timeline[i].executed << "\t" << m_timeline[i].ticks * secondsPerTick << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * @ingroup simulator
+ * ns3::EventProfiler declaration.
+ */
+
+namespace ns3
+{
+
+class EventImpl;
+
+/**
+ * @ingroup simulator
+ *
+ * @brief Per event handler wall-clock profile of a simulation run.
+ *
+ * The events are keyed by the address of the function they run, from
+ * EventImpl::GetFunctionAddress(), so two member functions with the same
+ * signature, or the overrides of a virtual function, have their own rows.
+ * Events which do not know their function, such as lambdas, are keyed
+ * by the dynamic type of the EventImpl instead.
+ *
+ * The per event cost is a counter read before and after the event
+ * and a lookup keyed on the address, which is cached for back to back
+ * events of the same handler.  Addresses are only resolved to symbol
+ * names, with dladdr(), when the report is written; a handler without
+ * an exported symbol is named after its event type and address.
+ */
+class EventProfiler
+{
+  public:
+    /** Statistics of one event type. */
+    struct Stats
+    {
+        /** Events of this type scheduled. */
+        uint64_t scheduled{0};
+        /** Events of this type executed. */
+        uint64_t executed{0};
+        /** Counter ticks spent executing them. */
+        uint64_t ticks{0};
+    };
+
+    /** Statistics of one bucket of simulation time. */
+    struct Bucket
+    {
+        /** Events executed in the bucket. */
+        uint64_t executed{0};
+        /** Counter ticks spent executing them. */
+        uint64_t ticks{0};
+    };
+
+    /**
+     * Constructor.
+     * @param [in] bucketWidth Width of a timeline bucket, in time steps.
+     */
+    EventProfiler(uint64_t bucketWidth);
+
+    /**
+     * Record a scheduled event.
+     * @param [in] event The event.
+     */
+    void RecordSchedule(const EventImpl* event);
+
+    /**
+     * Read the profiling counter.
+     * @return The counter value, CPU cycles where available, nanoseconds otherwise.
+     */
+    static uint64_t ReadCounter();
+
+    /**
+     * Record an executed event.
+     * @param [in] event The event.
+     * @param [in] ts The event timestamp, in time steps.
+     * @param [in] ticks The counter ticks spent in the event.
+     */
+    void RecordExecute(const EventImpl* event, uint64_t ts, uint64_t ticks);
+
+    /**
+     * Get the statistics merged by handler name.
+     * @return The statistics, keyed by name.
+     */
+    std::unordered_map<std::string, Stats> GetStats() const;
+
+    /**
+     * Get the timeline.
+     * @return The bucket statistics, the bucket i covers [i, i + 1) * bucketWidth.
+     */
+    const std::vector<Bucket>& GetTimeline() const;
+
+    /**
+     * Write the flat profile sorted by execution time, then the timeline.
+     * @param [in] os The output stream.
+     * @param [in] wallSeconds Wall-clock seconds of the profiled run.
+     * @param [in] wallTicks Counter ticks of the profiled run,
+     *             used with wallSeconds to convert ticks to seconds.
+     */
+    void Report(std::ostream& os, double wallSeconds, uint64_t wallTicks) const;
+
+  private:
+    /** Statistics of one handler. */
+    struct Entry
+    {
+        Stats stats;                         //!< The statistics.
+        const std::type_info* type{nullptr}; //!< The event type.
+        const void* function{nullptr};       //!< The handler address, if known.
+    };
+
+    /**
+     * Find the statistics of the handler of an event.
+     * @param [in] event The event.
+     * @return The statistics.
+     */
+    Stats& Lookup(const EventImpl* event);
+    /**
+     * Get the name of a handler.
+     * @param [in] entry The handler.
+     * @return The demangled symbol name, or the event type name.
+     */
+    static std::string GetName(const Entry& entry);
+
+    /** Statistics keyed by handler address, or type_info address. */
+    std::unordered_map<const void*, Entry> m_stats;
+    /** The last looked up key. */
+    const void* m_lastKey;
+    /** The statistics of the last looked up key. */
+    Stats* m_lastStats;
+    /** Width of a timeline bucket, in time steps. */
+    uint64_t m_bucketWidth;
+    /** The timeline. */
+    std::vector<Bucket> m_timeline;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
@@ -0,0 +1,414 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "ladder-scheduler.h"
+
+#include "assert.h"
+#include "event-impl.h"
+#include "log.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+/**
+ * @file
+ * @ingroup scheduler
+ * ns3::LadderScheduler implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(LadderScheduler);
+
+/** Buckets with more events spawn a finer rung instead of being sorted. */
+static constexpr std::size_t LADDER_THRESHOLD = 50;
+/** Maximum number of rungs, deeper buckets are sorted whatever their size. */
+static constexpr std::size_t LADDER_MAX_RUNGS = 8;
+/** Minimum consumed Bottom prefix erased when an event is inserted in the Bottom. */
+static constexpr std::size_t LADDER_BOTTOM_COMPACT = 1024;
+
+TypeId
+LadderScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::LadderScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("Core")
+                            .AddConstructor<LadderScheduler>();
+    return tid;
+}
+
+LadderScheduler::LadderScheduler()
+    : m_topMin(0),
+      m_topMax(0),
+      m_topStart(0),
+      m_freeNode(NONE),
+      m_nRungs(0),
+      m_bottomHead(0),
+      m_qSize(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_rungs.reserve(LADDER_MAX_RUNGS);
+}
+
+LadderScheduler::~LadderScheduler()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+uint64_t
+LadderScheduler::Rung::CurrentStart() const
+{
+    return start + current * width;
+}
+
+uint32_t
+LadderScheduler::Rung::Index(uint64_t ts) const
+{
+    return (ts - start) / width;
+}
+
+uint32_t
+LadderScheduler::AllocateNode(const Scheduler::Event& ev)
+{
+    uint32_t node = m_freeNode;
+    if (node == NONE)
+    {
+        node = m_nodes.size();
+        m_nodes.push_back({ev, NONE});
+    }
+    else
+    {
+        m_freeNode = m_nodes[node].next;
+        m_nodes[node].ev = ev;
+    }
+    return node;
+}
+
+void
+LadderScheduler::Link(Rung& rung, uint32_t node)
+{
+    uint32_t index = rung.Index(m_nodes[node].ev.key.m_ts);
+    NS_ASSERT(index < rung.buckets.size());
+    m_nodes[node].next = rung.buckets[index];
+    rung.buckets[index] = node;
+    rung.count++;
+}
+
+std::size_t
+LadderScheduler::FindRung(uint64_t ts) const
+{
+    for (std::size_t i = 0; i < m_nRungs; i++)
+    {
+        if (ts >= m_rungs[i].CurrentStart())
+        {
+            return i;
+        }
+    }
+    return m_nRungs;
+}
+
+void
+LadderScheduler::Insert(const Scheduler::Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    uint64_t ts = ev.key.m_ts;
+    m_qSize++;
+    if (ts >= m_topStart)
+    {
+        if (m_top.empty())
+        {
+            m_topMin = ts;
+            m_topMax = ts;
+        }
+        m_topMin = std::min(m_topMin, ts);
+        m_topMax = std::max(m_topMax, ts);
+        m_top.push_back(ev);
+    }
+    else
+    {
+        std::size_t r = FindRung(ts);
+        if (r == m_nRungs && m_bottom.size() - m_bottomHead > LADDER_THRESHOLD &&
+            m_nRungs < LADDER_MAX_RUNGS && m_bottom[m_bottomHead].key.m_ts != m_bottom.back().key.m_ts)
+        {
+            // a sorted insert would move too many events, spread the Bottom on a new rung
+            BottomToRung();
+            r = FindRung(ts);
+        }
+        if (r < m_nRungs)
+        {
+            Link(m_rungs[r], AllocateNode(ev));
+        }
+        else
+        {
+            InsertBottom(ev);
+        }
+    }
+    Refill();
+}
+
+void
+LadderScheduler::InsertBottom(const Scheduler::Event& ev)
+{
+    if (m_bottomHead >= LADDER_BOTTOM_COMPACT && m_bottomHead * 2 >= m_bottom.size())
+    {
+        m_bottom.erase(m_bottom.begin(), m_bottom.begin() + m_bottomHead);
+        m_bottomHead = 0;
+    }
+    // events at the current time have the largest uid, this is usually an append
+    auto it = std::upper_bound(m_bottom.begin() + m_bottomHead, m_bottom.end(), ev);
+    m_bottom.insert(it, ev);
+}
+
+bool
+LadderScheduler::IsEmpty() const
+{
+    NS_LOG_FUNCTION(this);
+    return m_qSize == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext() const
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!IsEmpty());
+    return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!IsEmpty());
+    Scheduler::Event ev = m_bottom[m_bottomHead++];
+    m_qSize--;
+    Refill();
+    NS_LOG_DEBUG("remove " << ev.impl << ", " << ev.key.m_ts << ", " << ev.key.m_uid);
+    return ev;
+}
+
+void
+LadderScheduler::Remove(const Scheduler::Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    NS_ASSERT(!IsEmpty());
+    uint64_t ts = ev.key.m_ts;
+    if (ts >= m_topStart)
+    {
+        auto it = std::find(m_top.begin(), m_top.end(), ev);
+        NS_ASSERT(it != m_top.end());
+        *it = m_top.back();
+        m_top.pop_back();
+    }
+    else
+    {
+        std::size_t r = FindRung(ts);
+        if (r < m_nRungs)
+        {
+            Rung& rung = m_rungs[r];
+            uint32_t* link = &rung.buckets[rung.Index(ts)];
+            while (m_nodes[*link].ev != ev)
+            {
+                link = &m_nodes[*link].next;
+                NS_ASSERT(*link != NONE);
+            }
+            uint32_t node = *link;
+            *link = m_nodes[node].next;
+            m_nodes[node].next = m_freeNode;
+            m_freeNode = node;
+            rung.count--;
+        }
+        else
+        {
+            auto it = std::find(m_bottom.begin() + m_bottomHead, m_bottom.end(), ev);
+            NS_ASSERT(it != m_bottom.end());
+            m_bottom.erase(it);
+        }
+    }
+    m_qSize--;
+    Refill();
+}
+
+void
+LadderScheduler::Refill()
+{
+    if (m_bottomHead < m_bottom.size() || m_qSize == 0)
+    {
+        return;
+    }
+    m_bottom.clear();
+    m_bottomHead = 0;
+
+    while (true)
+    {
+        if (m_nRungs == 0)
+        {
+            TransferTop();
+            if (!m_bottom.empty())
+            {
+                return;
+            }
+            continue;
+        }
+        Rung& rung = m_rungs[m_nRungs - 1];
+        if (rung.count == 0)
+        {
+            // the parent rung resumes after the bucket this rung was spawned from
+            m_nRungs--;
+            continue;
+        }
+        while (rung.buckets[rung.current] == NONE)
+        {
+            rung.current++;
+        }
+        uint32_t head = rung.buckets[rung.current];
+        rung.buckets[rung.current] = NONE;
+        rung.current++;
+        uint64_t end = rung.CurrentStart();
+
+        uint32_t size = 0;
+        uint64_t minTs = UINT64_MAX;
+        uint64_t maxTs = 0;
+        for (uint32_t node = head; node != NONE; node = m_nodes[node].next)
+        {
+            size++;
+            minTs = std::min(minTs, m_nodes[node].ev.key.m_ts);
+            maxTs = std::max(maxTs, m_nodes[node].ev.key.m_ts);
+        }
+        rung.count -= size;
+
+        // a burst at one timestamp cannot be split any further
+        if (size > LADDER_THRESHOLD && m_nRungs < LADDER_MAX_RUNGS && minTs != maxTs)
+        {
+            SpawnRung(head, size, minTs, end);
+            continue;
+        }
+        MoveToBottom(head);
+        SortBottom();
+        return;
+    }
+}
+
+void
+LadderScheduler::TransferTop()
+{
+    NS_LOG_FUNCTION(this << m_top.size());
+    NS_ASSERT(!m_top.empty());
+    if (m_top.size() <= LADDER_THRESHOLD || m_topMin == m_topMax)
+    {
+        m_topStart = m_topMax + 1;
+        // keep the capacity of both vectors
+        m_bottom.swap(m_top);
+        SortBottom();
+        return;
+    }
+
+    // one bucket per event, covering [m_topMin, m_topMax]
+    uint64_t nBuckets = m_top.size();
+    if (m_rungs.empty())
+    {
+        m_rungs.emplace_back();
+    }
+    Rung& rung = m_rungs[0];
+    rung.start = m_topMin;
+    rung.width = (m_topMax - m_topMin) / nBuckets + 1;
+    rung.current = 0;
+    rung.count = 0;
+    rung.buckets.assign(nBuckets, NONE);
+    for (const auto& ev : m_top)
+    {
+        Link(rung, AllocateNode(ev));
+    }
+    m_nRungs = 1;
+    m_topStart = rung.start + nBuckets * rung.width;
+    m_top.clear();
+}
+
+void
+LadderScheduler::SpawnRung(uint32_t head, uint32_t size, uint64_t minTs, uint64_t end)
+{
+    NS_LOG_FUNCTION(this << size << minTs << end);
+    if (m_rungs.size() == m_nRungs)
+    {
+        m_rungs.emplace_back();
+    }
+    Rung& rung = m_rungs[m_nRungs];
+    // the new rung must cover up to the end of the bucket, later inserts may land there
+    rung.start = minTs;
+    rung.width = (end - minTs) / size + 1;
+    rung.current = 0;
+    rung.count = 0;
+    rung.buckets.assign(size, NONE);
+    uint32_t node = head;
+    while (node != NONE)
+    {
+        uint32_t next = m_nodes[node].next;
+        Link(rung, node);
+        node = next;
+    }
+    m_nRungs++;
+}
+
+void
+LadderScheduler::BottomToRung()
+{
+    NS_LOG_FUNCTION(this << m_bottom.size() - m_bottomHead);
+    // the Bottom is earlier than the finest rung, or the Top if there is no rung
+    uint64_t start = m_bottom[m_bottomHead].key.m_ts;
+    uint64_t end = m_nRungs > 0 ? m_rungs[m_nRungs - 1].CurrentStart() : m_topStart;
+    uint64_t nBuckets = m_bottom.size() - m_bottomHead;
+    if (m_rungs.size() == m_nRungs)
+    {
+        m_rungs.emplace_back();
+    }
+    Rung& rung = m_rungs[m_nRungs];
+    rung.start = start;
+    rung.width = (end - start) / nBuckets + 1;
+    rung.current = 0;
+    rung.count = 0;
+    rung.buckets.assign(nBuckets, NONE);
+    for (std::size_t i = m_bottomHead; i < m_bottom.size(); i++)
+    {
+        Link(rung, AllocateNode(m_bottom[i]));
+    }
+    m_nRungs++;
+    m_bottom.clear();
+    m_bottomHead = 0;
+}
+
+void
+LadderScheduler::MoveToBottom(uint32_t head)
+{
+    NS_ASSERT(m_bottom.empty());
+    uint32_t node = head;
+    uint32_t last = NONE;
+    while (node != NONE)
+    {
+        m_bottom.push_back(m_nodes[node].ev);
+        last = node;
+        node = m_nodes[node].next;
+    }
+    // give the whole list back to the free list
+    m_nodes[last].next = m_freeNode;
+    m_freeNode = head;
+}
+
+void
+LadderScheduler::SortBottom()
+{
+    // buckets are filled at the front, a burst comes out in decreasing uid order
+    if (std::is_sorted(m_bottom.begin(), m_bottom.end(), std::greater<>()))
+    {
+        std::reverse(m_bottom.begin(), m_bottom.end());
+    }
+    else if (!std::is_sorted(m_bottom.begin(), m_bottom.end()))
+    {
+        std::sort(m_bottom.begin(), m_bottom.end());
+    }
+}
+
+} // namespace ns3
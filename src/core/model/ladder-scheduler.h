@@ -0,0 +1,210 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file
+ * @ingroup scheduler
+ * ns3::LadderScheduler declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * @ingroup scheduler
+ * @brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of
+ * ["Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Tang, Goh and Thng][Tang].
+ *
+ * [Tang]: https://doi.org/10.1145/1103323.1103324 "Tang"
+ *
+ * Events are kept in three tiers:
+ *
+ * - Top: an unsorted `std::vector` of the events later than
+ *   every event in the ladder, typically the far future events.
+ * - Ladder: a stack of rungs, each an array of unsorted buckets of
+ *   uniform width.  When the Top is needed it becomes the first rung,
+ *   with one bucket per event.  A bucket holding more than
+ *   the threshold spawns a finer rung instead of being sorted.
+ *   A bucket is a linked list of nodes from a pool shared by all
+ *   the rungs, so events move between rungs without allocation.
+ * - Bottom: a small sorted `std::vector` the events are dequeued from.
+ *
+ * A bucket only gets sorted once it is known to hold the next events
+ * and it is small, so the sort cost per event is bounded by the threshold.
+ * There is no global resize: a rung is created from the events of one
+ * bucket and released when its buckets are consumed.
+ *
+ * Bursts of events at one timestamp, such as the fragments of one
+ * transfer, cannot be split by a finer rung; their bucket is moved
+ * to the Bottom as is, where they are already in increasing uid order.
+ * Events scheduled at the current time are appended to the Bottom;
+ * a Bottom grown past the threshold over several timestamps is spread
+ * on a new rung rather than kept sorted.
+ *
+ * @par Time Complexity
+ *
+ * Operation    | Amortized %Time | Reason
+ * :----------- | :-------------- | :-----
+ * Insert()     | ~Constant       | Append to Top or a bucket, or sorted Bottom insert
+ * IsEmpty()    | Constant        | Explicit queue size
+ * PeekNext()   | Constant        | Head of the Bottom
+ * Remove()     | ~Constant       | Search within one bucket
+ * RemoveNext() | ~Constant       | Bottom refill spreads over the events
+ *
+ * @par Memory Complexity
+ *
+ * Category  | Memory                           | Reason
+ * :-------- | :------------------------------- | :-----
+ * Overhead  | 4 x `std::vector` + rungs<br/>(96 bytes) | Top, Bottom, node pool, ladder
+ * Per Event | 32 bytes                         | Event and list link, in the node pool
+ */
+class LadderScheduler : public Scheduler
+{
+  public:
+    /**
+     *  Register this type.
+     *  @return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    /** Constructor. */
+    LadderScheduler();
+    /** Destructor. */
+    ~LadderScheduler() override;
+
+    // Inherited
+    void Insert(const Scheduler::Event& ev) override;
+    bool IsEmpty() const override;
+    Scheduler::Event PeekNext() const override;
+    Scheduler::Event RemoveNext() override;
+    void Remove(const Scheduler::Event& ev) override;
+
+  private:
+    /** An event in a bucket, a node of a singly linked list. */
+    struct Node
+    {
+        /** The event. */
+        Scheduler::Event ev;
+        /** Index of the next node in the bucket, or NONE. */
+        uint32_t next;
+    };
+
+    /** The null node index. */
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /** A rung of the ladder. */
+    struct Rung
+    {
+        /** Timestamp of the start of the first bucket. */
+        uint64_t start;
+        /** Duration of a bucket, in dimensionless time units. */
+        uint64_t width;
+        /** Index of the first bucket not yet consumed. */
+        uint32_t current;
+        /** Number of events in the rung. */
+        uint32_t count;
+        /** The first node of each bucket. */
+        std::vector<uint32_t> buckets;
+
+        /**
+         * Get the start of the first bucket not yet consumed.
+         * @return The timestamp.
+         */
+        uint64_t CurrentStart() const;
+        /**
+         * Get the bucket of a timestamp.
+         * @param [in] ts The timestamp.
+         * @return The bucket index.
+         */
+        uint32_t Index(uint64_t ts) const;
+    };
+
+    /**
+     * Add an event to the front of a bucket.
+     * @param [in] rung The rung.
+     * @param [in] node The node of the event.
+     */
+    void Link(Rung& rung, uint32_t node);
+    /**
+     * Get a node for an event.
+     * @param [in] ev The event.
+     * @return The node index.
+     */
+    uint32_t AllocateNode(const Scheduler::Event& ev);
+    /**
+     * Insert in the sorted Bottom.
+     * @param [in] ev The event.
+     */
+    void InsertBottom(const Scheduler::Event& ev);
+    /**
+     * Move the next events to the Bottom, if the Bottom is empty.
+     *
+     * This keeps the head of the Bottom the next event whenever
+     * the scheduler is not empty.
+     */
+    void Refill();
+    /** Move the events of the Top to a new rung, or the Bottom if only a few. */
+    void TransferTop();
+    /**
+     * Move the events of a bucket to a new finer rung.
+     * @param [in] head The first node of the bucket.
+     * @param [in] size The number of events in the bucket.
+     * @param [in] minTs The earliest timestamp in the bucket.
+     * @param [in] end The end of the bucket.
+     */
+    void SpawnRung(uint32_t head, uint32_t size, uint64_t minTs, uint64_t end);
+    /**
+     * Move the events of a bucket to the empty Bottom and free the nodes.
+     * @param [in] head The first node of the bucket.
+     */
+    void MoveToBottom(uint32_t head);
+    /** Move the events of the Bottom to a new finer rung. */
+    void BottomToRung();
+    /** Sort the Bottom after it was filled in any order. */
+    void SortBottom();
+    /**
+     * Find the rung an event belongs to.
+     * @param [in] ts The timestamp.
+     * @return The index of the rung, or the number of rungs for the Bottom.
+     */
+    std::size_t FindRung(uint64_t ts) const;
+
+    /** The Top, events at or after m_topStart. */
+    std::vector<Scheduler::Event> m_top;
+    /** The earliest timestamp in the Top. */
+    uint64_t m_topMin;
+    /** The latest timestamp in the Top. */
+    uint64_t m_topMax;
+    /** Events earlier than this timestamp go to the ladder or the Bottom. */
+    uint64_t m_topStart;
+    /** The nodes of the bucket events. */
+    std::vector<Node> m_nodes;
+    /** The first free node. */
+    uint32_t m_freeNode;
+    /** The rungs, the last one is the finest. */
+    std::vector<Rung> m_rungs;
+    /** The number of rungs in use. */
+    std::size_t m_nRungs;
+    /** The Bottom, sorted, consumed from m_bottomHead. */
+    std::vector<Scheduler::Event> m_bottom;
+    /** Index of the next event in the Bottom. */
+    std::size_t m_bottomHead;
+    /** Number of events in the queue. */
+    uint32_t m_qSize;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -10,6 +10,9 @@
 
 #include "warnings.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <tuple>
 #include <type_traits>
@@ -126,6 +129,77 @@ struct EventMemberImplObjTraits<T*>
     }
 };
 
+/**
+ * @ingroup events
+ * Get the class of a pointer to member.
+ *
+ * @tparam M \explicit The pointer to member type.
+ */
+template <typename M>
+struct MemberClass;
+
+/**
+ * @ingroup events
+ * Get the class of a pointer to member.
+ *
+ * @tparam R \explicit The member type, a function type for member functions.
+ * @tparam C \explicit The class.
+ */
+template <typename R, typename C>
+struct MemberClass<R C::*>
+{
+    using type = C; //!< The class.
+};
+
+/**
+ * @ingroup events
+ * Get the code address a member function pointer calls on an object.
+ *
+ * Decodes the Itanium C++ ABI representation of a pointer to member
+ * function, resolving a virtual function in the vtable of the object.
+ *
+ * @tparam MEM \explicit The pointer to member type.
+ * @param [in] mem The pointer to member.
+ * @param [in] obj The object, converted to the class of the member.
+ * @returns The function address, or nullptr with another ABI.
+ */
+template <typename MEM>
+const void*
+GetMemberFunctionAddress(MEM mem, const typename MemberClass<MEM>::type& obj)
+{
+#if defined(__GNUC__) && !defined(_WIN32)
+    if constexpr (std::is_member_function_pointer_v<MEM> && sizeof(MEM) == 2 * sizeof(void*))
+    {
+        struct
+        {
+            uintptr_t ptr;
+            ptrdiff_t adj;
+        } raw;
+
+        std::memcpy(&raw, &mem, sizeof(raw));
+#if defined(__arm__) || defined(__aarch64__)
+        // the virtual bit is in adj, which is shifted by one
+        bool isVirtual = raw.adj & 1;
+        ptrdiff_t adj = raw.adj >> 1;
+        uintptr_t offset = raw.ptr;
+#else
+        // the virtual bit is in ptr, which is then the vtable offset plus one
+        bool isVirtual = raw.ptr & 1;
+        ptrdiff_t adj = raw.adj;
+        uintptr_t offset = raw.ptr - 1;
+#endif
+        if (!isVirtual)
+        {
+            return reinterpret_cast<const void*>(raw.ptr);
+        }
+        auto self = reinterpret_cast<const char*>(&obj) + adj;
+        auto vtable = *reinterpret_cast<const char* const*>(self);
+        return *reinterpret_cast<const void* const*>(vtable + offset);
+    }
+#endif
+    return nullptr;
+}
+
 } // namespace internal
 
 template <typename MEM, typename OBJ, typename... Ts>
@@ -138,7 +212,9 @@ MakeEvent(MEM mem_ptr, OBJ obj, Ts... args)
         EventMemberImpl() = delete;
 
         EventMemberImpl(OBJ obj, MEM function, Ts... args)
-            : m_function(std::bind(function, obj, args...))
+            : m_function(function),
+              m_obj(obj),
+              m_arguments(args...)
         {
         }
 
@@ -147,13 +223,26 @@ MakeEvent(MEM mem_ptr, OBJ obj, Ts... args)
         {
         }
 
+        const void* GetFunctionAddress() const override
+        {
+            return internal::GetMemberFunctionAddress(
+                m_function,
+                internal::EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
       private:
         void Notify() override
         {
-            m_function();
+            // the stored arguments are passed by reference, not copied on every call
+            std::apply([this](auto&... args) { std::invoke(m_function, m_obj, args...); },
+                       m_arguments);
         }
 
-        std::function<void()> m_function;
+        // stored directly rather than in a std::function, which would
+        // allocate once more for most bound arguments
+        MEM m_function;
+        OBJ m_obj;
+        std::tuple<std::remove_reference_t<Ts>...> m_arguments;
     }* ev = new EventMemberImpl(obj, mem_ptr, args...);
 
     return ev;
@@ -177,10 +266,15 @@ MakeEvent(void (*f)(Us...), Ts... args)
         {
         }
 
+        const void* GetFunctionAddress() const override
+        {
+            return reinterpret_cast<const void*>(m_function);
+        }
+
       private:
         void Notify() override
         {
-            std::apply([this](Ts... args) { (*m_function)(args...); }, m_arguments);
+            std::apply([this](auto&... args) { (*m_function)(args...); }, m_arguments);
         }
 
         void (*m_function)(Us...);
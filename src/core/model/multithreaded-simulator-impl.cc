@@ -0,0 +1,605 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "assert.h"
+#include "log.h"
+#include "nstime.h"
+#include "scheduler.h"
+#include "simulator.h"
+#include "uinteger.h"
+
+#include <algorithm>
+#include <barrier>
+#include <thread>
+
+/**
+ * @file
+ * @ingroup simulator
+ * ns3::MultithreadedSimulatorImpl implementation.
+ */
+
+namespace ns3
+{
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED(MultithreadedSimulatorImpl);
+
+thread_local MultithreadedSimulatorImpl::Partition* MultithreadedSimulatorImpl::m_current =
+    nullptr;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::MultithreadedSimulatorImpl")
+            .SetParent<SimulatorImpl>()
+            .SetGroupName("Core")
+            .AddConstructor<MultithreadedSimulatorImpl>()
+            .AddAttribute("MaxThreads",
+                          "The largest number of threads, 0 for the hardware concurrency.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&MultithreadedSimulatorImpl::m_maxThreads),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("Lookahead",
+                          "The largest lookahead, lowered by UpdateLookahead().",
+                          TimeValue(Time::Max()),
+                          MakeTimeAccessor(&MultithreadedSimulatorImpl::m_lookahead),
+                          MakeTimeChecker(TimeStep(1)));
+    return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl()
+    : m_dirty(true),
+      m_lookahead(Time::Max()),
+      m_maxThreads(0),
+      m_threadNum(1),
+      m_running(false),
+      m_windowEnd(0),
+      m_finished(false),
+      m_stop(false),
+      m_stopTs(UINT64_MAX),
+      m_lastTs(0),
+      m_uid(EventId::UID::VALID)
+{
+    NS_LOG_FUNCTION(this);
+    m_schedulerFactory.SetTypeId("ns3::MapScheduler");
+    AddPartitions(0);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    for (auto& partition : m_partitions)
+    {
+        for (auto& queue : partition->inbound)
+        {
+            RemoteEvent remote;
+            while (queue->Pop(remote))
+            {
+                remote.event->Unref();
+            }
+        }
+        while (!partition->events->IsEmpty())
+        {
+            Scheduler::Event next = partition->events->RemoveNext();
+            next.impl->Unref();
+        }
+    }
+    m_partitions.clear();
+    SimulatorImpl::DoDispose();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy()
+{
+    NS_LOG_FUNCTION(this);
+    while (!m_destroyEvents.empty())
+    {
+        Ptr<EventImpl> ev = m_destroyEvents.front().PeekEventImpl();
+        m_destroyEvents.pop_front();
+        NS_LOG_LOGIC("handle destroy " << ev);
+        if (!ev->IsCancelled())
+        {
+            ev->Invoke();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::AddPartitions(uint32_t partition)
+{
+    while (m_partitions.size() <= partition)
+    {
+        auto added = std::make_unique<Partition>();
+        added->id = m_partitions.size();
+        added->events = m_schedulerFactory.Create<Scheduler>();
+        added->currentContext = Simulator::NO_CONTEXT;
+        m_partitions.push_back(std::move(added));
+        m_dirty = true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler(ObjectFactory schedulerFactory)
+{
+    NS_LOG_FUNCTION(this << schedulerFactory);
+    NS_ASSERT_MSG(!m_running, "Cannot change the scheduler while running");
+    m_schedulerFactory = schedulerFactory;
+    for (auto& partition : m_partitions)
+    {
+        Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler>();
+        while (!partition->events->IsEmpty())
+        {
+            scheduler->Insert(partition->events->RemoveNext());
+        }
+        partition->events = scheduler;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetPartition(uint32_t context, uint32_t partition)
+{
+    NS_LOG_FUNCTION(this << context << partition);
+    NS_ASSERT_MSG(!m_running, "Partitions must be assigned before Run()");
+    NS_ASSERT_MSG(context != Simulator::NO_CONTEXT, "Cannot assign the absence of context");
+    if (m_contextPartition.size() <= context)
+    {
+        m_contextPartition.resize(context + 1, 0);
+    }
+    m_contextPartition[context] = partition;
+    AddPartitions(partition);
+    m_dirty = true;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount() const
+{
+    return m_partitions.size();
+}
+
+void
+MultithreadedSimulatorImpl::UpdateLookahead(Time delay)
+{
+    NS_LOG_FUNCTION(this << delay);
+    NS_ASSERT_MSG(delay.IsStrictlyPositive(), "The lookahead must be positive");
+    m_lookahead = std::min(m_lookahead, delay);
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead() const
+{
+    return m_lookahead;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::PartitionOf(uint32_t context) const
+{
+    return context < m_contextPartition.size() ? m_contextPartition[context] : 0;
+}
+
+MultithreadedSimulatorImpl::Partition&
+MultithreadedSimulatorImpl::Current(uint32_t context) const
+{
+    if (m_current != nullptr)
+    {
+        return *m_current;
+    }
+    return *m_partitions[PartitionOf(context)];
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert(Partition& partition,
+                                   uint64_t ts,
+                                   uint32_t context,
+                                   EventImpl* event)
+{
+    Scheduler::Event ev;
+    ev.impl = event;
+    ev.key.m_ts = ts;
+    ev.key.m_context = context;
+    // outside of Run() the uids are unique across the partitions,
+    // so the events can move to another partition
+    ev.key.m_uid = m_running ? partition.uid++ : m_uid++;
+    partition.unscheduledEvents++;
+    partition.events->Insert(ev);
+    return EventId(event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::Setup()
+{
+    NS_LOG_FUNCTION(this);
+    uint32_t partitionNum = m_partitions.size();
+    if (m_dirty)
+    {
+        // move the events scheduled before the partitions were assigned
+        std::vector<Scheduler::Event> events;
+        for (auto& partition : m_partitions)
+        {
+            while (!partition->events->IsEmpty())
+            {
+                events.push_back(partition->events->RemoveNext());
+            }
+            partition->unscheduledEvents = 0;
+        }
+        for (const auto& ev : events)
+        {
+            Partition& partition = *m_partitions[PartitionOf(ev.key.m_context)];
+            partition.events->Insert(ev);
+            partition.unscheduledEvents++;
+        }
+        for (auto& partition : m_partitions)
+        {
+            while (partition->inbound.size() < partitionNum)
+            {
+                partition->inbound.push_back(std::make_unique<SpscQueue<RemoteEvent>>());
+            }
+        }
+        m_dirty = false;
+    }
+    for (auto& partition : m_partitions)
+    {
+        partition->uid = std::max(partition->uid, m_uid);
+        partition->currentTs = std::max(partition->currentTs, m_lastTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow(Partition& partition)
+{
+    uint64_t end = std::min(m_windowEnd, m_stopTs.load(std::memory_order_relaxed));
+    while (!partition.events->IsEmpty() && !m_stop.load(std::memory_order_relaxed))
+    {
+        if (partition.events->PeekNext().key.m_ts >= end)
+        {
+            break;
+        }
+        Scheduler::Event next = partition.events->RemoveNext();
+
+        PreEventHook(EventId(next.impl, next.key.m_ts, next.key.m_context, next.key.m_uid));
+
+        NS_ASSERT(next.key.m_ts >= partition.currentTs);
+        partition.unscheduledEvents--;
+        partition.eventCount++;
+        partition.currentTs = next.key.m_ts;
+        partition.currentContext = next.key.m_context;
+        partition.currentUid = next.key.m_uid;
+        next.impl->Invoke();
+        next.impl->Unref();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ReceiveEvents(Partition& partition)
+{
+    // a fixed order of the sources keeps the uids independent of the threads
+    for (auto& queue : partition.inbound)
+    {
+        RemoteEvent remote;
+        while (queue->Pop(remote))
+        {
+            Insert(partition, remote.ts, remote.context, remote.event);
+        }
+    }
+    partition.nextTs =
+        partition.events->IsEmpty() ? UINT64_MAX : partition.events->PeekNext().key.m_ts;
+}
+
+void
+MultithreadedSimulatorImpl::NextWindow()
+{
+    uint64_t next = UINT64_MAX;
+    for (const auto& partition : m_partitions)
+    {
+        next = std::min(next, partition->nextTs);
+    }
+    uint64_t lookahead = m_lookahead.GetTimeStep();
+    m_finished = next == UINT64_MAX || m_stop.load() || next >= m_stopTs.load();
+    m_windowEnd = next > UINT64_MAX - lookahead ? UINT64_MAX : next + lookahead;
+}
+
+void
+MultithreadedSimulatorImpl::Run()
+{
+    NS_LOG_FUNCTION(this);
+    Setup();
+    m_stop = false;
+    m_running = true;
+
+    uint32_t partitionNum = m_partitions.size();
+    uint32_t maxThreads = m_maxThreads > 0 ? m_maxThreads : std::thread::hardware_concurrency();
+    m_threadNum = std::clamp<uint32_t>(maxThreads, 1, partitionNum);
+    NS_LOG_INFO(partitionNum << " partitions on " << m_threadNum << " threads, lookahead "
+                             << m_lookahead.As(Time::US));
+
+    for (auto& partition : m_partitions)
+    {
+        ReceiveEvents(*partition);
+    }
+    NextWindow();
+
+    /** Compute the next window once all the threads received their events. */
+    struct WindowCompletion
+    {
+        MultithreadedSimulatorImpl* impl; //!< The simulator.
+
+        /** Barrier completion step. */
+        void operator()() noexcept
+        {
+            impl->NextWindow();
+        }
+    };
+
+    std::barrier<> exchange(m_threadNum);
+    std::barrier<WindowCompletion> window(m_threadNum, WindowCompletion{this});
+    auto worker = [this, &exchange, &window](uint32_t index) {
+        std::vector<Partition*> mine;
+        for (uint32_t p = index; p < m_partitions.size(); p += m_threadNum)
+        {
+            mine.push_back(m_partitions[p].get());
+        }
+        while (!m_finished)
+        {
+            for (auto partition : mine)
+            {
+                m_current = partition;
+                ProcessWindow(*partition);
+            }
+            m_current = nullptr;
+            // every event sent in this window is in a queue after this barrier
+            exchange.arrive_and_wait();
+            for (auto partition : mine)
+            {
+                ReceiveEvents(*partition);
+            }
+            window.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t index = 1; index < m_threadNum; index++)
+    {
+        threads.emplace_back(worker, index);
+    }
+    worker(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    m_running = false;
+    for (const auto& partition : m_partitions)
+    {
+        m_lastTs = std::max(m_lastTs, partition->currentTs);
+        m_uid = std::max(m_uid, partition->uid);
+    }
+
+    // If the simulator stopped naturally by lack of events, make a
+    // consistency test to check that we didn't lose any events along the way.
+    for (const auto& partition : m_partitions)
+    {
+        NS_ASSERT(m_stop || m_stopTs != UINT64_MAX || partition->unscheduledEvents == 0);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished() const
+{
+    if (m_stop)
+    {
+        return true;
+    }
+    for (const auto& partition : m_partitions)
+    {
+        if (!partition->events->IsEmpty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    m_stop = true;
+}
+
+EventId
+MultithreadedSimulatorImpl::Stop(const Time& delay)
+{
+    NS_LOG_FUNCTION(this << delay.GetTimeStep());
+    uint64_t stopTs = (Now() + delay).GetTimeStep();
+    uint64_t current = m_stopTs.load();
+    while (stopTs < current && !m_stopTs.compare_exchange_weak(current, stopTs))
+    {
+    }
+    return EventId();
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
+{
+    NS_ASSERT_MSG(delay.IsPositive(), "MultithreadedSimulatorImpl::Schedule(): Negative delay");
+    uint32_t context = GetContext();
+    uint64_t ts = (delay + Now()).GetTimeStep();
+    return Insert(Current(context), ts, context, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext(uint32_t context,
+                                                const Time& delay,
+                                                EventImpl* event)
+{
+    NS_ASSERT_MSG(delay.IsPositive(),
+                  "MultithreadedSimulatorImpl::ScheduleWithContext(): Negative delay");
+    uint64_t ts = (delay + Now()).GetTimeStep();
+    uint32_t target = PartitionOf(context);
+    if (!m_running)
+    {
+        AddPartitions(target);
+        Insert(*m_partitions[target], ts, context, event);
+        return;
+    }
+    NS_ASSERT_MSG(m_current != nullptr,
+                  "Simulator::ScheduleWithContext from a thread not run by the simulator");
+    if (target == m_current->id)
+    {
+        Insert(*m_current, ts, context, event);
+        return;
+    }
+    NS_ASSERT_MSG(delay >= m_lookahead,
+                  "Event for partition " << target << " from partition " << m_current->id
+                                         << " with a delay " << delay.As(Time::US)
+                                         << " below the lookahead " << m_lookahead.As(Time::US));
+    m_partitions[target]->inbound[m_current->id]->Push({ts, context, event});
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow(EventImpl* event)
+{
+    return Schedule(Time(0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy(EventImpl* event)
+{
+    std::unique_lock lock{m_destroyMutex};
+    EventId id(Ptr<EventImpl>(event, false), Now().GetTimeStep(), 0xffffffff, 2);
+    m_destroyEvents.push_back(id);
+    return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now() const
+{
+    // Do not add function logging here, to avoid stack overflow
+    return TimeStep(m_current != nullptr ? m_current->currentTs : m_lastTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft(const EventId& id) const
+{
+    if (IsExpired(id))
+    {
+        return TimeStep(0);
+    }
+    return TimeStep(id.GetTs()) - Now();
+}
+
+void
+MultithreadedSimulatorImpl::Remove(const EventId& id)
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        std::unique_lock lock{m_destroyMutex};
+        // destroy events.
+        for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); i++)
+        {
+            if (*i == id)
+            {
+                m_destroyEvents.erase(i);
+                break;
+            }
+        }
+        return;
+    }
+    if (IsExpired(id))
+    {
+        return;
+    }
+    Partition& partition = Current(id.GetContext());
+    Scheduler::Event event;
+    event.impl = id.PeekEventImpl();
+    event.key.m_ts = id.GetTs();
+    event.key.m_context = id.GetContext();
+    event.key.m_uid = id.GetUid();
+    partition.events->Remove(event);
+    event.impl->Cancel();
+    // whenever we remove an event from the event list, we have to unref it.
+    event.impl->Unref();
+
+    partition.unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel(const EventId& id)
+{
+    if (!IsExpired(id))
+    {
+        id.PeekEventImpl()->Cancel();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired(const EventId& id) const
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        if (id.PeekEventImpl() == nullptr || id.PeekEventImpl()->IsCancelled())
+        {
+            return true;
+        }
+        // destroy events.
+        for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); i++)
+        {
+            if (*i == id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    const Partition& partition = Current(id.GetContext());
+    return id.PeekEventImpl() == nullptr || id.GetTs() < partition.currentTs ||
+           (id.GetTs() == partition.currentTs && id.GetUid() <= partition.currentUid) ||
+           id.PeekEventImpl()->IsCancelled();
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime() const
+{
+    return TimeStep(0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId() const
+{
+    return m_current != nullptr ? m_current->id : 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext() const
+{
+    return m_current != nullptr ? m_current->currentContext : Simulator::NO_CONTEXT;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount() const
+{
+    uint64_t count = 0;
+    for (const auto& partition : m_partitions)
+    {
+        count += partition->eventCount;
+    }
+    return count;
+}
+
+} // namespace ns3
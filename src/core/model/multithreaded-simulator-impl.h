@@ -0,0 +1,235 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "event-impl.h"
+#include "object-factory.h"
+#include "ptr.h"
+#include "simulator-impl.h"
+#include "spsc-queue.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @file
+ * @ingroup simulator
+ * ns3::MultithreadedSimulatorImpl declaration.
+ */
+
+namespace ns3
+{
+
+// Forward
+class Scheduler;
+
+/**
+ * @ingroup simulator
+ *
+ * @brief Conservative parallel simulator on the threads of one process.
+ *
+ * The events are split in partitions by their context, usually the
+ * node id.  Each partition has its own Scheduler, clock and event uids,
+ * and the partitions are run by a pool of worker threads.
+ *
+ * The partitions advance in windows: all events earlier than the next
+ * event of any partition plus the lookahead are run in parallel, then
+ * the threads meet at a barrier and exchange the events scheduled for
+ * another partition.  An event scheduled for a context of another
+ * partition goes through a lock-free single producer, single consumer
+ * queue per pair of partitions, so its delay must be at least the
+ * lookahead.  The lookahead is the smallest delay registered with
+ * UpdateLookahead(), typically the propagation delay of the links
+ * between partitions.  The events received by a partition are inserted
+ * in the order of the source partitions, so the result does not depend
+ * on the number of threads.
+ *
+ * Partitions are assigned with SetPartition() before Run(); contexts
+ * without a partition, and events without context, are in partition 0.
+ * The models must not share state across partitions other than through
+ * events: in particular a Ptr to an object of another partition must not
+ * be copied, as the reference count is not atomic.  The packet buffers
+ * and tag lists recycle their memory per thread, but the packet metadata
+ * is global: PacketMetadata::Enable() is not supported.
+ *
+ * Simulator::Stop() ends the window of the partition calling it;
+ * Simulator::Stop(delay) runs all partitions up to, excluding,
+ * the stop time.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+  public:
+    /**
+     *  Register this type.
+     *  @return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    /** Constructor. */
+    MultithreadedSimulatorImpl();
+    /** Destructor. */
+    ~MultithreadedSimulatorImpl() override;
+
+    // Inherited
+    void Destroy() override;
+    bool IsFinished() const override;
+    void Stop() override;
+    EventId Stop(const Time& delay) override;
+    EventId Schedule(const Time& delay, EventImpl* event) override;
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override;
+    EventId ScheduleNow(EventImpl* event) override;
+    EventId ScheduleDestroy(EventImpl* event) override;
+    void Remove(const EventId& id) override;
+    void Cancel(const EventId& id) override;
+    bool IsExpired(const EventId& id) const override;
+    void Run() override;
+    Time Now() const override;
+    Time GetDelayLeft(const EventId& id) const override;
+    Time GetMaximumSimulationTime() const override;
+    void SetScheduler(ObjectFactory schedulerFactory) override;
+    uint32_t GetSystemId() const override;
+    uint32_t GetContext() const override;
+    uint64_t GetEventCount() const override;
+
+    /**
+     * Assign the events of a context to a partition.
+     *
+     * Must be called before Run().
+     * @param [in] context The context, usually a node id.
+     * @param [in] partition The partition.
+     */
+    void SetPartition(uint32_t context, uint32_t partition);
+    /**
+     * Get the number of partitions.
+     * @return One more than the largest partition assigned.
+     */
+    uint32_t GetPartitionCount() const;
+    /**
+     * Lower the lookahead to a delay between two partitions, if smaller.
+     * @param [in] delay The smallest delay of an event sent to another partition.
+     */
+    void UpdateLookahead(Time delay);
+    /**
+     * Get the lookahead.
+     * @return The lookahead.
+     */
+    Time GetLookahead() const;
+
+  private:
+    void DoDispose() override;
+
+    /** An event sent to another partition. */
+    struct RemoteEvent
+    {
+        uint64_t ts{0};           //!< The absolute timestamp.
+        uint32_t context{0};      //!< The context.
+        EventImpl* event{nullptr}; //!< The event, owned by the queue.
+    };
+
+    /** The events, clock and inbound queues of one partition. */
+    struct Partition
+    {
+        uint32_t id{0};             //!< The partition index.
+        Ptr<Scheduler> events;      //!< The event queue.
+        uint64_t currentTs{0};      //!< Timestamp of the current event.
+        uint32_t currentUid{0};     //!< Unique id of the current event.
+        uint32_t currentContext{0}; //!< Context of the current event.
+        uint32_t uid{0};            //!< Next event unique id.
+        uint64_t eventCount{0};     //!< Number of events run.
+        int unscheduledEvents{0};   //!< Events inserted and not yet run.
+        uint64_t nextTs{0};         //!< Timestamp of the next event, at a barrier.
+        /** The queues of events from the other partitions, by source partition. */
+        std::vector<std::unique_ptr<SpscQueue<RemoteEvent>>> inbound;
+    };
+
+    /**
+     * Get the partition of a context.
+     * @param [in] context The context.
+     * @return The partition index.
+     */
+    uint32_t PartitionOf(uint32_t context) const;
+    /**
+     * Get the partition of the calling thread, or the partition
+     * of the context when called outside of Run().
+     * @param [in] context The context.
+     * @return The partition.
+     */
+    Partition& Current(uint32_t context) const;
+    /**
+     * Insert an event in a partition.
+     * @param [in] partition The partition.
+     * @param [in] ts The absolute timestamp.
+     * @param [in] context The context.
+     * @param [in] event The event.
+     * @return The event id.
+     */
+    EventId Insert(Partition& partition, uint64_t ts, uint32_t context, EventImpl* event);
+    /**
+     * Create the partitions up to an index.
+     * @param [in] partition The largest partition index.
+     */
+    void AddPartitions(uint32_t partition);
+    /** Create the queues and move the events to the partition of their context. */
+    void Setup();
+    /**
+     * Run the events of a partition before the window end.
+     * @param [in] partition The partition.
+     */
+    void ProcessWindow(Partition& partition);
+    /**
+     * Move the events received by a partition to its scheduler.
+     * @param [in] partition The partition.
+     */
+    void ReceiveEvents(Partition& partition);
+    /** Compute the next window, at the barrier. */
+    void NextWindow();
+
+    /** The partition run by the calling thread, null outside of Run(). */
+    static thread_local Partition* m_current;
+
+    /** The partitions. */
+    std::vector<std::unique_ptr<Partition>> m_partitions;
+    /** The partition of each context. */
+    std::vector<uint32_t> m_contextPartition;
+    /** The partitions or their assignment changed since the last Run(). */
+    bool m_dirty;
+    /** The scheduler factory. */
+    ObjectFactory m_schedulerFactory;
+    /** The lookahead. */
+    Time m_lookahead;
+    /** Largest number of threads, 0 for the hardware concurrency. */
+    uint32_t m_maxThreads;
+    /** The number of threads of the current Run(). */
+    uint32_t m_threadNum;
+    /** Run() is in progress. */
+    bool m_running;
+    /** End of the current window, exclusive. */
+    uint64_t m_windowEnd;
+    /** No window is left to run. */
+    bool m_finished;
+    /** Simulator::Stop() was called. */
+    std::atomic<bool> m_stop;
+    /** The stop time, exclusive. */
+    std::atomic<uint64_t> m_stopTs;
+    /** The latest timestamp reached when Run() returned. */
+    uint64_t m_lastTs;
+    /** Next event unique id outside of Run(), unique across the partitions. */
+    uint32_t m_uid;
+
+    /** Container type for the events to run at Simulator::Destroy() */
+    typedef std::list<EventId> DestroyEvents;
+    /** The container of events to run at Destroy. */
+    DestroyEvents m_destroyEvents;
+    /** Mutex for the destroy events, which any partition may schedule. */
+    std::mutex m_destroyMutex;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,243 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "scheduler-trace.h"
+
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+
+/**
+ * @file
+ * @ingroup scheduler
+ * ns3::SchedulerTrace implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("SchedulerTrace");
+
+/** The file magic. */
+static const char SCHEDULER_TRACE_MAGIC[4] = {'N', 'S', 'S', 'T'};
+/** The file format version. */
+static constexpr uint32_t SCHEDULER_TRACE_VERSION = 1;
+/** The buffer is written once it reaches this size. */
+static constexpr std::size_t SCHEDULER_TRACE_BUFFER = 1 << 20;
+
+SchedulerTrace::SchedulerTrace()
+    : m_now(0),
+      m_nextUid(0),
+      m_count(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+SchedulerTrace::~SchedulerTrace()
+{
+    NS_LOG_FUNCTION(this);
+    Flush();
+}
+
+bool
+SchedulerTrace::Open(std::string filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open())
+    {
+        return false;
+    }
+    m_file.write(SCHEDULER_TRACE_MAGIC, sizeof(SCHEDULER_TRACE_MAGIC));
+    m_file.write(reinterpret_cast<const char*>(&SCHEDULER_TRACE_VERSION),
+                 sizeof(SCHEDULER_TRACE_VERSION));
+    m_buffer.reserve(SCHEDULER_TRACE_BUFFER + 32);
+    return true;
+}
+
+void
+SchedulerTrace::PutVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        m_buffer.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    m_buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void
+SchedulerTrace::Add(Operation op, uint64_t ts, uint32_t uid)
+{
+    // every recorded event is at or after the current time
+    NS_ASSERT(ts >= m_now);
+    m_buffer.push_back(op);
+    PutVarint(ts - m_now);
+    if (op == INSERT)
+    {
+        // uids are consecutive unless a destroy event was scheduled in between
+        PutVarint(uid - m_nextUid);
+        m_nextUid = uid + 1;
+    }
+    else
+    {
+        PutVarint(uid);
+    }
+    if (op == REMOVE_NEXT)
+    {
+        m_now = ts;
+    }
+    m_count++;
+    if (m_buffer.size() >= SCHEDULER_TRACE_BUFFER)
+    {
+        Flush();
+    }
+}
+
+void
+SchedulerTrace::Flush()
+{
+    if (m_file.is_open() && !m_buffer.empty())
+    {
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+        m_file.flush();
+    }
+    m_buffer.clear();
+}
+
+uint64_t
+SchedulerTrace::GetRecordCount() const
+{
+    return m_count;
+}
+
+SchedulerTrace::Reader::Reader()
+    : m_pos(0),
+      m_size(0),
+      m_now(0),
+      m_nextUid(0),
+      m_count(0),
+      m_done(true)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+bool
+SchedulerTrace::Reader::Open(std::string filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+    m_filename = filename;
+    m_file.close();
+    m_file.clear();
+    m_file.open(filename, std::ios::binary);
+    m_data.resize(SCHEDULER_TRACE_BUFFER);
+    Rewind();
+    if (m_done)
+    {
+        NS_LOG_WARN("Not a scheduler trace: " << filename);
+        return false;
+    }
+    return true;
+}
+
+void
+SchedulerTrace::Reader::Rewind()
+{
+    NS_LOG_FUNCTION(this);
+    m_pos = 0;
+    m_size = 0;
+    m_now = 0;
+    m_nextUid = 0;
+    m_count = 0;
+    m_done = true;
+    m_file.clear();
+    m_file.seekg(0);
+    char magic[4];
+    uint32_t version = 0;
+    m_file.read(magic, sizeof(magic));
+    m_file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    m_done = !m_file ||
+             std::string(magic, 4) != std::string(SCHEDULER_TRACE_MAGIC, 4) ||
+             version != SCHEDULER_TRACE_VERSION;
+}
+
+bool
+SchedulerTrace::Reader::Fill()
+{
+    std::copy(m_data.begin() + m_pos, m_data.begin() + m_size, m_data.begin());
+    m_size -= m_pos;
+    m_pos = 0;
+    m_file.read(reinterpret_cast<char*>(m_data.data() + m_size), m_data.size() - m_size);
+    m_size += m_file.gcount();
+    return m_size > 0;
+}
+
+bool
+SchedulerTrace::Reader::GetVarint(uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; m_pos < m_size && shift < 64; shift += 7)
+    {
+        uint8_t byte = m_data[m_pos++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t
+SchedulerTrace::Reader::Read(std::vector<Record>& records, std::size_t maxRecords)
+{
+    NS_LOG_FUNCTION(this << maxRecords);
+    records.clear();
+    // the longest record is the operation and two 10 byte varints
+    const std::size_t maxRecordSize = 21;
+    while (!m_done && records.size() < maxRecords)
+    {
+        if (m_size - m_pos < maxRecordSize && (m_file.eof() || !Fill()))
+        {
+            if (m_pos == m_size)
+            {
+                m_done = true;
+                break;
+            }
+        }
+        Record record;
+        uint64_t ts;
+        uint64_t uid;
+        record.op = static_cast<Operation>(m_data[m_pos++]);
+        if (record.op > CANCEL || !GetVarint(ts) || !GetVarint(uid))
+        {
+            NS_LOG_WARN("Truncated scheduler trace " << m_filename << " after " << m_count
+                                                     << " records");
+            m_done = true;
+            break;
+        }
+        record.ts = m_now + ts;
+        record.uid = static_cast<uint32_t>(record.op == INSERT ? m_nextUid + uid : uid);
+        if (record.op == INSERT)
+        {
+            m_nextUid = record.uid + 1;
+        }
+        else if (record.op == REMOVE_NEXT)
+        {
+            m_now = record.ts;
+        }
+        records.push_back(record);
+        m_count++;
+    }
+    return records.size();
+}
+
+uint64_t
+SchedulerTrace::Reader::GetRecordCount() const
+{
+    return m_count;
+}
+
+} // namespace ns3
@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef SCHEDULER_TRACE_H
+#define SCHEDULER_TRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file
+ * @ingroup scheduler
+ * ns3::SchedulerTrace declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * @ingroup scheduler
+ *
+ * @brief Binary log of the operations of a simulation on its Scheduler.
+ *
+ * The log holds the sequence of event inserts, removals of the next
+ * event, removals of a given event and cancels, each with the event
+ * timestamp and uid.  Replaying the inserts and removals on any
+ * Scheduler reproduces the access pattern of the recorded simulation,
+ * without the models that generated it.
+ *
+ * The file starts with the magic "NSST" and a uint32_t version.
+ * Each record is one operation byte, the varint of the event timestamp
+ * relative to the timestamp of the last RemoveNext() record, and a varint uid.
+ * The uid of an insert is relative to the uid following the last insert,
+ * so the common record of an event scheduled soon takes 3 to 5 bytes.
+ *
+ * A log is decoded by a SchedulerTrace::Reader, in chunks of bounded
+ * size, so a log of any length can be replayed in constant memory.
+ */
+class SchedulerTrace
+{
+  public:
+    /** The recorded operations. */
+    enum Operation : uint8_t
+    {
+        INSERT = 0,      //!< Scheduler::Insert()
+        REMOVE_NEXT = 1, //!< Scheduler::RemoveNext()
+        REMOVE = 2,      //!< Scheduler::Remove()
+        CANCEL = 3       //!< EventId::Cancel(), the event stays in the Scheduler
+    };
+
+    /** One decoded record. */
+    struct Record
+    {
+        Operation op; //!< The operation.
+        uint64_t ts;  //!< The event timestamp.
+        uint32_t uid; //!< The event uid.
+    };
+
+    /** Constructor. */
+    SchedulerTrace();
+    /** Destructor, flushes and closes the log. */
+    ~SchedulerTrace();
+
+    /**
+     * Open the log for writing.
+     * @param [in] filename The log file.
+     * @return \c true if the file could be opened.
+     */
+    bool Open(std::string filename);
+
+    /**
+     * Append a record.
+     * @param [in] op The operation.
+     * @param [in] ts The event timestamp.
+     * @param [in] uid The event uid.
+     */
+    void Add(Operation op, uint64_t ts, uint32_t uid);
+
+    /** Write the buffered records to the file. */
+    void Flush();
+
+    /**
+     * Get the number of records written so far.
+     * @return The number of records.
+     */
+    uint64_t GetRecordCount() const;
+
+    /**
+     * @brief Decode a log in chunks of records.
+     */
+    class Reader
+    {
+      public:
+        /** Constructor. */
+        Reader();
+
+        /**
+         * Open a log for reading.
+         * @param [in] filename The log file.
+         * @return \c true if the file is a scheduler trace.
+         */
+        bool Open(std::string filename);
+
+        /**
+         * Decode the next records.
+         * @param [out] records The decoded records, cleared first.
+         * @param [in] maxRecords The maximum number of records to decode.
+         * @return The number of records decoded, 0 at the end of the log.
+         */
+        std::size_t Read(std::vector<Record>& records, std::size_t maxRecords);
+
+        /** Restart decoding from the first record. */
+        void Rewind();
+
+        /**
+         * Get the number of records decoded since the last Rewind().
+         * @return The number of records.
+         */
+        uint64_t GetRecordCount() const;
+
+      private:
+        /**
+         * Read more bytes from the file, keeping the ones not yet decoded.
+         * @return \c true if some bytes are left to decode.
+         */
+        bool Fill();
+        /**
+         * Decode a varint.
+         * @param [out] value The value.
+         * @return \c false if the varint is truncated.
+         */
+        bool GetVarint(uint64_t& value);
+
+        /** The log file name, for the warnings. */
+        std::string m_filename;
+        /** The log file. */
+        std::ifstream m_file;
+        /** The bytes read from the file. */
+        std::vector<uint8_t> m_data;
+        /** The position of the next byte to decode. */
+        std::size_t m_pos;
+        /** The number of valid bytes in the buffer. */
+        std::size_t m_size;
+        /** The timestamp of the last RemoveNext(), the base of the timestamps. */
+        uint64_t m_now;
+        /** The uid expected for the next insert. */
+        uint32_t m_nextUid;
+        /** The number of records decoded. */
+        uint64_t m_count;
+        /** Whether the end of the log or a truncated record was reached. */
+        bool m_done;
+    };
+
+  private:
+    /**
+     * Append a varint to the buffer.
+     * @param [in] value The value.
+     */
+    void PutVarint(uint64_t value);
+
+    /** The log file. */
+    std::ofstream m_file;
+    /** The records not yet written. */
+    std::vector<uint8_t> m_buffer;
+    /** The timestamp of the last RemoveNext(), the base of the timestamps. */
+    uint64_t m_now;
+    /** The uid expected for the next insert. */
+    uint32_t m_nextUid;
+    /** The number of records. */
+    uint64_t m_count;
+};
+
+} // namespace ns3
+
+#endif /* SCHEDULER_TRACE_H */
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @file
+ * @ingroup core
+ * ns3::SpscQueue declaration and template implementation.
+ */
+
+namespace ns3
+{
+
+/**
+ * @ingroup core
+ *
+ * @brief Unbounded lock-free single producer, single consumer FIFO.
+ *
+ * Items are stored in a linked list of fixed size chunks.  The producer
+ * publishes each item with a release store of the chunk fill count
+ * and links a new chunk when the last one is full; the consumer frees
+ * a chunk once it has read all of its items.  Neither side ever waits
+ * for the other, so a producer may run arbitrarily far ahead.
+ *
+ * Push() must only be called by one thread at a time, and Pop() and
+ * IsEmpty() by one other thread at a time.
+ *
+ * @tparam T \explicit The item type, default constructible and copyable.
+ * @tparam CHUNK \explicit The number of items per chunk.
+ */
+template <typename T, std::size_t CHUNK = 1024>
+class SpscQueue
+{
+  public:
+    /** Constructor. */
+    SpscQueue();
+    /** Destructor, frees the chunks, not the items. */
+    ~SpscQueue();
+
+    // Delete copy constructor and assignment operator to avoid misuse
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * Append an item, from the producer thread.
+     * @param [in] item The item.
+     */
+    void Push(const T& item);
+
+    /**
+     * Remove the oldest item, from the consumer thread.
+     * @param [out] item The item, unchanged if the queue is empty.
+     * @return \c true if an item was removed.
+     */
+    bool Pop(T& item);
+
+    /**
+     * Check for items, from the consumer thread.
+     * @return \c true if no item was published yet.
+     */
+    bool IsEmpty() const;
+
+  private:
+    /** A chunk of items. */
+    struct Chunk
+    {
+        T items[CHUNK];                    //!< The items.
+        std::atomic<std::size_t> size{0};  //!< Number of items published.
+        std::atomic<Chunk*> next{nullptr}; //!< The next chunk, linked once this one is full.
+    };
+
+    /** The chunk read by the consumer. */
+    alignas(64) Chunk* m_head;
+    /** Index of the next item to read in m_head. */
+    std::size_t m_headIndex;
+    /** The chunk written by the producer. */
+    alignas(64) Chunk* m_tail;
+    /** Index of the next item to write in m_tail. */
+    std::size_t m_tailIndex;
+};
+
+} // namespace ns3
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3
+{
+
+template <typename T, std::size_t CHUNK>
+SpscQueue<T, CHUNK>::SpscQueue()
+    : m_head(new Chunk()),
+      m_headIndex(0),
+      m_tail(m_head),
+      m_tailIndex(0)
+{
+}
+
+template <typename T, std::size_t CHUNK>
+SpscQueue<T, CHUNK>::~SpscQueue()
+{
+    while (m_head != nullptr)
+    {
+        Chunk* next = m_head->next.load(std::memory_order_relaxed);
+        delete m_head;
+        m_head = next;
+    }
+}
+
+template <typename T, std::size_t CHUNK>
+void
+SpscQueue<T, CHUNK>::Push(const T& item)
+{
+    if (m_tailIndex == CHUNK)
+    {
+        auto chunk = new Chunk();
+        m_tail->next.store(chunk, std::memory_order_release);
+        m_tail = chunk;
+        m_tailIndex = 0;
+    }
+    m_tail->items[m_tailIndex++] = item;
+    m_tail->size.store(m_tailIndex, std::memory_order_release);
+}
+
+template <typename T, std::size_t CHUNK>
+bool
+SpscQueue<T, CHUNK>::Pop(T& item)
+{
+    if (m_headIndex == CHUNK)
+    {
+        Chunk* next = m_head->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+        {
+            return false;
+        }
+        // the producer moved on to the next chunk, it never touches this one again
+        delete m_head;
+        m_head = next;
+        m_headIndex = 0;
+    }
+    if (m_headIndex == m_head->size.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    item = m_head->items[m_headIndex++];
+    return true;
+}
+
+template <typename T, std::size_t CHUNK>
+bool
+SpscQueue<T, CHUNK>::IsEmpty() const
+{
+    if (m_headIndex < CHUNK)
+    {
+        return m_headIndex == m_head->size.load(std::memory_order_acquire);
+    }
+    Chunk* next = m_head->next.load(std::memory_order_acquire);
+    return next == nullptr || next->size.load(std::memory_order_acquire) == 0;
+}
+
+} // namespace ns3
+
+#endif /* SPSC_QUEUE_H */
@@ -0,0 +1,271 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "ns3/config.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/simulator.h"
+#include "ns3/spsc-queue.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * @file
+ * @ingroup multithreaded-simulator-tests
+ * Multithreaded simulator test suite
+ */
+
+/**
+ * @ingroup core-tests
+ * @defgroup multithreaded-simulator-tests Multithreaded simulator tests
+ */
+
+/**
+ * @ingroup multithreaded-simulator-tests
+ *
+ * @brief Check the order of the items of a SpscQueue, on one and two threads.
+ */
+class SpscQueueTestCase : public TestCase
+{
+  public:
+    SpscQueueTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SpscQueueTestCase::SpscQueueTestCase()
+    : TestCase("Check the order of the items of a SpscQueue")
+{
+}
+
+void
+SpscQueueTestCase::DoRun()
+{
+    // several chunks, filled and drained in turns
+    SpscQueue<uint32_t, 4> queue;
+    uint32_t item = 0;
+    NS_TEST_ASSERT_MSG_EQ(queue.IsEmpty(), true, "new queue not empty");
+    NS_TEST_ASSERT_MSG_EQ(queue.Pop(item), false, "item popped from an empty queue");
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    for (uint32_t round = 1; round < 12; round++)
+    {
+        for (uint32_t i = 0; i < round; i++)
+        {
+            queue.Push(pushed++);
+        }
+        NS_TEST_ASSERT_MSG_EQ(queue.IsEmpty(), false, "pushed items not visible");
+        while (queue.Pop(item))
+        {
+            NS_TEST_ASSERT_MSG_EQ(item, popped, "items out of order");
+            popped++;
+        }
+        NS_TEST_ASSERT_MSG_EQ(queue.IsEmpty(), true, "drained queue not empty");
+    }
+    NS_TEST_ASSERT_MSG_EQ(popped, pushed, "items lost");
+
+    // a producer running ahead of the consumer
+    const uint32_t total = 200000;
+    SpscQueue<uint32_t, 64> shared;
+    std::thread producer([&shared]() {
+        for (uint32_t i = 0; i < total; i++)
+        {
+            shared.Push(i);
+        }
+    });
+    popped = 0;
+    bool ordered = true;
+    while (popped < total)
+    {
+        if (shared.Pop(item))
+        {
+            ordered = ordered && item == popped;
+            popped++;
+        }
+    }
+    producer.join();
+    NS_TEST_ASSERT_MSG_EQ(ordered, true, "items out of order across threads");
+    NS_TEST_ASSERT_MSG_EQ(shared.IsEmpty(), true, "items left after the last one");
+}
+
+/**
+ * @ingroup multithreaded-simulator-tests
+ *
+ * @brief Check that a partitioned run gives the events of a sequential run.
+ *
+ * Two contexts in two partitions exchange messages with the lookahead as
+ * delay, and each one also runs local events.  The events run by each
+ * context, with their time, must be the same as with DefaultSimulatorImpl;
+ * only the order of the events of the same time may differ, as their
+ * uids are drawn by partition.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+  public:
+    /**
+     * Constructor.
+     * @param threads The largest number of threads.
+     */
+    MultithreadedSimulatorTestCase(uint32_t threads);
+
+  private:
+    void DoRun() override;
+    void DoTeardown() override;
+
+    /**
+     * Run the exchange with a simulator implementation.
+     * @param simulatorType The simulator implementation.
+     */
+    void RunExchange(std::string simulatorType);
+    /**
+     * Receive a message, record it and answer it.
+     * @param hops The hops left.
+     */
+    void Receive(uint32_t hops);
+    /**
+     * A local event of a context.
+     * @param left The local events left.
+     */
+    void Local(uint32_t left);
+
+    /** The events run by a context: the time, the event kind and its argument. */
+    typedef std::vector<std::tuple<int64_t, bool, uint32_t>> EventLog;
+
+    uint32_t m_threads;    //!< The largest number of threads.
+    EventLog m_log[2];     //!< The events, by context, written by its own partition only.
+    uint64_t m_eventCount; //!< The number of events of the last run.
+    Time m_lookahead;      //!< The delay of the messages.
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase(uint32_t threads)
+    : TestCase("Check a partitioned run on " + std::to_string(threads) + " threads"),
+      m_threads(threads),
+      m_eventCount(0),
+      m_lookahead(MicroSeconds(1))
+{
+}
+
+void
+MultithreadedSimulatorTestCase::Receive(uint32_t hops)
+{
+    uint32_t context = Simulator::GetContext();
+    m_log[context].emplace_back(Simulator::Now().GetTimeStep(), true, hops);
+    if (hops > 0)
+    {
+        Simulator::ScheduleWithContext(1 - context,
+                                       m_lookahead + NanoSeconds(hops % 3),
+                                       &MultithreadedSimulatorTestCase::Receive,
+                                       this,
+                                       hops - 1);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::Local(uint32_t left)
+{
+    uint32_t context = Simulator::GetContext();
+    m_log[context].emplace_back(Simulator::Now().GetTimeStep(), false, left);
+    if (left > 0)
+    {
+        // below the lookahead, run in the same window as the messages
+        Simulator::Schedule(NanoSeconds(300),
+                            &MultithreadedSimulatorTestCase::Local,
+                            this,
+                            left - 1);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::RunExchange(std::string simulatorType)
+{
+    Simulator::Destroy();
+    Config::SetGlobal("SimulatorImplementationType", StringValue(simulatorType));
+    Config::SetDefault("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue(m_threads));
+    m_log[0].clear();
+    m_log[1].clear();
+
+    auto partitions = DynamicCast<MultithreadedSimulatorImpl>(Simulator::GetImplementation());
+    if (partitions)
+    {
+        partitions->SetPartition(0, 0);
+        partitions->SetPartition(1, 1);
+        partitions->UpdateLookahead(m_lookahead);
+    }
+    for (uint32_t context = 0; context < 2; context++)
+    {
+        Simulator::ScheduleWithContext(context,
+                                       NanoSeconds(context),
+                                       &MultithreadedSimulatorTestCase::Receive,
+                                       this,
+                                       100 + context);
+        Simulator::ScheduleWithContext(context,
+                                       NanoSeconds(5),
+                                       &MultithreadedSimulatorTestCase::Local,
+                                       this,
+                                       200);
+    }
+    Simulator::Run();
+    m_eventCount = Simulator::GetEventCount();
+    Simulator::Destroy();
+    for (auto& log : m_log)
+    {
+        std::sort(log.begin(), log.end());
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun()
+{
+    RunExchange("ns3::DefaultSimulatorImpl");
+    EventLog expected[2] = {m_log[0], m_log[1]};
+    uint64_t expectedCount = m_eventCount;
+
+    RunExchange("ns3::MultithreadedSimulatorImpl");
+    for (uint32_t context = 0; context < 2; context++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(m_log[context].size(),
+                              expected[context].size(),
+                              "wrong number of events in context " << context);
+        NS_TEST_ASSERT_MSG_EQ((m_log[context] == expected[context]),
+                              true,
+                              "wrong events in context " << context);
+    }
+    NS_TEST_ASSERT_MSG_EQ(m_eventCount, expectedCount, "wrong event count");
+}
+
+void
+MultithreadedSimulatorTestCase::DoTeardown()
+{
+    Config::SetGlobal("SimulatorImplementationType", StringValue("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * @ingroup multithreaded-simulator-tests
+ *
+ * @brief The multithreaded simulator Test Suite.
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+  public:
+    MultithreadedSimulatorTestSuite()
+        : TestSuite("multithreaded-simulator")
+    {
+        AddTestCase(new SpscQueueTestCase, TestCase::Duration::QUICK);
+        for (uint32_t threads : {1, 2, 3})
+        {
+            AddTestCase(new MultithreadedSimulatorTestCase(threads), TestCase::Duration::QUICK);
+        }
+    }
+};
+
+static MultithreadedSimulatorTestSuite
+    g_multithreadedSimulatorTestSuite; //!< Static variable for test initialization
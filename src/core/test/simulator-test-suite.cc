@@ -6,13 +6,21 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "ns3/calendar-scheduler.h"
+#include "ns3/config.h"
+#include "ns3/event-profiler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 #include "ns3/list-scheduler.h"
+#include "ns3/make-event.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/priority-queue-scheduler.h"
+#include "ns3/scheduler-trace.h"
 #include "ns3/simulator.h"
+#include "ns3/string.h"
 #include "ns3/test.h"
 
+#include <unordered_set>
+
 using namespace ns3;
 
 /**
@@ -703,6 +711,409 @@ SimulatorTemplateTestCase::DoRun()
     Simulator::Destroy();
 }
 
+/**
+ * @ingroup simulator-tests
+ *
+ * @brief Event handler with a virtual member function.
+ */
+class ProfiledHandler : public SimpleRefCount<ProfiledHandler>
+{
+  public:
+    virtual ~ProfiledHandler() = default;
+    /** Test event. */
+    virtual void Handle();
+
+    // the handlers differ, identical functions may be folded at the same address
+    uint32_t m_handled{0};    //!< Calls of the base handler.
+    uint32_t m_overridden{0}; //!< Calls of the override.
+};
+
+void
+ProfiledHandler::Handle()
+{
+    m_handled++;
+}
+
+/**
+ * @ingroup simulator-tests
+ *
+ * @brief Event handler overriding the virtual member function.
+ */
+class ProfiledHandlerOverride : public ProfiledHandler
+{
+  public:
+    void Handle() override;
+};
+
+void
+ProfiledHandlerOverride::Handle()
+{
+    m_overridden++;
+}
+
+/**
+ * @ingroup simulator-tests
+ *
+ * @brief Check that the event profiler attributes events to their handler.
+ */
+class EventProfilerTestCase : public TestCase
+{
+  public:
+    EventProfilerTestCase();
+    void DoRun() override;
+    /** Test event. */
+    void Event1();
+    /**
+     * Test event.
+     * @param value Event parameter.
+     */
+    void Event2(int value);
+    /** Test event with the signature of Event1. */
+    void Event3();
+};
+
+EventProfilerTestCase::EventProfilerTestCase()
+    : TestCase("Check the event profiler")
+{
+}
+
+void
+EventProfilerTestCase::Event1()
+{
+}
+
+void
+EventProfilerTestCase::Event2(int value)
+{
+}
+
+void
+EventProfilerTestCase::Event3()
+{
+}
+
+void
+EventProfilerTestCase::DoRun()
+{
+    EventProfiler profiler(MilliSeconds(1).GetTimeStep());
+
+    std::vector<EventImpl*> events;
+    for (int i = 0; i < 3; i++)
+    {
+        events.push_back(MakeEvent(&EventProfilerTestCase::Event1, this));
+    }
+    events.push_back(MakeEvent(&EventProfilerTestCase::Event2, this, 0));
+    events.push_back(MakeEvent(&EventProfilerTestCase::Event3, this));
+
+    for (std::size_t i = 0; i < events.size(); i++)
+    {
+        profiler.RecordSchedule(events[i]);
+        profiler.RecordExecute(events[i], MilliSeconds(2 * i).GetTimeStep(), 10);
+        events[i]->Unref();
+    }
+
+    auto stats = profiler.GetStats();
+    // Event1 and Event3 share the event type, not the handler
+    NS_TEST_ASSERT_MSG_EQ(stats.size(), 3, "expected one entry per handler");
+    uint64_t executed = 0;
+    uint64_t ticks = 0;
+    for (const auto& [name, entry] : stats)
+    {
+        NS_TEST_ASSERT_MSG_EQ(entry.scheduled, entry.executed, "scheduled != executed");
+        uint64_t expected = name.find("Event1") != std::string::npos ? 3 : 1;
+        NS_TEST_ASSERT_MSG_EQ(entry.executed, expected, "bad count for " << name);
+        executed += entry.executed;
+        ticks += entry.ticks;
+    }
+    NS_TEST_ASSERT_MSG_EQ(executed, 5, "expected 5 executed events");
+    NS_TEST_ASSERT_MSG_EQ(ticks, 50, "expected 50 ticks");
+    NS_TEST_ASSERT_MSG_EQ(stats.count("EventProfilerTestCase::Event3()"),
+                          1,
+                          "expected the handler name");
+
+    const auto& timeline = profiler.GetTimeline();
+    NS_TEST_ASSERT_MSG_EQ(timeline.size(), 9, "expected buckets up to 8 ms");
+    NS_TEST_ASSERT_MSG_EQ(timeline[0].executed, 1, "expected one event at 0 ms");
+    NS_TEST_ASSERT_MSG_EQ(timeline[1].executed, 0, "expected no event at 1 ms");
+    NS_TEST_ASSERT_MSG_EQ(timeline[6].ticks, 10, "expected 10 ticks at 6 ms");
+
+    // a virtual handler is attributed to the override of the bound object
+    EventProfiler virtualProfiler(MilliSeconds(1).GetTimeStep());
+    Ptr<ProfiledHandler> handler = Create<ProfiledHandlerOverride>();
+    EventImpl* event = MakeEvent(&ProfiledHandler::Handle, handler);
+    virtualProfiler.RecordSchedule(event);
+    event->Unref();
+    NS_TEST_ASSERT_MSG_EQ(virtualProfiler.GetStats().count("ProfiledHandlerOverride::Handle()"),
+                          1,
+                          "expected the name of the override");
+}
+
+/**
+ * @ingroup simulator-tests
+ *
+ * @brief Check the LadderScheduler order against the MapScheduler
+ * with bursts of events at one timestamp and spread out events.
+ */
+class LadderSchedulerTestCase : public TestCase
+{
+  public:
+    LadderSchedulerTestCase();
+    void DoRun() override;
+};
+
+LadderSchedulerTestCase::LadderSchedulerTestCase()
+    : TestCase("Check the ladder scheduler order")
+{
+}
+
+void
+LadderSchedulerTestCase::DoRun()
+{
+    Ptr<Scheduler> ladder = CreateObject<LadderScheduler>();
+    Ptr<Scheduler> reference = CreateObject<MapScheduler>();
+    std::vector<Scheduler::Event> pending;
+    std::unordered_set<uint32_t> executed;
+    uint64_t state = 1;
+    auto next = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+
+    uint64_t now = 0;
+    uint32_t uid = 0;
+    for (uint32_t i = 0; i < 50000; i++)
+    {
+        uint64_t op = next() % 10;
+        if (op < 6 || ladder->IsEmpty() || pending.empty())
+        {
+            // bursts at the current time and one fixed delay, and spread out delays
+            uint64_t kind = next() % 4;
+            uint64_t delay = kind == 0   ? 0
+                             : kind == 1 ? 1600
+                                         : next() % (kind == 2 ? 1000 : 1000000);
+            Scheduler::Event ev{nullptr, {now + delay, uid++, 0}};
+            ladder->Insert(ev);
+            reference->Insert(ev);
+            pending.push_back(ev);
+        }
+        else if (op < 9)
+        {
+            Scheduler::Event got = ladder->RemoveNext();
+            Scheduler::Event expected = reference->RemoveNext();
+            NS_TEST_ASSERT_MSG_EQ(got.key.m_uid, expected.key.m_uid, "wrong event order");
+            executed.insert(got.key.m_uid);
+            now = got.key.m_ts;
+        }
+        else
+        {
+            // remove a random event, unless it was already executed
+            std::size_t index = next() % pending.size();
+            Scheduler::Event ev = pending[index];
+            pending[index] = pending.back();
+            pending.pop_back();
+            if (executed.count(ev.key.m_uid) == 0)
+            {
+                ladder->Remove(ev);
+                reference->Remove(ev);
+            }
+        }
+        if (!ladder->IsEmpty())
+        {
+            NS_TEST_ASSERT_MSG_EQ(ladder->PeekNext().key.m_uid,
+                                  reference->PeekNext().key.m_uid,
+                                  "wrong next event");
+        }
+        NS_TEST_ASSERT_MSG_EQ(ladder->IsEmpty(), reference->IsEmpty(), "wrong size");
+    }
+    while (!ladder->IsEmpty())
+    {
+        NS_TEST_ASSERT_MSG_EQ(ladder->RemoveNext().key.m_uid,
+                              reference->RemoveNext().key.m_uid,
+                              "wrong event order");
+    }
+}
+
+/**
+ * @ingroup simulator-tests
+ *
+ * @brief Check that the event pool recycles the events of each size.
+ */
+class EventPoolTestCase : public TestCase
+{
+  public:
+    EventPoolTestCase();
+    void DoRun() override;
+    /** Test event. */
+    void Event1();
+    /**
+     * Test event with more bound arguments, of a larger size class.
+     * @param a Event parameter.
+     * @param b Event parameter.
+     * @param c Event parameter.
+     */
+    void Event2(uint64_t a, uint64_t b, uint64_t c);
+    /**
+     * Schedule and run a batch of events.
+     * @param n Number of events of each type.
+     */
+    void RunBatch(uint32_t n);
+
+    uint32_t m_count; //!< Number of events run.
+};
+
+EventPoolTestCase::EventPoolTestCase()
+    : TestCase("Check the event pool")
+{
+}
+
+void
+EventPoolTestCase::Event1()
+{
+    m_count++;
+}
+
+void
+EventPoolTestCase::Event2(uint64_t a, uint64_t b, uint64_t c)
+{
+    m_count += (a + b + c == 6) ? 1 : 0;
+}
+
+void
+EventPoolTestCase::RunBatch(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        Simulator::Schedule(NanoSeconds(i), &EventPoolTestCase::Event1, this);
+        Simulator::Schedule(NanoSeconds(i), &EventPoolTestCase::Event2, this, 1, 2, 3);
+    }
+    Simulator::Run();
+}
+
+void
+EventPoolTestCase::DoRun()
+{
+    m_count = 0;
+    RunBatch(100);
+    NS_TEST_ASSERT_MSG_EQ(m_count, 200, "events not run");
+
+    // the second batch is allocated from the events freed by the first
+    auto before = EventImpl::GetPoolStats();
+    RunBatch(100);
+    auto after = EventImpl::GetPoolStats();
+    NS_TEST_ASSERT_MSG_EQ(m_count, 400, "recycled events not run");
+    NS_TEST_ASSERT_MSG_EQ(after.allocated, before.allocated, "events not recycled");
+    NS_TEST_ASSERT_MSG_EQ(after.reused - before.reused, 200, "expected 200 recycled events");
+
+    EventImpl::SetPoolEnabled(false);
+    before = EventImpl::GetPoolStats();
+    RunBatch(10);
+    after = EventImpl::GetPoolStats();
+    EventImpl::SetPoolEnabled(true);
+    NS_TEST_ASSERT_MSG_EQ(after.allocated - before.allocated, 20, "pool not disabled");
+    NS_TEST_ASSERT_MSG_EQ(after.reused, before.reused, "pool not disabled");
+    Simulator::Destroy();
+}
+
+/**
+ * @ingroup simulator-tests
+ *
+ * @brief Check the recording of the scheduler operations and their replay.
+ */
+class SchedulerTraceTestCase : public TestCase
+{
+  public:
+    SchedulerTraceTestCase();
+    void DoRun() override;
+    /** Test event, reschedules itself a few times. */
+    void Event1();
+
+    uint32_t m_count; //!< Number of events run.
+};
+
+SchedulerTraceTestCase::SchedulerTraceTestCase()
+    : TestCase("Check the scheduler trace")
+{
+}
+
+void
+SchedulerTraceTestCase::Event1()
+{
+    m_count++;
+    if (m_count < 1000)
+    {
+        Simulator::Schedule(NanoSeconds((m_count * 7919) % 1000),
+                            &SchedulerTraceTestCase::Event1,
+                            this);
+    }
+}
+
+void
+SchedulerTraceTestCase::DoRun()
+{
+    std::string filename = CreateTempDirFilename("scheduler-trace.bin");
+    m_count = 0;
+    Simulator::Destroy();
+    Config::SetDefault("ns3::DefaultSimulatorImpl::SchedulerTraceFile", StringValue(filename));
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        Simulator::Schedule(NanoSeconds(i), &SchedulerTraceTestCase::Event1, this);
+    }
+    EventId removed = Simulator::Schedule(Seconds(1), &SchedulerTraceTestCase::Event1, this);
+    EventId cancelled = Simulator::Schedule(Seconds(2), &SchedulerTraceTestCase::Event1, this);
+    Simulator::Remove(removed);
+    Simulator::Cancel(cancelled);
+    Simulator::Run();
+    Simulator::Destroy();
+    Config::SetDefault("ns3::DefaultSimulatorImpl::SchedulerTraceFile", StringValue(""));
+
+    // decode in small chunks, so records are split across the reads
+    SchedulerTrace::Reader reader;
+    NS_TEST_ASSERT_MSG_EQ(reader.Open(filename), true, "not a scheduler trace");
+    std::vector<SchedulerTrace::Record> records;
+    std::vector<SchedulerTrace::Record> chunk;
+    while (reader.Read(chunk, 3) > 0)
+    {
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(chunk.size(), 3, "chunk larger than requested");
+        records.insert(records.end(), chunk.begin(), chunk.end());
+    }
+    NS_TEST_ASSERT_MSG_EQ(reader.GetRecordCount(), records.size(), "wrong record count");
+    reader.Rewind();
+    NS_TEST_ASSERT_MSG_EQ(reader.Read(chunk, records.size() + 1),
+                          records.size(),
+                          "wrong records after a rewind");
+    uint32_t ops[4] = {0, 0, 0, 0};
+    for (const auto& record : records)
+    {
+        ops[record.op]++;
+    }
+    NS_TEST_ASSERT_MSG_EQ(ops[SchedulerTrace::INSERT], m_count + 2, "wrong insert count");
+    NS_TEST_ASSERT_MSG_EQ(ops[SchedulerTrace::REMOVE_NEXT], m_count + 1, "wrong RemoveNext count");
+    NS_TEST_ASSERT_MSG_EQ(ops[SchedulerTrace::REMOVE], 1, "wrong remove count");
+    NS_TEST_ASSERT_MSG_EQ(ops[SchedulerTrace::CANCEL], 1, "wrong cancel count");
+
+    // the replay on another scheduler removes the events in the recorded order
+    Ptr<Scheduler> scheduler = CreateObject<LadderScheduler>();
+    for (const auto& record : records)
+    {
+        Scheduler::Event ev{nullptr, {record.ts, record.uid, 0}};
+        if (record.op == SchedulerTrace::INSERT)
+        {
+            scheduler->Insert(ev);
+        }
+        else if (record.op == SchedulerTrace::REMOVE)
+        {
+            scheduler->Remove(ev);
+        }
+        else if (record.op == SchedulerTrace::REMOVE_NEXT)
+        {
+            Scheduler::Event next = scheduler->RemoveNext();
+            NS_TEST_ASSERT_MSG_EQ(next.key.m_ts, record.ts, "wrong replayed timestamp");
+            NS_TEST_ASSERT_MSG_EQ(next.key.m_uid, record.uid, "wrong replayed event");
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ(scheduler->IsEmpty(), true, "events left after the replay");
+}
+
 /**
  * @ingroup simulator-tests
  *
@@ -726,6 +1137,12 @@ class SimulatorTestSuite : public TestSuite
         AddTestCase(new SimulatorEventsTestCase(factory), TestCase::Duration::QUICK);
         factory.SetTypeId(PriorityQueueScheduler::GetTypeId());
         AddTestCase(new SimulatorEventsTestCase(factory), TestCase::Duration::QUICK);
+        factory.SetTypeId(LadderScheduler::GetTypeId());
+        AddTestCase(new SimulatorEventsTestCase(factory), TestCase::Duration::QUICK);
+        AddTestCase(new EventProfilerTestCase(), TestCase::Duration::QUICK);
+        AddTestCase(new LadderSchedulerTestCase(), TestCase::Duration::QUICK);
+        AddTestCase(new EventPoolTestCase(), TestCase::Duration::QUICK);
+        AddTestCase(new SchedulerTraceTestCase(), TestCase::Duration::QUICK);
     }
 };
 
@@ -8,6 +8,7 @@
 
 #include "flow-monitor.h"
 
+#include "ns3/abort.h"
 #include "ns3/double.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -92,6 +93,11 @@ FlowMonitor::DoDispose()
     NS_LOG_FUNCTION(this);
     Simulator::Cancel(m_startEvent);
     Simulator::Cancel(m_stopEvent);
+    if (m_exportFile.is_open())
+    {
+        Simulator::Cancel(m_exportEndEvent);
+        StopIntervalExport();
+    }
     for (auto iter = m_classifiers.begin(); iter != m_classifiers.end(); iter++)
     {
         *iter = nullptr;
@@ -108,10 +114,23 @@ inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow(FlowId flowId)
 {
     NS_LOG_FUNCTION(this);
+    if (flowId < m_flowStatsIndex.size() && m_flowStatsIndex[flowId])
+    {
+        return *m_flowStatsIndex[flowId];
+    }
     auto iter = m_flowStats.find(flowId);
     if (iter == m_flowStats.end())
     {
         FlowMonitor::FlowStats& ref = m_flowStats[flowId];
+        // the map never erases a flow, hence its address stays valid
+        if (flowId < MAX_INDEXED_FLOW_ID)
+        {
+            if (flowId >= m_flowStatsIndex.size())
+            {
+                m_flowStatsIndex.resize(flowId + 1, nullptr);
+            }
+            m_flowStatsIndex[flowId] = &ref;
+        }
         ref.delaySum = Seconds(0);
         ref.jitterSum = Seconds(0);
         ref.lastDelay = Seconds(0);
@@ -527,11 +546,95 @@ FlowMonitor::SerializeToXmlFile(std::string fileName, bool enableHistograms, boo
     os.close();
 }
 
+void
+FlowMonitor::EnableIntervalExport(const std::string& fileName,
+                                  Time interval,
+                                  FlowLabelCallback label)
+{
+    NS_LOG_FUNCTION(this << fileName << interval);
+    NS_ABORT_MSG_IF(!interval.IsStrictlyPositive(), "The export interval must be positive");
+    NS_ABORT_MSG_IF(m_exportFile.is_open(), "The interval export is already enabled");
+    m_exportFile.open(fileName);
+    NS_ABORT_MSG_IF(!m_exportFile.is_open(), "Cannot open " << fileName);
+    m_exportInterval = interval;
+    m_exportLabel = label;
+    m_exportFile << "timeNs,flowId,label,txPackets,txBytes,rxPackets,rxBytes,lostPackets,"
+                    "timesForwarded,delaySumNs,jitterSumNs\n";
+    m_exportEvent =
+        Simulator::Schedule(m_exportInterval, &FlowMonitor::PeriodicExportInterval, this);
+    // the monitor is usually disposed after the simulator, at time 0
+    m_exportEndEvent = Simulator::ScheduleDestroy(&FlowMonitor::StopIntervalExport, this);
+}
+
+void
+FlowMonitor::StopIntervalExport()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(m_exportEvent);
+    ExportInterval();
+    m_exportFile.close();
+}
+
+void
+FlowMonitor::PeriodicExportInterval()
+{
+    ExportInterval();
+    m_exportEvent =
+        Simulator::Schedule(m_exportInterval, &FlowMonitor::PeriodicExportInterval, this);
+}
+
+void
+FlowMonitor::ExportInterval()
+{
+    NS_LOG_FUNCTION(this);
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    for (auto& [flowId, stats] : m_flowStats)
+    {
+        auto [iter, inserted] = m_exported.try_emplace(flowId);
+        ExportedCounters& last = iter->second;
+        if (inserted && !m_exportLabel.IsNull())
+        {
+            last.label = m_exportLabel(flowId);
+        }
+        if (!inserted && stats.txPackets == last.txPackets && stats.rxPackets == last.rxPackets &&
+            stats.lostPackets == last.lostPackets)
+        {
+            continue;
+        }
+        m_exportFile << now << "," << flowId << "," << last.label << ","
+                     << stats.txPackets - last.txPackets << "," << stats.txBytes - last.txBytes
+                     << "," << stats.rxPackets - last.rxPackets << ","
+                     << stats.rxBytes - last.rxBytes << "," << stats.lostPackets - last.lostPackets
+                     << "," << stats.timesForwarded - last.timesForwarded << ","
+                     << (stats.delaySum - last.delaySum).GetNanoSeconds() << ","
+                     << (stats.jitterSum - last.jitterSum).GetNanoSeconds() << "\n";
+        last.delaySum = stats.delaySum;
+        last.jitterSum = stats.jitterSum;
+        last.txBytes = stats.txBytes;
+        last.rxBytes = stats.rxBytes;
+        last.txPackets = stats.txPackets;
+        last.rxPackets = stats.rxPackets;
+        last.lostPackets = stats.lostPackets;
+        last.timesForwarded = stats.timesForwarded;
+
+        stats.delayHistogram.Clear();
+        stats.jitterHistogram.Clear();
+        stats.packetSizeHistogram.Clear();
+        stats.flowInterruptionsHistogram.Clear();
+    }
+}
+
 void
 FlowMonitor::ResetAllStats()
 {
     NS_LOG_FUNCTION(this);
 
+    // the next interval export starts from the reset counters, the labels are kept
+    for (auto& [flowId, last] : m_exported)
+    {
+        last = ExportedCounters{Seconds(0), Seconds(0), 0, 0, 0, 0, 0, 0, last.label};
+    }
+
     for (auto& iter : m_flowStats)
     {
         auto& flowStat = iter.second;
@@ -18,7 +18,9 @@
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 
+#include <fstream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace ns3
@@ -267,6 +269,22 @@ class FlowMonitor : public Object
     /// @param enableProbes if true, include also the per-probe/flow pair statistics in the output
     void SerializeToXmlFile(std::string fileName, bool enableHistograms, bool enableProbes);
 
+    /// Callback returning the label of a flow, e.g., the application flow it belongs to
+    typedef Callback<std::string, FlowId> FlowLabelCallback;
+
+    /// Every interval, write to a CSV file a line per flow with the counters accumulated
+    /// since the previous line of the flow, then clear the histograms of the flows, so that
+    /// the memory of a long run does not grow with the simulated time. The flows without
+    /// packets in the interval are skipped. The counters of the last (partial) interval
+    /// are written when the simulator (or the monitor) is destroyed. The histograms
+    /// written by SerializeToXmlStream only cover the current interval.
+    /// @param fileName name or path of the CSV file that will be created
+    /// @param interval the time between two exports
+    /// @param label if not null, the label of each flow, called once per flow
+    void EnableIntervalExport(const std::string& fileName,
+                              Time interval,
+                              FlowLabelCallback label = FlowLabelCallback());
+
     /// Reset all the statistics
     void ResetAllStats();
 
@@ -280,14 +298,31 @@ class FlowMonitor : public Object
     {
         Time firstSeenTime;      //!< absolute time when the packet was first seen by a probe
         Time lastSeenTime;       //!< absolute time when the packet was last seen by a probe
-        uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+        uint32_t timesForwarded = 0;//!< number of times the packet was reportedly forwarded
+    };
+
+    /// Hash function of a (FlowId,PacketId) pair
+    struct TrackedPacketHash
+    {
+        /// Hash function
+        /// @param key the (FlowId,PacketId) pair
+        /// @return the hash of the pair
+        std::size_t operator()(const std::pair<FlowId, FlowPacketId>& key) const
+        {
+            return std::hash<uint64_t>()((uint64_t(key.first) << 32) | key.second);
+        }
     };
 
     /// FlowId --> FlowStats
     FlowStatsContainer m_flowStats;
+    /// FlowId --> FlowStats in m_flowStats, as the classifiers assign the FlowIds in sequence
+    std::vector<FlowStats*> m_flowStatsIndex;
+    /// The FlowIds from this one on are only looked up in m_flowStats
+    static const FlowId MAX_INDEXED_FLOW_ID = 1 << 20;
 
     /// (FlowId,PacketId) --> TrackedPacket
-    typedef std::map<std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
+    typedef std::unordered_map<std::pair<FlowId, FlowPacketId>, TrackedPacket, TrackedPacketHash>
+        TrackedPacketMap;
     TrackedPacketMap m_trackedPackets; //!< Tracked packets
     Time m_maxPerHopDelay;             //!< Minimum per-hop delay
     FlowProbeContainer m_flowProbes;   //!< all the FlowProbes
@@ -304,11 +339,41 @@ class FlowMonitor : public Object
     double m_flowInterruptionsBinWidth; //!< Flow interruptions bin width (for histograms)
     Time m_flowInterruptionsMinTime;    //!< Flow interruptions minimum time
 
+    /// The counters of a flow written by the last interval export
+    struct ExportedCounters
+    {
+        Time delaySum;               //!< Sum of the delays
+        Time jitterSum;              //!< Sum of the jitters
+        uint64_t txBytes = 0;        //!< Transmitted bytes
+        uint64_t rxBytes = 0;        //!< Received bytes
+        uint32_t txPackets = 0;      //!< Transmitted packets
+        uint32_t rxPackets = 0;      //!< Received packets
+        uint32_t lostPackets = 0;    //!< Lost packets
+        uint32_t timesForwarded = 0; //!< Times the packets were forwarded
+        std::string label;           //!< Label of the flow
+    };
+
+    std::ofstream m_exportFile;                            //!< CSV file of the interval export
+    Time m_exportInterval;                                 //!< Time between two exports
+    EventId m_exportEvent;                                 //!< Next interval export
+    EventId m_exportEndEvent;                              //!< Last export, at Simulator::Destroy
+    FlowLabelCallback m_exportLabel;                       //!< Label of the exported flows
+    std::unordered_map<FlowId, ExportedCounters> m_exported; //!< Counters of the last export
+
     /// Get the stats for a given flow
     /// @param flowId the Flow identification
     /// @returns the stats of the flow
     FlowStats& GetStatsForFlow(FlowId flowId);
 
+    /// Write the counters of the flows since their last export and clear their histograms
+    void ExportInterval();
+
+    /// Periodic function to write the interval export
+    void PeriodicExportInterval();
+
+    /// Write the last interval export and close its file
+    void StopIntervalExport();
+
     /// Periodic function to check for lost packets and prune statistics
     void PeriodicCheckForLostPackets();
 };
@@ -31,6 +31,7 @@ FlowProbe::~FlowProbe()
 FlowProbe::FlowProbe(Ptr<FlowMonitor> flowMonitor)
     : m_flowMonitor(flowMonitor)
 {
+    m_cache.fill(std::make_pair(0, nullptr));
     m_flowMonitor->AddProbe(this);
 }
 
@@ -41,10 +42,21 @@ FlowProbe::DoDispose()
     Object::DoDispose();
 }
 
+FlowProbe::FlowStats&
+FlowProbe::GetStatsForFlow(FlowId flowId)
+{
+    auto& entry = m_cache[flowId % CACHE_SIZE];
+    if (!entry.second || entry.first != flowId)
+    {
+        entry = std::make_pair(flowId, &m_stats[flowId]);
+    }
+    return *entry.second;
+}
+
 void
 FlowProbe::AddPacketStats(FlowId flowId, uint32_t packetSize, Time delayFromFirstProbe)
 {
-    FlowStats& flow = m_stats[flowId];
+    FlowStats& flow = GetStatsForFlow(flowId);
     flow.delayFromFirstProbeSum += delayFromFirstProbe;
     flow.bytes += packetSize;
     ++flow.packets;
@@ -53,7 +65,7 @@ FlowProbe::AddPacketStats(FlowId flowId, uint32_t packetSize, Time delayFromFirs
 void
 FlowProbe::AddPacketDropStats(FlowId flowId, uint32_t packetSize, uint32_t reasonCode)
 {
-    FlowStats& flow = m_stats[flowId];
+    FlowStats& flow = GetStatsForFlow(flowId);
 
     if (flow.packetsDropped.size() < reasonCode + 1)
     {
@@ -14,6 +14,7 @@
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 
+#include <array>
 #include <map>
 #include <vector>
 
@@ -97,6 +98,18 @@ class FlowProbe : public Object
   protected:
     Ptr<FlowMonitor> m_flowMonitor; //!< the FlowMonitor instance
     Stats m_stats;                  //!< The flow stats
+
+  private:
+    /// Get the stats of a flow, through a direct-mapped cache of the entries of m_stats
+    /// @param flowId the flow Identifier
+    /// @returns the stats of the flow
+    FlowStats& GetStatsForFlow(FlowId flowId);
+
+    /// Number of entries of the cache
+    static const uint32_t CACHE_SIZE = 64;
+
+    /// FlowId % CACHE_SIZE --> (FlowId, FlowStats in m_stats), which m_stats never erases
+    std::array<std::pair<FlowId, FlowStats*>, CACHE_SIZE> m_cache;
 };
 
 } // namespace ns3
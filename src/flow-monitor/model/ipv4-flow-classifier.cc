@@ -13,6 +13,7 @@
 #include "ns3/udp-header.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace ns3
 {
@@ -80,7 +81,22 @@ operator==(const Ipv4FlowClassifier::FiveTuple& t1, const Ipv4FlowClassifier::Fi
             t1.sourcePort == t2.sourcePort && t1.destinationPort == t2.destinationPort);
 }
 
+std::size_t
+Ipv4FlowClassifier::FiveTupleHash::operator()(const FiveTuple& tuple) const
+{
+    uint64_t addresses =
+        (uint64_t(tuple.sourceAddress.Get()) << 32) | tuple.destinationAddress.Get();
+    uint64_t ports = (uint64_t(tuple.protocol) << 32) | (uint32_t(tuple.sourcePort) << 16) |
+                     tuple.destinationPort;
+    // the finalizer of splitmix64, so that flows differing in a few bits spread over the buckets
+    uint64_t hash = addresses ^ (ports * 0x9e3779b97f4a7c15ULL);
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
+
 Ipv4FlowClassifier::Ipv4FlowClassifier()
+    : m_lastFlowId(0)
 {
 }
 
@@ -133,52 +149,56 @@ Ipv4FlowClassifier::Classify(const Ipv4Header& ipHeader,
     tuple.sourcePort = srcPort;
     tuple.destinationPort = dstPort;
 
-    // try to insert the tuple, but check if it already exists
-    auto insert = m_flowMap.insert(std::pair<FiveTuple, FlowId>(tuple, 0));
-
-    // if the insertion succeeded, we need to assign this tuple a new flow identifier
-    if (insert.second)
+    // the packets of a flow usually come in bursts, hence first check the last flow
+    FlowId flowId = m_lastFlowId;
+    if (flowId == 0 || !(tuple == m_lastTuple))
     {
-        FlowId newFlowId = GetNewFlowId();
-        insert.first->second = newFlowId;
-        m_flowPktIdMap[newFlowId] = 0;
-        m_flowDscpMap[newFlowId];
-    }
-    else
-    {
-        m_flowPktIdMap[insert.first->second]++;
+        // try to insert the tuple, but check if it already exists
+        auto insert = m_flowMap.insert(std::pair<FiveTuple, FlowId>(tuple, 0));
+
+        // if the insertion succeeded, we need to assign this tuple a new flow identifier
+        if (insert.second)
+        {
+            insert.first->second = GetNewFlowId();
+            NS_ASSERT_MSG(insert.first->second == m_flows.size() + 1,
+                          "FlowIds are not assigned in sequence");
+            FlowData& flow = m_flows.emplace_back();
+            flow.tuple = tuple;
+            // the first packet gets identifier 0
+            flow.lastPacketId = std::numeric_limits<FlowPacketId>::max();
+            flow.dscpCount.fill(0);
+        }
+        flowId = insert.first->second;
+        m_lastTuple = tuple;
+        m_lastFlowId = flowId;
     }
 
-    // increment the counter of packets with the same DSCP value
-    Ipv4Header::DscpType dscp = ipHeader.GetDscp();
-    auto dscpInserter = m_flowDscpMap[insert.first->second].insert(
-        std::pair<Ipv4Header::DscpType, uint32_t>(dscp, 1));
+    FlowData& flow = m_flows[flowId - 1];
+    flow.lastPacketId++;
 
-    // if the insertion did not succeed, we need to increment the counter
-    if (!dscpInserter.second)
-    {
-        m_flowDscpMap[insert.first->second][dscp]++;
-    }
+    // increment the counter of packets with the same DSCP value
+    flow.dscpCount[ipHeader.GetDscp() & 0x3f]++;
 
-    *out_flowId = insert.first->second;
-    *out_packetId = m_flowPktIdMap[*out_flowId];
+    *out_flowId = flowId;
+    *out_packetId = flow.lastPacketId;
 
     return true;
 }
 
-Ipv4FlowClassifier::FiveTuple
-Ipv4FlowClassifier::FindFlow(FlowId flowId) const
+const Ipv4FlowClassifier::FlowData&
+Ipv4FlowClassifier::GetFlowData(FlowId flowId) const
 {
-    for (auto iter = m_flowMap.begin(); iter != m_flowMap.end(); iter++)
+    if (flowId == 0 || flowId > m_flows.size())
     {
-        if (iter->second == flowId)
-        {
-            return iter->first;
-        }
+        NS_FATAL_ERROR("Could not find the flow with ID " << flowId);
     }
-    NS_FATAL_ERROR("Could not find the flow with ID " << flowId);
-    FiveTuple retval = {Ipv4Address::GetZero(), Ipv4Address::GetZero(), 0, 0, 0};
-    return retval;
+    return m_flows[flowId - 1];
+}
+
+Ipv4FlowClassifier::FiveTuple
+Ipv4FlowClassifier::FindFlow(FlowId flowId) const
+{
+    return GetFlowData(flowId).tuple;
 }
 
 bool
@@ -191,15 +211,16 @@ Ipv4FlowClassifier::SortByCount::operator()(std::pair<Ipv4Header::DscpType, uint
 std::vector<std::pair<Ipv4Header::DscpType, uint32_t>>
 Ipv4FlowClassifier::GetDscpCounts(FlowId flowId) const
 {
-    auto flow = m_flowDscpMap.find(flowId);
+    const FlowData& flow = GetFlowData(flowId);
 
-    if (flow == m_flowDscpMap.end())
+    std::vector<std::pair<Ipv4Header::DscpType, uint32_t>> v;
+    for (uint32_t dscp = 0; dscp < flow.dscpCount.size(); dscp++)
     {
-        NS_FATAL_ERROR("Could not find the flow with ID " << flowId);
+        if (flow.dscpCount[dscp] > 0)
+        {
+            v.emplace_back(static_cast<Ipv4Header::DscpType>(dscp), flow.dscpCount[dscp]);
+        }
     }
-
-    std::vector<std::pair<Ipv4Header::DscpType, uint32_t>> v(flow->second.begin(),
-                                                             flow->second.end());
     std::sort(v.begin(), v.end(), SortByCount());
     return v;
 }
@@ -210,27 +231,36 @@ Ipv4FlowClassifier::SerializeToXmlStream(std::ostream& os, uint16_t indent) cons
     Indent(os, indent);
     os << "<Ipv4FlowClassifier>\n";
 
+    // the flows are written in the order of their FiveTuple
+    std::vector<FlowId> flowIds(m_flows.size());
+    for (FlowId flowId = 1; flowId <= m_flows.size(); flowId++)
+    {
+        flowIds[flowId - 1] = flowId;
+    }
+    std::sort(flowIds.begin(), flowIds.end(), [this](FlowId left, FlowId right) {
+        return m_flows[left - 1].tuple < m_flows[right - 1].tuple;
+    });
+
     indent += 2;
-    for (auto iter = m_flowMap.begin(); iter != m_flowMap.end(); iter++)
+    for (auto flowId : flowIds)
     {
+        const FlowData& flow = m_flows[flowId - 1];
         Indent(os, indent);
-        os << "<Flow flowId=\"" << iter->second << "\""
-           << " sourceAddress=\"" << iter->first.sourceAddress << "\""
-           << " destinationAddress=\"" << iter->first.destinationAddress << "\""
-           << " protocol=\"" << int(iter->first.protocol) << "\""
-           << " sourcePort=\"" << iter->first.sourcePort << "\""
-           << " destinationPort=\"" << iter->first.destinationPort << "\">\n";
+        os << "<Flow flowId=\"" << flowId << "\""
+           << " sourceAddress=\"" << flow.tuple.sourceAddress << "\""
+           << " destinationAddress=\"" << flow.tuple.destinationAddress << "\""
+           << " protocol=\"" << int(flow.tuple.protocol) << "\""
+           << " sourcePort=\"" << flow.tuple.sourcePort << "\""
+           << " destinationPort=\"" << flow.tuple.destinationPort << "\">\n";
 
         indent += 2;
-        auto flow = m_flowDscpMap.find(iter->second);
-
-        if (flow != m_flowDscpMap.end())
+        for (uint32_t dscp = 0; dscp < flow.dscpCount.size(); dscp++)
         {
-            for (auto i = flow->second.begin(); i != flow->second.end(); i++)
+            if (flow.dscpCount[dscp] > 0)
             {
                 Indent(os, indent);
-                os << "<Dscp value=\"0x" << std::hex << static_cast<uint32_t>(i->first) << "\""
-                   << " packets=\"" << std::dec << i->second << "\" />\n";
+                os << "<Dscp value=\"0x" << std::hex << dscp << "\""
+                   << " packets=\"" << std::dec << flow.dscpCount[dscp] << "\" />\n";
             }
         }
 
@@ -13,8 +13,10 @@
 
 #include "ns3/ipv4-header.h"
 
-#include <map>
+#include <array>
 #include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
@@ -38,6 +40,16 @@ class Ipv4FlowClassifier : public FlowClassifier
         uint16_t destinationPort;       //!< Destination port
     };
 
+    /// Hash function of a FiveTuple, mixing its fields packed in two 64 bits words
+    class FiveTupleHash
+    {
+      public:
+        /// Hash function
+        /// @param tuple the FiveTuple to hash
+        /// @return the hash of the tuple
+        std::size_t operator()(const FiveTuple& tuple) const;
+    };
+
     Ipv4FlowClassifier();
 
     /// @brief try to classify the packet into flow-id and packet-id
@@ -82,12 +94,25 @@ class Ipv4FlowClassifier : public FlowClassifier
     void SerializeToXmlStream(std::ostream& os, uint16_t indent) const override;
 
   private:
+    /// The data of a flow
+    struct FlowData
+    {
+        FiveTuple tuple;                    //!< The FiveTuple of the flow
+        FlowPacketId lastPacketId;          //!< The identifier of the last packet
+        std::array<uint32_t, 64> dscpCount; //!< The number of packets of each DSCP value
+    };
+
+    /// Get the data of a flow
+    /// @param flowId the FlowId of the flow
+    /// @return the data of the flow
+    const FlowData& GetFlowData(FlowId flowId) const;
+
     /// Map to Flows Identifiers to FlowIds
-    std::map<FiveTuple, FlowId> m_flowMap;
-    /// Map to FlowIds to FlowPacketId
-    std::map<FlowId, FlowPacketId> m_flowPktIdMap;
-    /// Map FlowIds to (DSCP value, packet count) pairs
-    std::map<FlowId, std::map<Ipv4Header::DscpType, uint32_t>> m_flowDscpMap;
+    std::unordered_map<FiveTuple, FlowId, FiveTupleHash> m_flowMap;
+    /// FlowId - 1 --> FlowData, as the FlowIds are assigned in sequence
+    std::vector<FlowData> m_flows;
+    FiveTuple m_lastTuple; //!< The FiveTuple of the last classified packet
+    FlowId m_lastFlowId;   //!< The FlowId of the last classified packet, 0 if none
 };
 
 /**
@@ -50,7 +50,9 @@ TcpTxBuffer::TcpTxBuffer(uint32_t n)
     : m_maxBuffer(32768),
       m_size(0),
       m_sentSize(0),
-      m_firstByteSeq(n)
+      m_firstByteSeq(n),
+      m_lostUpTo(n),
+      m_nextSegFrom(n)
 {
     m_rWndCallback = MakeNullCallback<uint32_t>();
 }
@@ -163,6 +165,8 @@ TcpTxBuffer::SetHeadSequence(const SequenceNumber32& seq)
 
     // if you change the head with data already sent, something bad will happen
     NS_ASSERT(m_sentList.empty());
+    m_lostUpTo = seq;
+    m_nextSegFrom = seq;
     m_sackSeen = false;
     m_highestSack = std::make_pair(m_sentList.end(), SequenceNumber32(0));
 }
@@ -285,7 +289,8 @@ TcpTxBuffer::GetNewSegment(uint32_t numBytes)
     NS_ASSERT(it != m_appList.end());
 
     m_appList.erase(it);
-    m_sentList.insert(m_sentList.end(), item);
+    auto sent = m_sentList.insert(m_sentList.end(), item);
+    m_sentIndex.emplace_hint(m_sentIndex.end(), item->m_startSeq, sent);
     m_sentSize += item->m_packet->GetSize();
 
     return item;
@@ -299,37 +304,34 @@ TcpTxBuffer::GetTransmittedSegment(uint32_t numBytes, const SequenceNumber32& se
     NS_ASSERT(numBytes <= m_sentSize);
     NS_ASSERT(!m_sentList.empty());
 
-    auto it = m_sentList.begin();
     bool listEdited = false;
     uint32_t s = numBytes;
 
     // Avoid to merge different packet for this retransmission if flags are
     // different.
-    for (; it != m_sentList.end(); ++it)
+    auto index = m_sentIndex.find(seq);
+    if (index != m_sentIndex.end())
     {
-        if ((*it)->m_startSeq == seq)
+        auto it = index->second;
+        auto next = it;
+        next++;
+        if (next != m_sentList.end())
         {
-            auto next = it;
-            next++;
-            if (next != m_sentList.end())
+            // Next is not sacked and have the same value for m_lost ... there is the
+            // possibility to merge
+            if ((!(*next)->m_sacked) && ((*it)->m_lost == (*next)->m_lost))
             {
-                // Next is not sacked and have the same value for m_lost ... there is the
-                // possibility to merge
-                if ((!(*next)->m_sacked) && ((*it)->m_lost == (*next)->m_lost))
-                {
-                    s = std::min(s, (*it)->m_packet->GetSize() + (*next)->m_packet->GetSize());
-                }
-                else
-                {
-                    // Next is sacked... better to retransmit only the first segment
-                    s = std::min(s, (*it)->m_packet->GetSize());
-                }
+                s = std::min(s, (*it)->m_packet->GetSize() + (*next)->m_packet->GetSize());
             }
             else
             {
+                // Next is sacked... better to retransmit only the first segment
                 s = std::min(s, (*it)->m_packet->GetSize());
             }
-            break;
+        }
+        else
+        {
+            s = std::min(s, (*it)->m_packet->GetSize());
         }
     }
 
@@ -341,6 +343,17 @@ TcpTxBuffer::GetTransmittedSegment(uint32_t numBytes, const SequenceNumber32& se
         item->m_retrans = true;
     }
 
+    // Move the start of the NextSeg walk past the retransmitted or sacked items
+    if (item->m_startSeq <= m_nextSegFrom)
+    {
+        for (auto it = FindSentItem(m_nextSegFrom);
+             it != m_sentList.end() && ((*it)->m_retrans || (*it)->m_sacked);
+             ++it)
+        {
+            m_nextSegFrom = (*it)->m_startSeq + (*it)->m_packet->GetSize();
+        }
+    }
+
     return item;
 }
 
@@ -366,6 +379,22 @@ TcpTxBuffer::FindHighestSacked() const
     return ret;
 }
 
+TcpTxBuffer::PacketList::const_iterator
+TcpTxBuffer::FindSentItem(const SequenceNumber32& seq) const
+{
+    if (m_sentIndex.empty())
+    {
+        return m_sentList.end();
+    }
+
+    auto index = m_sentIndex.upper_bound(seq);
+    if (index != m_sentIndex.begin())
+    {
+        --index;
+    }
+    return index->second;
+}
+
 void
 TcpTxBuffer::SplitItems(TcpTxItem* t1, TcpTxItem* t2, uint32_t size) const
 {
@@ -391,7 +420,7 @@ TcpTxBuffer::GetPacketFromList(PacketList& list,
                                const SequenceNumber32& listStartFrom,
                                uint32_t numBytes,
                                const SequenceNumber32& seq,
-                               bool* listEdited) const
+                               bool* listEdited)
 {
     NS_LOG_FUNCTION(this << numBytes << seq);
 
@@ -425,14 +454,22 @@ TcpTxBuffer::GetPacketFromList(PacketList& list,
     Ptr<Packet> currentPacket = nullptr;
     TcpTxItem* currentItem = nullptr;
     TcpTxItem* outItem = nullptr;
-    auto it = list.begin();
+    PacketList::const_iterator it = list.begin();
     SequenceNumber32 beginOfCurrentPacket = listStartFrom;
 
+    // The sent items are indexed: start from the one holding seq
+    bool isSentList = (&list == &m_sentList);
+    if (isSentList && !list.empty())
+    {
+        it = FindSentItem(seq);
+        beginOfCurrentPacket = (*it)->m_startSeq;
+    }
+
     while (it != list.end())
     {
         currentItem = *it;
         currentPacket = currentItem->m_packet;
-        NS_ASSERT_MSG(list != m_sentList || currentItem->m_startSeq >= m_firstByteSeq,
+        NS_ASSERT_MSG(!isSentList || currentItem->m_startSeq >= m_firstByteSeq,
                       "start: " << m_firstByteSeq
                                 << " currentItem start: " << currentItem->m_startSeq);
 
@@ -461,7 +498,12 @@ TcpTxBuffer::GetPacketFromList(PacketList& list,
                 SplitItems(firstPart, currentItem, seq - beginOfCurrentPacket);
 
                 // insert firstPart before currentItem
-                list.insert(it, firstPart);
+                auto firstIt = list.insert(it, firstPart);
+                if (isSentList)
+                {
+                    m_sentIndex[firstPart->m_startSeq] = firstIt;
+                    m_sentIndex[currentItem->m_startSeq] = it;
+                }
                 if (listEdited)
                 {
                     *listEdited = true;
@@ -507,6 +549,10 @@ TcpTxBuffer::GetPacketFromList(PacketList& list,
                     NS_ASSERT(it != list.begin());
                     TcpTxItem* previous = *(--it);
 
+                    if (isSentList)
+                    {
+                        m_sentIndex.erase(previous->m_startSeq);
+                    }
                     list.erase(it);
 
                     MergeItems(previous, currentItem);
@@ -527,7 +573,12 @@ TcpTxBuffer::GetPacketFromList(PacketList& list,
                 SplitItems(firstPart, currentItem, numBytes);
 
                 // insert firstPart before currentItem
-                list.insert(it, firstPart);
+                auto firstIt = list.insert(it, firstPart);
+                if (isSentList)
+                {
+                    m_sentIndex[firstPart->m_startSeq] = firstIt;
+                    m_sentIndex[currentItem->m_startSeq] = it;
+                }
                 if (listEdited)
                 {
                     *listEdited = true;
@@ -556,6 +607,10 @@ TcpTxBuffer::GetPacketFromList(PacketList& list,
                                      // in the previous if
 
             MergeItems(currentItem, next);
+            if (isSentList)
+            {
+                m_sentIndex.erase(next->m_startSeq);
+            }
             list.erase(it);
 
             delete next;
@@ -697,6 +752,7 @@ TcpTxBuffer::DiscardUpTo(const SequenceNumber32& seq, const Callback<void, TcpTx
 
             RemoveFromCounts(item, pktSize);
 
+            m_sentIndex.erase(item->m_startSeq);
             i = m_sentList.erase(i);
             NS_LOG_INFO("Removed " << *item << " lost: " << m_lostOut << " retrans: " << m_retrans
                                    << " sacked: " << m_sackedOut << ". Remaining data " << m_size);
@@ -715,7 +771,9 @@ TcpTxBuffer::DiscardUpTo(const SequenceNumber32& seq, const Callback<void, TcpTx
             NS_LOG_INFO(*item);
             // PacketTags are preserved when fragmenting
             item->m_packet = item->m_packet->CreateFragment(offset, pktSize);
+            m_sentIndex.erase(item->m_startSeq);
             item->m_startSeq += offset;
+            m_sentIndex.emplace_hint(m_sentIndex.begin(), item->m_startSeq, i);
             m_size -= offset;
             m_sentSize -= offset;
             m_firstByteSeq += offset;
@@ -745,6 +803,8 @@ TcpTxBuffer::DiscardUpTo(const SequenceNumber32& seq, const Callback<void, TcpTx
             // when adding Reno dupacks in the count.
             head->m_sacked = false;
             m_sackedOut -= head->m_packet->GetSize();
+            m_lostUpTo = m_firstByteSeq;
+            m_nextSegFrom = m_firstByteSeq;
             NS_LOG_INFO("Moving the SACK flag from the HEAD to another segment");
             AddRenoSack();
             MarkHeadAsLost();
@@ -761,6 +821,16 @@ TcpTxBuffer::DiscardUpTo(const SequenceNumber32& seq, const Callback<void, TcpTx
         m_highestSack = std::make_pair(m_sentList.end(), SequenceNumber32(0));
     }
 
+    // Keep the marks inside the window, so that they compare right after a wrap
+    if (m_lostUpTo < m_firstByteSeq)
+    {
+        m_lostUpTo = m_firstByteSeq;
+    }
+    if (m_nextSegFrom < m_firstByteSeq)
+    {
+        m_nextSegFrom = m_firstByteSeq;
+    }
+
     NS_LOG_DEBUG("Discarded up to " << seq << " lost: " << m_lostOut << " retrans: " << m_retrans
                                     << " sacked: " << m_sackedOut);
     NS_LOG_LOGIC("Buffer status after discarding data " << *this);
@@ -779,15 +849,20 @@ TcpTxBuffer::Update(const TcpOptionSack::SackList& list, const Callback<void, Tc
 
     for (auto option_it = list.begin(); option_it != list.end(); ++option_it)
     {
-        auto item_it = m_sentList.begin();
-        SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
         if (m_firstByteSeq + m_sentSize < (*option_it).first)
         {
             NS_LOG_INFO("Not updating scoreboard, the option block is outside the sent list");
             return bytesSacked;
         }
 
+        // The items before the one holding the block start cannot be sacked by it
+        auto item_it = FindSentItem((*option_it).first);
+        SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+        if (item_it != m_sentList.end())
+        {
+            beginOfCurrentPacket = (*item_it)->m_startSeq;
+        }
+
         while (item_it != m_sentList.end())
         {
             uint32_t pktSize = (*item_it)->m_packet->GetSize();
@@ -881,12 +956,27 @@ TcpTxBuffer::UpdateLostCount()
                                                  << *(*m_highestSack.first));
     }
 
+    // The end of the item from which all the items below are marked
+    SequenceNumber32 markedUpTo = m_lostUpTo;
+    bool reachedLost = false;
+
     for (auto it = m_highestSack.first; it != m_sentList.begin(); --it)
     {
         TcpTxItem* item = *it;
+        if (item->m_startSeq + item->m_packet->GetSize() <= m_lostUpTo)
+        {
+            // This item and all the items below are already lost or sacked
+            reachedLost = true;
+            break;
+        }
+
         if (item->m_sacked)
         {
             sacked++;
+            if (sacked == m_dupAckThresh)
+            {
+                markedUpTo = item->m_startSeq + item->m_packet->GetSize();
+            }
         }
 
         if (sacked >= m_dupAckThresh)
@@ -900,6 +990,14 @@ TcpTxBuffer::UpdateLostCount()
         beginOfCurrentPacket -= item->m_packet->GetSize();
     }
 
+    if (sacked >= m_dupAckThresh || reachedLost)
+    {
+        if (markedUpTo > m_lostUpTo)
+        {
+            m_lostUpTo = markedUpTo;
+        }
+    }
+
     if (sacked >= m_dupAckThresh)
     {
         TcpTxItem* item = *m_sentList.begin();
@@ -923,11 +1021,9 @@ TcpTxBuffer::IsLost(const SequenceNumber32& seq) const
         return false;
     }
 
-    // In theory, using a map and hints when inserting elements can improve
-    // performance
-    for (auto it = m_sentList.begin(); it != m_sentList.end(); ++it)
+    auto it = FindSentItem(seq);
+    if (it != m_sentList.end())
     {
-        // Search for the right iterator before calling IsLost()
         if ((*it)->m_startSeq <= seq && seq < (*it)->m_startSeq + (*it)->m_packet->GetSize())
         {
             if ((*it)->m_lost)
@@ -970,7 +1066,19 @@ TcpTxBuffer::NextSeg(SequenceNumber32* seq, SequenceNumber32* seqHigh, bool isRe
     bool isSeqPerRule3Valid = false;
     SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
 
-    for (auto it = m_sentList.begin(); it != m_sentList.end(); ++it)
+    // Without lost items, only rule 3 may need the walk. Otherwise, the items
+    // before m_nextSegFrom are retransmitted or sacked, and match no rule
+    auto it = m_sentList.end();
+    if (m_lostOut > 0 || isRecovery)
+    {
+        it = FindSentItem(m_nextSegFrom);
+        if (it != m_sentList.end())
+        {
+            beginOfCurrentPkt = (*it)->m_startSeq;
+        }
+    }
+
+    for (; it != m_sentList.end(); ++it)
     {
         item = *it;
 
@@ -1205,6 +1313,8 @@ TcpTxBuffer::ResetRenoSack()
         (*it)->m_sacked = false;
     }
 
+    m_lostUpTo = m_firstByteSeq;
+    m_nextSegFrom = m_firstByteSeq;
     m_highestSack = std::make_pair(m_sentList.end(), SequenceNumber32(0));
     m_sackSeen = false;
 }
@@ -1230,7 +1340,10 @@ TcpTxBuffer::ResetSentList()
         m_appList.push_front(item);
         m_sentList.pop_back();
     }
+    m_sentIndex.clear();
 
+    m_lostUpTo = m_firstByteSeq;
+    m_nextSegFrom = m_firstByteSeq;
     m_sentSize = 0;
     m_lostOut = 0;
     m_retrans = 0;
@@ -1247,8 +1360,17 @@ TcpTxBuffer::ResetLastSegmentSent()
     {
         TcpTxItem* item = m_sentList.back();
 
+        m_sentIndex.erase(item->m_startSeq);
         m_sentList.pop_back();
         m_sentSize -= item->m_packet->GetSize();
+        if (m_lostUpTo > item->m_startSeq)
+        {
+            m_lostUpTo = item->m_startSeq;
+        }
+        if (m_nextSegFrom > item->m_startSeq)
+        {
+            m_nextSegFrom = item->m_startSeq;
+        }
         if (item->m_retrans)
         {
             m_retrans -= item->m_packet->GetSize();
@@ -1263,6 +1385,7 @@ TcpTxBuffer::SetSentListLost(bool resetSack)
 {
     NS_LOG_FUNCTION(this);
     m_retrans = 0;
+    m_nextSegFrom = m_firstByteSeq;
 
     if (resetSack)
     {
@@ -1333,6 +1456,7 @@ TcpTxBuffer::DeleteRetransmittedFlagFromHead()
     {
         m_sentList.front()->m_retrans = false;
         m_retrans -= m_sentList.front()->m_packet->GetSize();
+        m_nextSegFrom = m_firstByteSeq;
     }
     ConsistencyCheck();
 }
@@ -1345,6 +1469,7 @@ TcpTxBuffer::MarkHeadAsLost()
         // If the head is sacked (reneging by the receiver the previously sent
         // information) we revert the sacked flag.
         // A sacked head means that we should advance SND.UNA.. so it's an error.
+        m_nextSegFrom = m_firstByteSeq;
         if (m_sentList.front()->m_sacked)
         {
             m_sentList.front()->m_sacked = false;
@@ -1423,8 +1548,18 @@ TcpTxBuffer::ConsistencyCheck() const
     uint32_t lost = 0;
     uint32_t retrans = 0;
 
+    NS_ASSERT_MSG(m_sentIndex.size() == m_sentList.size(),
+                  "Indexed items: " << m_sentIndex.size() << " sent items: " << m_sentList.size());
+
     for (auto it = m_sentList.begin(); it != m_sentList.end(); ++it)
     {
+        SequenceNumber32 end = (*it)->m_startSeq + (*it)->m_packet->GetSize();
+        NS_ASSERT_MSG(FindSentItem((*it)->m_startSeq) == it, "Item not indexed: " << *(*it));
+        NS_ASSERT_MSG(end > m_lostUpTo || (*it)->m_lost || (*it)->m_sacked,
+                      "Item " << *(*it) << " below " << m_lostUpTo << " not lost nor sacked");
+        NS_ASSERT_MSG(end > m_nextSegFrom || (*it)->m_retrans || (*it)->m_sacked,
+                      "Item " << *(*it) << " below " << m_nextSegFrom
+                              << " not retransmitted nor sacked");
         if ((*it)->m_sacked)
         {
             sacked += (*it)->m_packet->GetSize();
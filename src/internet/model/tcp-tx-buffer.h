@@ -17,6 +17,9 @@
 #include "ns3/sequence-number.h"
 #include "ns3/traced-value.h"
 
+#include <list>
+#include <map>
+
 namespace ns3
 {
 class Packet;
@@ -80,6 +83,12 @@ class Packet;
  * segments that can be lost (\see UpdateLostCount), and we set the flags
  * accordingly.
  *
+ * The sent items are also indexed by their start sequence, so a SACK block,
+ * a retransmission or an IsLost query reaches its item in logarithmic time
+ * instead of walking the list from the head. The lost marking and NextSeg
+ * remember how far the items are already lost (or retransmitted) or sacked,
+ * and do not walk that part of the list again.
+ *
  * Management of bytes in flight
  * -----------------------------
  *
@@ -417,8 +426,8 @@ class TcpTxBuffer : public Object
      * The {New}Reno cases, for now, are managed in TcpSocketBase through the
      * call to MarkHeadAsLost.
      * This function is, therefore, called after a SACK option has been received,
-     * and updates the lost count. It can be probably optimized by not walking
-     * the entire list, but a subset.
+     * and updates the lost count. The walk goes down from the highest sacked
+     * item and stops at m_lostUpTo, below which nothing can be marked anymore.
      *
      */
     void UpdateLostCount();
@@ -553,7 +562,7 @@ class TcpTxBuffer : public Object
                                  const SequenceNumber32& startingSeq,
                                  uint32_t numBytes,
                                  const SequenceNumber32& requestedSeq,
-                                 bool* listEdited = nullptr) const;
+                                 bool* listEdited = nullptr);
 
     /**
      * @brief Merge two TcpTxItem
@@ -591,8 +600,18 @@ class TcpTxBuffer : public Object
      */
     std::pair<TcpTxBuffer::PacketList::const_iterator, SequenceNumber32> FindHighestSacked() const;
 
+    /**
+     * @brief Find the sent item holding a sequence, through m_sentIndex
+     * @param seq Sequence
+     * @return the item holding seq, the head if seq is below it, the last
+     * item if seq is above the sent data, or m_sentList.end () if nothing was sent
+     */
+    PacketList::const_iterator FindSentItem(const SequenceNumber32& seq) const;
+
     PacketList m_appList;              //!< Buffer for application data
     PacketList m_sentList;             //!< Buffer for sent (but not acked) data
+    std::map<SequenceNumber32, PacketList::const_iterator>
+        m_sentIndex; //!< The items of m_sentList, by their start sequence
     uint32_t m_maxBuffer;              //!< Max number of data bytes in buffer (SND.WND)
     uint32_t m_size;                   //!< Size of all data in this buffer
     uint32_t m_sentSize;               //!< Size of sent (and not discarded) segments
@@ -606,6 +625,9 @@ class TcpTxBuffer : public Object
     uint32_t m_sackedOut{0}; //!< Number of sacked bytes
     uint32_t m_retrans{0};   //!< Number of retransmitted bytes
 
+    SequenceNumber32 m_lostUpTo;    //!< The sent items ending up to here are lost or sacked
+    SequenceNumber32 m_nextSegFrom; //!< The sent items ending up to here are retrans or sacked
+
     uint32_t m_dupAckThresh{0}; //!< Duplicate Ack threshold from TcpSocketBase
     uint32_t m_segmentSize{0};  //!< Segment size from TcpSocketBase
     bool m_renoSack{false};     //!< Indicates if AddRenoSack was called
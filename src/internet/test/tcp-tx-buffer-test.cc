@@ -42,6 +42,8 @@ class TcpTxBufferTestCase : public TestCase
     /** @brief Test the logic of merging items in GetTransmittedSegment()
      * which is triggered by CopyFromSequence()*/
     void TestMergeItemsWhenGetTransmittedSegment();
+    /** @brief Test the scoreboard of a window with many segments and holes */
+    void TestLargeWindow();
     /**
      * @brief Callback to provide a value of receiver window
      * @returns the receiver window size
@@ -89,6 +91,13 @@ TcpTxBufferTestCase::DoRun()
                         &TcpTxBufferTestCase::TestMergeItemsWhenGetTransmittedSegment,
                         this);
 
+    /*
+     * Case for a large window:
+     * -> SACK blocks far from the head, one every two segments
+     * -> retransmissions walk the holes in order
+     */
+    Simulator::Schedule(Seconds(0), &TcpTxBufferTestCase::TestLargeWindow, this);
+
     Simulator::Run();
     Simulator::Destroy();
 }
@@ -409,6 +418,82 @@ TcpTxBufferTestCase::TestMergeItemsWhenGetTransmittedSegment()
     txBuf.CopyFromSequence(2000, SequenceNumber32(1));
 }
 
+void
+TcpTxBufferTestCase::TestLargeWindow()
+{
+    Ptr<TcpTxBuffer> txBuf = CreateObject<TcpTxBuffer>();
+    txBuf->SetRWndCallback(MakeCallback(&TcpTxBufferTestCase::GetRWnd, this));
+    SequenceNumber32 head(1);
+    txBuf->SetHeadSequence(head);
+    SequenceNumber32 ret;
+    SequenceNumber32 retHigh;
+    Ptr<TcpOptionSack> sack = CreateObject<TcpOptionSack>();
+    uint32_t segmentSize = 100;
+    txBuf->SetSegmentSize(segmentSize);
+    txBuf->SetDupAckThresh(3);
+
+    // 200 segments in flight
+    txBuf->Add(Create<Packet>(200 * segmentSize));
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        txBuf->CopyFromSequence(segmentSize, head + (segmentSize * i));
+    }
+
+    // The odd segments from 101 are received, one SACK block at a time
+    for (uint32_t i = 101; i < 200; i += 2)
+    {
+        sack->AddSackBlock(TcpOptionSack::SackBlock(head + (segmentSize * i),
+                                                    head + (segmentSize * (i + 1))));
+        txBuf->Update(sack->GetSackList());
+        sack->ClearSackList();
+    }
+
+    // Below the third highest SACKed segment (195), the segments not SACKed are lost
+    NS_TEST_ASSERT_MSG_EQ(txBuf->GetSacked(), 50 * segmentSize, "Wrong SACKed bytes");
+    NS_TEST_ASSERT_MSG_EQ(txBuf->GetLost(), 148 * segmentSize, "Wrong lost bytes");
+    NS_TEST_ASSERT_MSG_EQ(txBuf->IsLost(head), true, "Head is lost");
+    NS_TEST_ASSERT_MSG_EQ(txBuf->IsLost(head + (segmentSize * 102) + 50),
+                          true,
+                          "Segment 102 is lost");
+    NS_TEST_ASSERT_MSG_EQ(txBuf->IsLost(head + (segmentSize * 103)),
+                          false,
+                          "Segment 103 is SACKed");
+    NS_TEST_ASSERT_MSG_EQ(txBuf->IsLost(head + (segmentSize * 196)),
+                          false,
+                          "Segment 196 has only two SACKed segments above");
+
+    // A block already SACKed changes nothing
+    sack->AddSackBlock(TcpOptionSack::SackBlock(head + (segmentSize * 151),
+                                                head + (segmentSize * 152)));
+    NS_TEST_ASSERT_MSG_EQ(txBuf->Update(sack->GetSackList()), 0, "Block SACKed twice");
+    sack->ClearSackList();
+
+    // The holes are retransmitted in order
+    for (uint32_t i = 0; i < 195; ++i)
+    {
+        if (i >= 101 && i % 2 == 1)
+        {
+            continue;
+        }
+        NS_TEST_ASSERT_MSG_EQ(txBuf->NextSeg(&ret, &retHigh, true), true, "No hole to send");
+        NS_TEST_ASSERT_MSG_EQ(ret, head + (segmentSize * i), "Holes sent out of order");
+        txBuf->CopyFromSequence(segmentSize, ret);
+    }
+    NS_TEST_ASSERT_MSG_EQ(txBuf->GetRetransmitsCount(),
+                          148 * segmentSize,
+                          "Wrong retransmitted bytes");
+
+    // The retransmissions are acknowledged up to the segment 100
+    txBuf->DiscardUpTo(head + (segmentSize * 100));
+    NS_TEST_ASSERT_MSG_EQ(txBuf->GetSacked(), 50 * segmentSize, "Wrong SACKed bytes");
+    NS_TEST_ASSERT_MSG_EQ(txBuf->GetLost(), 48 * segmentSize, "Wrong lost bytes");
+    NS_TEST_ASSERT_MSG_EQ(txBuf->IsLost(head + (segmentSize * 194)), true, "Segment 194 is lost");
+
+    // Only the segments above the third highest SACKed one are left, per rule 3
+    NS_TEST_ASSERT_MSG_EQ(txBuf->NextSeg(&ret, &retHigh, true), true, "No segment to send");
+    NS_TEST_ASSERT_MSG_EQ(ret, head + (segmentSize * 196), "Wrong segment per rule 3");
+}
+
 void
 TcpTxBufferTestCase::TestTransmittedBlock()
 {
@@ -758,7 +758,7 @@ class Buffer
      * writing data. i.e., m_start should be initialized to this
      * value.
      */
-    static uint32_t g_recommendedStart;
+    static thread_local uint32_t g_recommendedStart;
 
     /**
      * offset to the start of the virtual zero area from the start
@@ -791,9 +791,9 @@ class Buffer
         ~LocalStaticDestructor();
     };
 
-    static uint32_t g_maxSize;                            //!< Max observed data size
-    static FreeList* g_freeList;                          //!< Buffer data container
-    static LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+    static thread_local uint32_t g_maxSize;                            //!< Max observed data size
+    static thread_local FreeList* g_freeList;                          //!< Buffer data container
+    static thread_local LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
 
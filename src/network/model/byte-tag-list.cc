@@ -38,6 +38,14 @@ struct ByteTagListData
 };
 
 #ifdef USE_FREE_LIST
+/**
+ * False once the free list of the calling thread is destroyed.
+ *
+ * The thread_local free list goes before the static objects, so the tag
+ * lists they still hold are released without it.
+ */
+static thread_local bool g_freeListAlive = true;
+
 /**
  * @ingroup packet
  *
@@ -45,17 +53,18 @@ struct ByteTagListData
  *
  * Internal use only.
  */
-static class ByteTagListDataFreeList : public std::vector<ByteTagListData*>
+static thread_local class ByteTagListDataFreeList : public std::vector<ByteTagListData*>
 {
   public:
     ~ByteTagListDataFreeList();
 } g_freeList; //!< Container for struct ByteTagListData
 
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+static thread_local uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList()
 {
     NS_LOG_FUNCTION(this);
+    g_freeListAlive = false;
     for (auto i = begin(); i != end(); i++)
     {
         auto buffer = (uint8_t*)(*i);
@@ -344,7 +353,7 @@ ByteTagListData*
 ByteTagList::Allocate(uint32_t size)
 {
     NS_LOG_FUNCTION(this << size);
-    while (!g_freeList.empty())
+    while (g_freeListAlive && !g_freeList.empty())
     {
         ByteTagListData* data = g_freeList.back();
         g_freeList.pop_back();
@@ -378,7 +387,7 @@ ByteTagList::Deallocate(ByteTagListData* data)
     data->count--;
     if (data->count == 0)
     {
-        if (g_freeList.size() > FREE_LIST_SIZE || data->size < g_maxSize)
+        if (!g_freeListAlive || g_freeList.size() > FREE_LIST_SIZE || data->size < g_maxSize)
         {
             auto buffer = (uint8_t*)data;
             delete[] buffer;
@@ -22,6 +22,7 @@
 #include "ns3/mac48-address.h"
 #include "ns3/ptr.h"
 
+#include <atomic>
 #include <stdint.h>
 
 namespace ns3
@@ -784,7 +785,7 @@ class Packet : public SimpleRefCount<Packet>
     /* Please see comments above about nix-vector */
     mutable Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-    static uint32_t m_globalUid; //!< Global counter of packets Uid
+    static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid
 };
 
 /**
@@ -9,11 +9,13 @@
 #include "ns3/abort.h"
 #include "ns3/config.h"
 #include "ns3/log.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include "ns3/names.h"
 #include "ns3/net-device-queue-interface.h"
 #include "ns3/packet.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-partition-channel.h"
 #include "ns3/simulator.h"
 
 #ifdef NS3_MPI
@@ -251,40 +253,61 @@ PointToPointHelper::Install(Ptr<Node> a, Ptr<Node> b)
 
     Ptr<PointToPointChannel> channel = nullptr;
 
-    // If MPI is enabled, we need to see if both nodes have the same system id
-    // (rank), and the rank is the same as this instance.  If both are true,
-    // use a normal p2p channel, otherwise use a remote channel
-#ifdef NS3_MPI
-    bool useNormalChannel = true;
-    if (MpiInterface::IsEnabled())
+    // With the multithreaded simulator, each node is run by the partition
+    // of its system id, and a link between two partitions needs a channel
+    // that hands the packets over to the other partition
+    auto partitions = DynamicCast<MultithreadedSimulatorImpl>(Simulator::GetImplementation());
+    if (partitions)
     {
-        uint32_t n1SystemId = a->GetSystemId();
-        uint32_t n2SystemId = b->GetSystemId();
-        uint32_t currSystemId = MpiInterface::GetSystemId();
-        if (n1SystemId != currSystemId || n2SystemId != currSystemId)
-        {
-            useNormalChannel = false;
-        }
+        partitions->SetPartition(a->GetId(), a->GetSystemId());
+        partitions->SetPartition(b->GetId(), b->GetSystemId());
     }
-    if (useNormalChannel)
+    if (partitions && a->GetSystemId() != b->GetSystemId())
     {
-        m_channelFactory.SetTypeId("ns3::PointToPointChannel");
-        channel = m_channelFactory.Create<PointToPointChannel>();
+        ObjectFactory factory = m_channelFactory;
+        factory.SetTypeId("ns3::PointToPointPartitionChannel");
+        channel = factory.Create<PointToPointPartitionChannel>();
+        TimeValue delay;
+        channel->GetAttribute("Delay", delay);
+        partitions->UpdateLookahead(delay.Get());
     }
     else
     {
-        m_channelFactory.SetTypeId("ns3::PointToPointRemoteChannel");
-        channel = m_channelFactory.Create<PointToPointRemoteChannel>();
-        Ptr<MpiReceiver> mpiRecA = CreateObject<MpiReceiver>();
-        Ptr<MpiReceiver> mpiRecB = CreateObject<MpiReceiver>();
-        mpiRecA->SetReceiveCallback(MakeCallback(&PointToPointNetDevice::Receive, devA));
-        mpiRecB->SetReceiveCallback(MakeCallback(&PointToPointNetDevice::Receive, devB));
-        devA->AggregateObject(mpiRecA);
-        devB->AggregateObject(mpiRecB);
-    }
+        // If MPI is enabled, we need to see if both nodes have the same system id
+        // (rank), and the rank is the same as this instance.  If both are true,
+        // use a normal p2p channel, otherwise use a remote channel
+#ifdef NS3_MPI
+        bool useNormalChannel = true;
+        if (MpiInterface::IsEnabled())
+        {
+            uint32_t n1SystemId = a->GetSystemId();
+            uint32_t n2SystemId = b->GetSystemId();
+            uint32_t currSystemId = MpiInterface::GetSystemId();
+            if (n1SystemId != currSystemId || n2SystemId != currSystemId)
+            {
+                useNormalChannel = false;
+            }
+        }
+        if (useNormalChannel)
+        {
+            m_channelFactory.SetTypeId("ns3::PointToPointChannel");
+            channel = m_channelFactory.Create<PointToPointChannel>();
+        }
+        else
+        {
+            m_channelFactory.SetTypeId("ns3::PointToPointRemoteChannel");
+            channel = m_channelFactory.Create<PointToPointRemoteChannel>();
+            Ptr<MpiReceiver> mpiRecA = CreateObject<MpiReceiver>();
+            Ptr<MpiReceiver> mpiRecB = CreateObject<MpiReceiver>();
+            mpiRecA->SetReceiveCallback(MakeCallback(&PointToPointNetDevice::Receive, devA));
+            mpiRecB->SetReceiveCallback(MakeCallback(&PointToPointNetDevice::Receive, devB));
+            devA->AggregateObject(mpiRecA);
+            devB->AggregateObject(mpiRecB);
+        }
 #else
-    channel = m_channelFactory.Create<PointToPointChannel>();
+        channel = m_channelFactory.Create<PointToPointChannel>();
 #endif
+    }
 
     devA->Attach(channel);
     devB->Attach(channel);
@@ -9,6 +9,7 @@
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
 
+#include "ns3/boolean.h"
 #include "ns3/error-model.h"
 #include "ns3/llc-snap-header.h"
 #include "ns3/log.h"
@@ -60,6 +61,19 @@ PointToPointNetDevice::GetTypeId()
                           TimeValue(Seconds(0)),
                           MakeTimeAccessor(&PointToPointNetDevice::m_tInterframeGap),
                           MakeTimeChecker())
+            .AddAttribute("PacketTrain",
+                          "Send the packets waiting in the transmit queue back to back "
+                          "with a single transmit complete event",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&PointToPointNetDevice::m_packetTrain),
+                          MakeBooleanChecker())
+            .AddAttribute("MaxTrainPackets",
+                          "The largest number of packets of a train. The packets of a train "
+                          "leave the transmit queue together, so this also bounds how far a "
+                          "higher priority packet queued above the device can be delayed",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&PointToPointNetDevice::m_maxTrainPackets),
+                          MakeUintegerChecker<uint32_t>(1))
 
             //
             // Transmit queueing discipline for the device which includes its own set
@@ -165,6 +179,8 @@ PointToPointNetDevice::GetTypeId()
 
 PointToPointNetDevice::PointToPointNetDevice()
     : m_txMachineState(READY),
+      m_packetTrain(false),
+      m_maxTrainPackets(16),
       m_channel(nullptr),
       m_linkUp(false),
       m_currentPkt(nullptr)
@@ -241,17 +257,59 @@ PointToPointNetDevice::TransmitStart(Ptr<Packet> p)
     Time txTime = m_bps.CalculateBytesTxTime(p->GetSize());
     Time txCompleteTime = txTime + m_tInterframeGap;
 
-    NS_LOG_LOGIC("Schedule TransmitCompleteEvent in " << txCompleteTime.As(Time::S));
-    Simulator::Schedule(txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
-
     bool result = m_channel->TransmitStart(p, this, txTime);
     if (!result)
     {
         m_phyTxDropTrace(p);
     }
+
+    //
+    // In train mode the packets already waiting in the queue follow back to
+    // back.  Each one still reaches the peer at its own time, only the
+    // transmit complete events between them are saved.  The per packet
+    // traces are fired at their time by an event of their own, only if they
+    // have sinks.
+    //
+    uint32_t trainPackets = 1;
+    while (m_packetTrain && trainPackets < m_maxTrainPackets && !m_queue->IsEmpty())
+    {
+        Ptr<Packet> next = m_queue->Dequeue();
+        if (!m_phyTxEndTrace.IsEmpty() || !m_snifferTrace.IsEmpty() ||
+            !m_promiscSnifferTrace.IsEmpty() || !m_phyTxBeginTrace.IsEmpty())
+        {
+            Simulator::Schedule(txCompleteTime,
+                                &PointToPointNetDevice::TrainBoundary,
+                                this,
+                                m_currentPkt,
+                                next);
+        }
+        m_currentPkt = next;
+        Time nextTxTime = m_bps.CalculateBytesTxTime(next->GetSize());
+        // the channel delivers at the end of the given time plus its delay
+        if (!m_channel->TransmitStart(next, this, txCompleteTime + nextTxTime))
+        {
+            m_phyTxDropTrace(next);
+        }
+        txCompleteTime += nextTxTime + m_tInterframeGap;
+        trainPackets++;
+    }
+
+    NS_LOG_LOGIC("Schedule TransmitCompleteEvent in " << txCompleteTime.As(Time::S));
+    Simulator::Schedule(txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
     return result;
 }
 
+void
+PointToPointNetDevice::TrainBoundary(Ptr<Packet> sent, Ptr<Packet> next)
+{
+    NS_LOG_FUNCTION(this << sent << next);
+    // the traces of TransmitComplete and TransmitStart between two packets
+    m_phyTxEndTrace(sent);
+    m_snifferTrace(next);
+    m_promiscSnifferTrace(next);
+    m_phyTxBeginTrace(next);
+}
+
 void
 PointToPointNetDevice::TransmitComplete()
 {
@@ -250,6 +250,14 @@ class PointToPointNetDevice : public NetDevice
      */
     void TransmitComplete();
 
+    /**
+     * Fire the traces between two packets of a train.
+     *
+     * @param sent the packet whose transmission ends
+     * @param next the packet whose transmission starts
+     */
+    void TrainBoundary(Ptr<Packet> sent, Ptr<Packet> next);
+
     /**
      * @brief Make the link up and running
      *
@@ -271,6 +279,16 @@ class PointToPointNetDevice : public NetDevice
      */
     TxMachineState m_txMachineState;
 
+    /**
+     * Whether the packets waiting in the queue are sent back to back as a train.
+     */
+    bool m_packetTrain;
+
+    /**
+     * The largest number of packets of a train.
+     */
+    uint32_t m_maxTrainPackets;
+
     /**
      * The data rate that the Net Device uses to simulate packet transmission
      * timing.
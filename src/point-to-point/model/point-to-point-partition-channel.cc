@@ -0,0 +1,77 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "point-to-point-partition-channel.h"
+
+#include "point-to-point-net-device.h"
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PointToPointPartitionChannel");
+
+NS_OBJECT_ENSURE_REGISTERED(PointToPointPartitionChannel);
+
+TypeId
+PointToPointPartitionChannel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::PointToPointPartitionChannel")
+                            .SetParent<PointToPointChannel>()
+                            .SetGroupName("PointToPoint")
+                            .AddConstructor<PointToPointPartitionChannel>();
+    return tid;
+}
+
+PointToPointPartitionChannel::PointToPointPartitionChannel()
+    : PointToPointChannel(),
+      m_device{nullptr, nullptr},
+      m_node{0, 0}
+{
+}
+
+PointToPointPartitionChannel::~PointToPointPartitionChannel()
+{
+}
+
+void
+PointToPointPartitionChannel::Attach(Ptr<PointToPointNetDevice> device)
+{
+    NS_LOG_FUNCTION(this << device);
+    std::size_t wire = GetNDevices();
+    PointToPointChannel::Attach(device);
+    m_device[wire] = PeekPointer(device);
+    m_node[wire] = device->GetNode()->GetId();
+}
+
+bool
+PointToPointPartitionChannel::TransmitStart(Ptr<const Packet> p,
+                                            Ptr<PointToPointNetDevice> src,
+                                            Time txTime)
+{
+    NS_LOG_FUNCTION(this << p << src);
+    NS_LOG_LOGIC("UID is " << p->GetUid() << ")");
+
+    uint32_t dst = PeekPointer(src) == m_device[0] ? 1 : 0;
+
+    // a copy of the packet would share its buffer with the sender
+    std::vector<uint8_t> buffer(p->GetSerializedSize());
+    p->Serialize(buffer.data(), buffer.size());
+    Ptr<Packet> copy = Create<Packet>(buffer.data(), buffer.size(), true);
+
+    Simulator::ScheduleWithContext(m_node[dst],
+                                   txTime + GetDelay(),
+                                   &PointToPointNetDevice::Receive,
+                                   m_device[dst],
+                                   copy);
+    return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+// This object connects two point-to-point net devices run by two
+// partitions of the multithreaded simulator.  It over-rides the transmit
+// method to hand a private copy of the packet to the other partition.
+
+#ifndef POINT_TO_POINT_PARTITION_CHANNEL_H
+#define POINT_TO_POINT_PARTITION_CHANNEL_H
+
+#include "point-to-point-channel.h"
+
+namespace ns3
+{
+
+/**
+ * @ingroup point-to-point
+ *
+ * @brief A Point-To-Point Channel between two partitions
+ *
+ * This object connects two point-to-point net devices whose nodes are run
+ * by different partitions of the MultithreadedSimulatorImpl.  The packet
+ * is received by the other partition, possibly on another thread, so it is
+ * serialized into a new packet that shares no buffer with the sender, and
+ * the receiving device is held by a plain pointer to leave its reference
+ * count to its own partition.  The propagation delay of the channel must
+ * be at least the lookahead of the simulator; the helper registers it.
+ */
+class PointToPointPartitionChannel : public PointToPointChannel
+{
+  public:
+    /**
+     * @brief Get the TypeId
+     *
+     * @return The TypeId for this class
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * @brief Constructor
+     */
+    PointToPointPartitionChannel();
+
+    /**
+     * @brief Deconstructor
+     */
+    ~PointToPointPartitionChannel() override;
+
+    /**
+     * @brief Attach a given netdevice to this channel
+     * @param device pointer to the netdevice to attach to the channel
+     */
+    void Attach(Ptr<PointToPointNetDevice> device) override;
+
+    /**
+     * @brief Transmit the packet
+     *
+     * @param p Packet to transmit
+     * @param src Source PointToPointNetDevice
+     * @param txTime Transmit time to apply
+     * @returns true if successful (currently always true)
+     */
+    bool TransmitStart(Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime) override;
+
+  private:
+    PointToPointNetDevice* m_device[2]; //!< The devices, by wire
+    uint32_t m_node[2];                 //!< The node id of the devices, by wire
+};
+
+} // namespace ns3
+
+#endif
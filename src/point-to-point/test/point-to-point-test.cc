@@ -6,14 +6,21 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include "ns3/boolean.h"
+#include "ns3/config.h"
 #include "ns3/drop-tail-queue.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include "ns3/net-device-queue-interface.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-helper.h"
 #include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-partition-channel.h"
 #include "ns3/simulator.h"
+#include "ns3/string.h"
 #include "ns3/test.h"
 
 #include <string>
+#include <vector>
 
 using namespace ns3;
 
@@ -128,6 +135,284 @@ PointToPointTest::DoRun()
     Simulator::Destroy();
 }
 
+/**
+ * @brief Test class for the PointToPointPartitionChannel
+ *
+ * It sends one packet between two nodes run by two partitions of the
+ * MultithreadedSimulatorImpl, over the channel installed by the helper.
+ */
+class PointToPointPartitionTest : public TestCase
+{
+  public:
+    /**
+     * @brief Create the test
+     */
+    PointToPointPartitionTest();
+
+    /**
+     * @brief Run the test
+     */
+    void DoRun() override;
+
+    /**
+     * @brief Restore the default simulator
+     */
+    void DoTeardown() override;
+
+  private:
+    Ptr<const Packet> m_recvdPacket; //!< received packet
+    Time m_recvdTime;                //!< time of the reception
+    /**
+     * @brief Send one packet to the device specified
+     *
+     * @param device NetDevice to send to.
+     * @param buffer Payload content of the packet.
+     * @param size Size of the payload.
+     */
+    void SendOnePacket(Ptr<NetDevice> device, const uint8_t* buffer, uint32_t size);
+    /**
+     * @brief Callback function which sets the recvdPacket parameter
+     *
+     * @param dev The receiving device.
+     * @param pkt The received packet.
+     * @param mode The protocol mode used.
+     * @param sender The sender address.
+     *
+     * @return A boolean indicating packet handled properly.
+     */
+    bool RxPacket(Ptr<NetDevice> dev, Ptr<const Packet> pkt, uint16_t mode, const Address& sender);
+};
+
+PointToPointPartitionTest::PointToPointPartitionTest()
+    : TestCase("PointToPoint between two partitions")
+{
+}
+
+void
+PointToPointPartitionTest::SendOnePacket(Ptr<NetDevice> device,
+                                         const uint8_t* buffer,
+                                         uint32_t size)
+{
+    Ptr<Packet> p = Create<Packet>(buffer, size);
+    device->Send(p, device->GetBroadcast(), 0x800);
+}
+
+bool
+PointToPointPartitionTest::RxPacket(Ptr<NetDevice> dev,
+                                    Ptr<const Packet> pkt,
+                                    uint16_t mode,
+                                    const Address& sender)
+{
+    m_recvdPacket = pkt;
+    m_recvdTime = Simulator::Now();
+    return true;
+}
+
+void
+PointToPointPartitionTest::DoRun()
+{
+    Simulator::Destroy();
+    Config::SetGlobal("SimulatorImplementationType",
+                      StringValue("ns3::MultithreadedSimulatorImpl"));
+
+    Ptr<Node> a = CreateObject<Node>(0);
+    Ptr<Node> b = CreateObject<Node>(1);
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("8Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("10us"));
+    NetDeviceContainer devices = p2p.Install(a, b);
+
+    auto partitions = DynamicCast<MultithreadedSimulatorImpl>(Simulator::GetImplementation());
+    NS_TEST_ASSERT_MSG_NE(partitions, nullptr, "not the multithreaded simulator");
+    NS_TEST_EXPECT_MSG_EQ(partitions->GetPartitionCount(), 2, "one partition per node");
+    NS_TEST_EXPECT_MSG_EQ(partitions->GetLookahead(), MicroSeconds(10), "lookahead of the link");
+    NS_TEST_EXPECT_MSG_NE(DynamicCast<PointToPointPartitionChannel>(devices.Get(0)->GetChannel()),
+                          nullptr,
+                          "not a partition channel");
+
+    devices.Get(1)->SetReceiveCallback(MakeCallback(&PointToPointPartitionTest::RxPacket, this));
+    uint8_t txBuffer[] = "\"Can you tell me where my country lies?\" \\ said the unifaun to his "
+                         "true love's eyes. \\ \"It lies with me!\" cried the Queen of Maybe \\ - "
+                         "for her merchandise, he traded in his prize.";
+    size_t txBufferSize = sizeof(txBuffer);
+
+    Simulator::ScheduleWithContext(a->GetId(),
+                                   Seconds(1),
+                                   &PointToPointPartitionTest::SendOnePacket,
+                                   this,
+                                   devices.Get(0),
+                                   txBuffer,
+                                   txBufferSize);
+
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_NE(m_recvdPacket, nullptr, "no packet received");
+    NS_TEST_EXPECT_MSG_EQ(m_recvdPacket->GetSize(), txBufferSize, "trivial");
+    // the ppp header is 2 bytes, at 1 byte per us
+    NS_TEST_EXPECT_MSG_EQ(m_recvdTime,
+                          Seconds(1) + MicroSeconds(txBufferSize + 2 + 10),
+                          "wrong reception time");
+
+    uint8_t rxBuffer[1500];
+    m_recvdPacket->CopyData(rxBuffer, txBufferSize);
+    NS_TEST_EXPECT_MSG_EQ(memcmp(rxBuffer, txBuffer, txBufferSize), 0, "trivial");
+    m_recvdPacket = nullptr;
+
+    Simulator::Destroy();
+}
+
+void
+PointToPointPartitionTest::DoTeardown()
+{
+    Config::SetGlobal("SimulatorImplementationType", StringValue("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * @brief Test class for the packet train mode of the PointToPointNetDevice
+ *
+ * It sends a burst of packets with and without trains: the receptions and
+ * the PhyTxEnd traces must have the same times, with fewer events.
+ */
+class PointToPointTrainTest : public TestCase
+{
+  public:
+    /**
+     * @brief Create the test
+     */
+    PointToPointTrainTest();
+
+    /**
+     * @brief Run the test
+     */
+    void DoRun() override;
+
+  private:
+    /**
+     * @brief Send a burst of packets over a link
+     *
+     * @param train Whether the packet train mode is on.
+     * @param traced Whether PhyTxEnd has a sink.
+     */
+    void RunBurst(bool train, bool traced);
+    /**
+     * @brief Send the packets of the burst to the device
+     *
+     * @param device NetDevice to send to.
+     */
+    void SendBurst(Ptr<NetDevice> device);
+    /**
+     * @brief Callback function which records the reception time
+     *
+     * @param dev The receiving device.
+     * @param pkt The received packet.
+     * @param mode The protocol mode used.
+     * @param sender The sender address.
+     *
+     * @return A boolean indicating packet handled properly.
+     */
+    bool RxPacket(Ptr<NetDevice> dev, Ptr<const Packet> pkt, uint16_t mode, const Address& sender);
+    /**
+     * @brief Record the end of a transmission
+     *
+     * @param pkt The transmitted packet.
+     */
+    void TxEnd(Ptr<const Packet> pkt);
+
+    std::vector<Time> m_rxTimes;    //!< times of the receptions
+    std::vector<Time> m_txEndTimes; //!< times of the PhyTxEnd traces
+    uint64_t m_events;              //!< events of the last burst
+
+    static const uint32_t BURST = 6;   //!< packets of the burst
+    static const uint32_t SIZE = 98;   //!< payload of a packet, 100 bytes with the ppp header
+};
+
+PointToPointTrainTest::PointToPointTrainTest()
+    : TestCase("PointToPoint packet train"),
+      m_events(0)
+{
+}
+
+void
+PointToPointTrainTest::SendBurst(Ptr<NetDevice> device)
+{
+    for (uint32_t i = 0; i < BURST; i++)
+    {
+        device->Send(Create<Packet>(SIZE), device->GetBroadcast(), 0x800);
+    }
+}
+
+bool
+PointToPointTrainTest::RxPacket(Ptr<NetDevice> dev,
+                                Ptr<const Packet> pkt,
+                                uint16_t mode,
+                                const Address& sender)
+{
+    m_rxTimes.push_back(Simulator::Now());
+    return true;
+}
+
+void
+PointToPointTrainTest::TxEnd(Ptr<const Packet> pkt)
+{
+    m_txEndTimes.push_back(Simulator::Now());
+}
+
+void
+PointToPointTrainTest::RunBurst(bool train, bool traced)
+{
+    m_rxTimes.clear();
+    m_txEndTimes.clear();
+    Config::SetDefault("ns3::PointToPointNetDevice::PacketTrain", BooleanValue(train));
+    Ptr<Node> a = CreateObject<Node>();
+    Ptr<Node> b = CreateObject<Node>();
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("8Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("10us"));
+    NetDeviceContainer devices = p2p.Install(a, b);
+    devices.Get(1)->SetReceiveCallback(MakeCallback(&PointToPointTrainTest::RxPacket, this));
+    if (traced)
+    {
+        devices.Get(0)->TraceConnectWithoutContext(
+            "PhyTxEnd",
+            MakeCallback(&PointToPointTrainTest::TxEnd, this));
+    }
+
+    Simulator::Schedule(Seconds(1), &PointToPointTrainTest::SendBurst, this, devices.Get(0));
+    Simulator::Run();
+    m_events = Simulator::GetEventCount();
+    Simulator::Destroy();
+    Config::SetDefault("ns3::PointToPointNetDevice::PacketTrain", BooleanValue(false));
+}
+
+void
+PointToPointTrainTest::DoRun()
+{
+    RunBurst(false, true);
+    std::vector<Time> rxTimes = m_rxTimes;
+    std::vector<Time> txEndTimes = m_txEndTimes;
+    NS_TEST_ASSERT_MSG_EQ(txEndTimes.size(), BURST, "PhyTxEnd missed");
+    NS_TEST_ASSERT_MSG_EQ(rxTimes.size(), BURST, "packets lost");
+    for (uint32_t i = 0; i < BURST; i++)
+    {
+        // 100 bytes at 1 byte per us, back to back
+        NS_TEST_EXPECT_MSG_EQ(rxTimes[i],
+                              Seconds(1) + MicroSeconds(100 * (i + 1) + 10),
+                              "wrong reception time");
+    }
+
+    RunBurst(true, true);
+    NS_TEST_EXPECT_MSG_EQ((m_rxTimes == rxTimes), true, "the train changes the receptions");
+    NS_TEST_EXPECT_MSG_EQ((m_txEndTimes == txEndTimes), true, "the train changes PhyTxEnd");
+
+    // without trace sinks only the transmit complete of a train is left
+    RunBurst(false, false);
+    uint64_t events = m_events;
+    RunBurst(true, false);
+    NS_TEST_EXPECT_MSG_EQ((m_rxTimes == rxTimes), true, "the train changes the receptions");
+    // the first packet leaves alone, the others form one train
+    NS_TEST_EXPECT_MSG_EQ(m_events, events - (BURST - 2), "wrong number of saved events");
+}
+
 /**
  * @brief TestSuite for PointToPoint module
  */
@@ -144,6 +429,8 @@ PointToPointTestSuite::PointToPointTestSuite()
     : TestSuite("devices-point-to-point", Type::UNIT)
 {
     AddTestCase(new PointToPointTest, TestCase::Duration::QUICK);
+    AddTestCase(new PointToPointPartitionTest, TestCase::Duration::QUICK);
+    AddTestCase(new PointToPointTrainTest, TestCase::Duration::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
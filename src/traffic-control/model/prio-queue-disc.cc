@@ -64,7 +64,8 @@ PrioQueueDisc::GetTypeId()
 }
 
 PrioQueueDisc::PrioQueueDisc()
-    : QueueDisc(QueueDiscSizePolicy::NO_LIMITS)
+    : QueueDisc(QueueDiscSizePolicy::NO_LIMITS),
+      m_lastBand(0)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -127,6 +128,7 @@ PrioQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
     }
 
     NS_ASSERT_MSG(band < GetNQueueDiscClasses(), "Selected band out of range");
+    m_lastBand = band;
     bool retval = GetQueueDiscClass(band)->GetQueueDisc()->Enqueue(item);
 
     // If Queue::Enqueue fails, QueueDisc::Drop is called by the child queue disc
@@ -160,6 +162,15 @@ PrioQueueDisc::DoDequeue()
     return item;
 }
 
+Ptr<QueueDiscItem>
+PrioQueueDisc::DoBypassDequeue()
+{
+    NS_LOG_FUNCTION(this);
+
+    // the queue disc was empty, hence the item is in the band it was enqueued in
+    return GetQueueDiscClass(m_lastBand)->GetQueueDisc()->Dequeue();
+}
+
 Ptr<const QueueDiscItem>
 PrioQueueDisc::DoPeek()
 {
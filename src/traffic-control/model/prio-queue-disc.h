@@ -71,11 +71,13 @@ class PrioQueueDisc : public QueueDisc
   private:
     bool DoEnqueue(Ptr<QueueDiscItem> item) override;
     Ptr<QueueDiscItem> DoDequeue() override;
+    Ptr<QueueDiscItem> DoBypassDequeue() override;
     Ptr<const QueueDiscItem> DoPeek() override;
     bool CheckConfig() override;
     void InitializeParams() override;
 
     Priomap m_prio2band; //!< Priority to band mapping
+    uint32_t m_lastBand; //!< The band of the last enqueued packet
 };
 
 /**
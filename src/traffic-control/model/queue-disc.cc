@@ -951,6 +951,46 @@ QueueDisc::Run()
     }
 }
 
+bool
+QueueDisc::Bypass(Ptr<QueueDiscItem> item)
+{
+    NS_LOG_FUNCTION(this << item);
+
+    if (m_running || m_requeued || GetNPackets() > 0 ||
+        (m_devQueueIface && m_devQueueIface->GetTxQueue(item->GetTxQueueIndex())->IsStopped()))
+    {
+        return false;
+    }
+
+    if (!Enqueue(item))
+    {
+        // the item was dropped, Run would not find a packet to send
+        return true;
+    }
+
+    // as in Run, the send callback must not start another run of this queue disc
+    m_running = true;
+    Ptr<QueueDiscItem> sent = DoBypassDequeue();
+    NS_ASSERT(m_nPackets == m_stats.nTotalEnqueuedPackets - m_stats.nTotalDequeuedPackets);
+    NS_ASSERT(m_nBytes == m_stats.nTotalEnqueuedBytes - m_stats.nTotalDequeuedBytes);
+    // a queue disc may hold the item back (e.g., to shape the traffic) or drop it
+    // after dequeue, in which case it is sent (if ever) by a later run
+    if (sent)
+    {
+        sent->AddHeader();
+        Transmit(sent);
+    }
+    m_running = false;
+    return true;
+}
+
+Ptr<QueueDiscItem>
+QueueDisc::DoBypassDequeue()
+{
+    NS_LOG_FUNCTION(this);
+    return DoDequeue();
+}
+
 bool
 QueueDisc::RunBegin()
 {
@@ -413,6 +413,18 @@ class QueueDisc : public Object
      */
     void Run();
 
+    /**
+     * Modelled after the TCQ_F_CAN_BYPASS path of the Linux function __dev_xmit_skb
+     * (net/core/dev.c). If the queue disc holds no packet, is not running and the
+     * device queue selected for the given item is not stopped, the item is enqueued,
+     * dequeued right away through DoBypassDequeue and sent to the device, without
+     * the dequeue attempts of Run. The statistics and the traces of the queue disc,
+     * its classes and its internal queues are the same as with Enqueue and Run.
+     * @param item item to send
+     * @return false if the queue disc cannot be bypassed (nothing is done), true otherwise
+     */
+    bool Bypass(Ptr<QueueDiscItem> item);
+
     /// Internal queues store QueueDiscItem objects
     typedef Queue<QueueDiscItem> InternalQueue;
 
@@ -575,6 +587,15 @@ class QueueDisc : public Object
      */
     virtual Ptr<QueueDiscItem> DoDequeue() = 0;
 
+    /**
+     * Extract the packet that Bypass has just enqueued into the empty queue disc.
+     * The default implementation calls DoDequeue. Queue discs that select a class
+     * or an internal queue in DoEnqueue may override it to extract the packet from
+     * there, without looking at the (empty) others.
+     * @return 0 if the operation was not successful; the item otherwise.
+     */
+    virtual Ptr<QueueDiscItem> DoBypassDequeue();
+
     /**
      * @brief Return a copy of the next packet the queue disc will extract.
      *
@@ -399,11 +399,17 @@ TrafficControlLayer::Send(Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
     else
     {
         // Enqueue the packet in the queue disc associated with the netdevice queue
-        // selected for the packet and try to dequeue packets from such queue disc
+        // selected for the packet and try to dequeue packets from such queue disc.
+        // If such queue disc is empty and the netdevice queue is not stopped, the
+        // packet is sent right away
         item->SetTxQueueIndex(txq);
 
         Ptr<QueueDisc> qDisc = ndi->second.m_queueDiscsToWake[txq];
         NS_ASSERT(qDisc);
+        if (qDisc->Bypass(item))
+        {
+            return;
+        }
         qDisc->Enqueue(item);
         qDisc->Run();
     }
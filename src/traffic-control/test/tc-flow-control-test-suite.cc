@@ -17,6 +17,7 @@
 #include "ns3/queue.h"
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/simulator.h"
+#include "ns3/socket.h"
 #include "ns3/string.h"
 #include "ns3/test.h"
 #include "ns3/traffic-control-helper.h"
@@ -24,6 +25,7 @@
 #include "ns3/uinteger.h"
 
 #include <algorithm>
+#include <sstream>
 #include <string>
 
 using namespace ns3;
@@ -481,6 +483,164 @@ TcFlowControlTestCase::DoRun()
     Simulator::Destroy();
 }
 
+/**
+ * @ingroup traffic-control-test
+ *
+ * @brief Check that the bypass of an empty queue disc keeps the statistics and the
+ * order of the packets of the Enqueue and Run path
+ *
+ * Two devices have the same prio queue disc with fifo children. The packets of the
+ * first device are sent through the traffic control layer, hence an empty queue disc
+ * is bypassed, while those of the second one are enqueued in the queue disc, which is
+ * then run. Single packets and bursts of packets of several priorities are sent.
+ */
+class TcBypassTestCase : public TestCase
+{
+  public:
+    TcBypassTestCase();
+
+  private:
+    void DoRun() override;
+    /**
+     * Send packets through the traffic control layer and through the queue disc
+     * @param nPackets the number of packets to send on each device
+     */
+    void SendPackets(uint16_t nPackets);
+    /**
+     * Record a packet dequeued from a queue disc
+     * @param log the log of the queue disc
+     * @param item the dequeued item
+     */
+    void Dequeued(std::vector<std::pair<int64_t, uint32_t>>* log, Ptr<const QueueDiscItem> item);
+    /**
+     * Print the statistics of a queue disc and of its children
+     * @param qdisc the queue disc
+     * @return the statistics
+     */
+    std::string PrintStats(Ptr<QueueDisc> qdisc);
+
+    Ptr<NetDevice> m_bypassDev;                                  //!< the device sent to through tc
+    Ptr<QueueDisc> m_qdisc;                                      //!< the queue disc run directly
+    std::vector<std::pair<int64_t, uint32_t>> m_bypassDequeued;  //!< dequeue times and sizes
+    std::vector<std::pair<int64_t, uint32_t>> m_runDequeued;     //!< dequeue times and sizes
+    uint32_t m_sent;                                             //!< packets sent on each device
+};
+
+TcBypassTestCase::TcBypassTestCase()
+    : TestCase("Test the bypass of an empty queue disc"),
+      m_sent(0)
+{
+}
+
+void
+TcBypassTestCase::SendPackets(uint16_t nPackets)
+{
+    Ptr<TrafficControlLayer> tc = m_bypassDev->GetNode()->GetObject<TrafficControlLayer>();
+    for (uint16_t i = 0; i < nPackets; i++)
+    {
+        uint32_t size = 500 + 100 * (m_sent % 7);
+        uint8_t priority = (m_sent * 5) % 16;
+        m_sent++;
+
+        SocketPriorityTag priorityTag;
+        priorityTag.SetPriority(priority);
+        Ptr<Packet> p = Create<Packet>(size);
+        p->AddPacketTag(priorityTag);
+        tc->Send(m_bypassDev, Create<QueueDiscTestItem>(p));
+
+        p = Create<Packet>(size);
+        p->AddPacketTag(priorityTag);
+        Ptr<QueueDiscItem> item = Create<QueueDiscTestItem>(p);
+        item->SetTxQueueIndex(0);
+        m_qdisc->Enqueue(item);
+        m_qdisc->Run();
+    }
+}
+
+void
+TcBypassTestCase::Dequeued(std::vector<std::pair<int64_t, uint32_t>>* log,
+                           Ptr<const QueueDiscItem> item)
+{
+    log->emplace_back(Simulator::Now().GetTimeStep(), item->GetSize());
+}
+
+std::string
+TcBypassTestCase::PrintStats(Ptr<QueueDisc> qdisc)
+{
+    std::ostringstream oss;
+    oss << qdisc->GetStats();
+    for (std::size_t i = 0; i < qdisc->GetNQueueDiscClasses(); i++)
+    {
+        Ptr<QueueDisc> child = qdisc->GetQueueDiscClass(i)->GetQueueDisc();
+        oss << child->GetStats();
+        Ptr<QueueDisc::InternalQueue> queue = child->GetInternalQueue(0);
+        oss << " " << queue->GetTotalReceivedPackets() << " " << queue->GetTotalReceivedBytes()
+            << " " << queue->GetTotalDroppedPackets();
+    }
+    return oss.str();
+}
+
+void
+TcBypassTestCase::DoRun()
+{
+    NodeContainer n;
+    n.Create(3);
+
+    for (uint32_t i = 0; i < n.GetN(); i++)
+    {
+        n.Get(i)->AggregateObject(CreateObject<TrafficControlLayer>());
+    }
+
+    SimpleNetDeviceHelper simple;
+    NetDeviceContainer rxDevC = simple.Install(n.Get(2));
+    simple.SetDeviceAttribute("DataRate", DataRateValue(DataRate("1Mb/s")));
+    simple.SetQueue("ns3::DropTailQueue", "MaxSize", StringValue("2p"));
+    Ptr<SimpleChannel> channel = DynamicCast<SimpleChannel>(rxDevC.Get(0)->GetChannel());
+    m_bypassDev = simple.Install(n.Get(0), channel).Get(0);
+    Ptr<NetDevice> runDev = simple.Install(n.Get(1), channel).Get(0);
+
+    TrafficControlHelper tch;
+    uint16_t handle = tch.SetRootQueueDisc("ns3::PrioQueueDisc");
+    TrafficControlHelper::ClassIdList cid = tch.AddQueueDiscClasses(handle, 3, "ns3::QueueDiscClass");
+    for (auto classId : cid)
+    {
+        tch.AddChildQueueDisc(handle, classId, "ns3::FifoQueueDisc", "MaxSize", StringValue("4p"));
+    }
+    Ptr<QueueDisc> bypassQdisc = tch.Install(m_bypassDev).Get(0);
+    m_qdisc = tch.Install(runDev).Get(0);
+    bypassQdisc->TraceConnectWithoutContext(
+        "Dequeue",
+        MakeCallback(&TcBypassTestCase::Dequeued, this).Bind(&m_bypassDequeued));
+    m_qdisc->TraceConnectWithoutContext(
+        "Dequeue",
+        MakeCallback(&TcBypassTestCase::Dequeued, this).Bind(&m_runDequeued));
+
+    // single packets sent to an idle device, then bursts which fill the device
+    // queue and the queue disc (some packets are dropped)
+    Simulator::Schedule(MilliSeconds(0), &TcBypassTestCase::SendPackets, this, 1);
+    Simulator::Schedule(MilliSeconds(20), &TcBypassTestCase::SendPackets, this, 1);
+    Simulator::Schedule(MilliSeconds(22), &TcBypassTestCase::SendPackets, this, 3);
+    Simulator::Schedule(MilliSeconds(100), &TcBypassTestCase::SendPackets, this, 12);
+    Simulator::Schedule(MilliSeconds(103), &TcBypassTestCase::SendPackets, this, 1);
+    Simulator::Schedule(MilliSeconds(400), &TcBypassTestCase::SendPackets, this, 1);
+
+    Simulator::Run();
+
+    NS_TEST_EXPECT_MSG_EQ(m_bypassDequeued.size(),
+                          m_runDequeued.size(),
+                          "Different number of dequeued packets");
+    NS_TEST_EXPECT_MSG_EQ((m_bypassDequeued == m_runDequeued),
+                          true,
+                          "Different dequeue times or order");
+    bool dropped = bypassQdisc->GetStats().nTotalDroppedPackets > 0;
+    NS_TEST_EXPECT_MSG_EQ(dropped,
+                          true,
+                          "The bursts must overflow the queue disc");
+    NS_TEST_EXPECT_MSG_EQ(PrintStats(bypassQdisc), PrintStats(m_qdisc), "Different statistics");
+
+    Simulator::Destroy();
+}
+
 /**
  * @ingroup traffic-control-test
  *
@@ -515,5 +675,6 @@ static class TcFlowControlTestSuite : public TestSuite
         // also be made parametric.
         AddTestCase(new TcFlowControlTestCase(QueueSizeUnit::BYTES, 5000, 10),
                     TestCase::Duration::QUICK);
+        AddTestCase(new TcBypassTestCase(), TestCase::Duration::QUICK);
     }
 } g_tcFlowControlTestSuite; ///< the test suite
@@ -7,7 +7,10 @@
  */
 
 #include "ns3/core-module.h"
+#include "ns3/scheduler-trace.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath> // sqrt
 #include <fstream>
 #include <iomanip>
@@ -96,6 +99,8 @@ class Bench
         double simu;     /**< Time (s) for simulation. */
         uint64_t pop;    /**< Event population. */
         uint64_t events; /**< Number of events executed. */
+        uint64_t allocs; /**< Events allocated by the global allocator. */
+        uint64_t reused; /**< Events recycled by the event pool. */
     };
 
     /**
@@ -128,6 +133,7 @@ Bench::Run()
 
     DEB("initializing");
     m_count = 0;
+    auto poolStart = EventImpl::GetPoolStats();
 
     timer.Start();
     for (uint64_t i = 0; i < m_population; ++i)
@@ -146,7 +152,13 @@ Bench::Run()
 
     Simulator::Destroy();
 
-    return Result{init, simu, m_population, m_count};
+    auto poolEnd = EventImpl::GetPoolStats();
+    return Result{init,
+                  simu,
+                  m_population,
+                  m_count,
+                  poolEnd.allocated - poolStart.allocated,
+                  poolEnd.reused - poolStart.reused};
 }
 
 void
@@ -230,6 +242,8 @@ class BenchSuite
 
     std::string m_scheduler;       /**< Descriptive string for the scheduler. */
     std::vector<Result> m_results; /**< Store for the run results. */
+    uint64_t m_allocs;             /**< Event allocations in the last run. */
+    uint64_t m_reused;             /**< Recycled events in the last run. */
 
 }; // BenchSuite
 
@@ -259,6 +273,8 @@ BenchSuite::BenchSuite(ObjectFactory& factory,
                        uint64_t runs,
                        Ptr<RandomVariableStream> eventStream,
                        bool calRev)
+    : m_allocs(0),
+      m_reused(0)
 {
     Simulator::SetScheduler(factory);
 
@@ -291,6 +307,8 @@ BenchSuite::BenchSuite(ObjectFactory& factory,
         auto run = bench.Run();
         m_results.push_back(Result::Bench(run));
         m_results.back().Log(i);
+        m_allocs = run.allocs;
+        m_reused = run.reused;
     }
 
     Simulator::Destroy();
@@ -320,6 +338,11 @@ BenchSuite::Header() const
 void
 BenchSuite::Log() const
 {
+    if (!m_results.empty())
+    {
+        LOG("Event allocations per run: " << m_allocs << " global allocator, " << m_reused
+                                          << " recycled");
+    }
     if (m_results.size() < 2)
     {
         LOG("");
@@ -376,6 +399,85 @@ BenchSuite::Log() const
 
 } // BenchSuite::Log()
 
+/**
+ * Replay a recorded scheduler trace on one scheduler type.
+ *
+ * The trace is replayed once to prime, then \p runs times, timing only
+ * the scheduler operations.  Every RemoveNext() is checked against the
+ * recorded event.  The trace is decoded in chunks of \p chunk records,
+ * outside of the timed region.
+ *
+ * @param [in] factory Factory pre-configured to create the desired Scheduler.
+ * @param [in] reader The opened trace.
+ * @param [in] runs The number of replications.
+ * @param [in] chunk The number of records decoded at once.
+ */
+void
+ReplaySuite(ObjectFactory& factory, SchedulerTrace::Reader& reader, uint64_t runs, uint64_t chunk)
+{
+    LOG("");
+    LOG(factory.GetTypeId().GetName() << ": replay");
+    LOG(std::left << std::setw(g_fwidth) << "Run #" << std::setw(g_fwidth) << "Time (s)"
+                  << std::setw(g_fwidth) << "Rate (op/s)" << std::setw(g_fwidth) << "Per (s/op)"
+                  << "Mismatches");
+
+    double sum = 0;
+    std::vector<SchedulerTrace::Record> records;
+    records.reserve(chunk);
+    for (uint64_t i = 0; i <= runs; i++)
+    {
+        Ptr<Scheduler> scheduler = factory.Create<Scheduler>();
+        uint64_t ops = 0;
+        uint64_t mismatches = 0;
+        std::chrono::steady_clock::duration elapsed{0};
+        reader.Rewind();
+        while (reader.Read(records, chunk) > 0)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& record : records)
+            {
+                Scheduler::Event ev{nullptr, {record.ts, record.uid, 0}};
+                switch (record.op)
+                {
+                case SchedulerTrace::INSERT:
+                    scheduler->Insert(ev);
+                    ops++;
+                    break;
+                case SchedulerTrace::REMOVE_NEXT:
+                    if (scheduler->IsEmpty() || scheduler->RemoveNext().key.m_uid != record.uid)
+                    {
+                        mismatches++;
+                    }
+                    ops++;
+                    break;
+                case SchedulerTrace::REMOVE:
+                    scheduler->Remove(ev);
+                    ops++;
+                    break;
+                case SchedulerTrace::CANCEL:
+                    // canceled events stay in the scheduler until they are due
+                    break;
+                }
+            }
+            elapsed += std::chrono::steady_clock::now() - start;
+        }
+        double time = std::chrono::duration<double>(elapsed).count();
+        if (i > 0)
+        {
+            sum += time;
+        }
+        std::string label = i == 0 ? "prime" : std::to_string(i - 1);
+        LOG(std::left << std::setw(g_fwidth) << label << std::setw(g_fwidth) << time
+                      << std::setw(g_fwidth) << ops / time << std::setw(g_fwidth) << time / ops
+                      << mismatches);
+    }
+    if (runs > 0)
+    {
+        LOG(std::left << std::setw(g_fwidth) << "average" << std::setw(g_fwidth) << sum / runs);
+    }
+    LOG("");
+}
+
 /**
  *  Create a RandomVariableStream to generate next event delays.
  *
@@ -446,6 +548,7 @@ main(int argc, char* argv[])
     bool allSched = false;
     bool schedCal = false;
     bool schedHeap = false;
+    bool schedLadder = false;
     bool schedList = false;
     bool schedMap = false; // default scheduler
     bool schedPQ = false;
@@ -455,6 +558,9 @@ main(int argc, char* argv[])
     uint64_t runs = 1;
     std::string filename = "";
     bool calRev = false;
+    bool noPool = false;
+    std::string replay = "";
+    uint64_t chunk = 1 << 20;
 
     CommandLine cmd(__FILE__);
     cmd.Usage("Benchmark the simulator scheduler.\n"
@@ -466,11 +572,16 @@ main(int argc, char* argv[])
               "In the case of either --file form, the input is expected\n"
               "to be ascii, giving the relative event times in ns.\n"
               "\n"
+              "With --replay=\"<filename>\" the schedulers are instead driven by\n"
+              "a trace recorded by setting the attribute\n"
+              "ns3::DefaultSimulatorImpl::SchedulerTraceFile in a simulation.\n"
+              "\n"
               "If no scheduler is specified the MapScheduler will be run.");
     cmd.AddValue("all", "use all schedulers", allSched);
     cmd.AddValue("cal", "use CalendarScheduler", schedCal);
     cmd.AddValue("calrev", "reverse ordering in the CalendarScheduler", calRev);
     cmd.AddValue("heap", "use HeapScheduler", schedHeap);
+    cmd.AddValue("ladder", "use LadderScheduler", schedLadder);
     cmd.AddValue("list", "use ListScheduler", schedList);
     cmd.AddValue("map", "use MapScheduler (default)", schedMap);
     cmd.AddValue("pri", "use PriorityQueue", schedPQ);
@@ -480,6 +591,9 @@ main(int argc, char* argv[])
     cmd.AddValue("runs", "number of runs", runs);
     cmd.AddValue("file", "file of relative event times", filename);
     cmd.AddValue("prec", "printed output precision", g_fwidth);
+    cmd.AddValue("nopool", "allocate every event with the global allocator", noPool);
+    cmd.AddValue("replay", "replay a recorded scheduler trace", replay);
+    cmd.AddValue("chunk", "number of trace records decoded at once", chunk);
     cmd.Parse(argc, argv);
 
     g_me = cmd.GetName() + ": ";
@@ -490,36 +604,75 @@ main(int argc, char* argv[])
     LOG("  Event population size:        " << pop);
     LOG("  Total events per run:         " << total);
     LOG("  Number of runs per scheduler: " << runs);
+    LOG("  Event pool:                   " << (noPool ? "disabled" : "enabled"));
     DEB("debugging is ON");
 
+    EventImpl::SetPoolEnabled(!noPool);
+
     if (allSched)
     {
-        schedCal = schedHeap = schedList = schedMap = schedPQ = true;
+        schedCal = schedHeap = schedLadder = schedList = schedMap = schedPQ = true;
     }
     // Set the default case if nothing else is set
-    if (!(schedCal || schedHeap || schedList || schedMap || schedPQ))
+    if (!(schedCal || schedHeap || schedLadder || schedList || schedMap || schedPQ))
     {
         schedMap = true;
     }
 
-    auto eventStream = GetRandomStream(filename);
+    Ptr<RandomVariableStream> eventStream;
+    SchedulerTrace::Reader reader;
+    if (replay.empty())
+    {
+        eventStream = GetRandomStream(filename);
+    }
+    else
+    {
+        LOG("  Scheduler trace:              " << replay);
+        if (!reader.Open(replay))
+        {
+            NS_FATAL_ERROR("Not a scheduler trace: " << replay);
+        }
+        // count the records once, the replays decode them again chunk by chunk
+        std::vector<SchedulerTrace::Record> records;
+        while (reader.Read(records, chunk) > 0)
+        {
+        }
+        LOG("    Found " << reader.GetRecordCount() << " records");
+    }
+
+    // run one scheduler, on the trace if there is one
+    auto suite = [&](ObjectFactory& factory, uint64_t suiteTotal, bool suiteCalRev) {
+        if (replay.empty())
+        {
+            BenchSuite(factory, pop, suiteTotal, runs, eventStream, suiteCalRev).Log();
+        }
+        else
+        {
+            ReplaySuite(factory, reader, runs, std::max<uint64_t>(chunk, 1));
+        }
+    };
 
     ObjectFactory factory("ns3::MapScheduler");
     if (schedCal)
     {
         factory.SetTypeId("ns3::CalendarScheduler");
         factory.Set("Reverse", BooleanValue(calRev));
-        BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
+        suite(factory, total, calRev);
         if (allSched)
         {
             factory.Set("Reverse", BooleanValue(!calRev));
-            BenchSuite(factory, pop, total, runs, eventStream, !calRev).Log();
+            suite(factory, total, !calRev);
         }
     }
     if (schedHeap)
     {
         factory.SetTypeId("ns3::HeapScheduler");
-        BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
+        suite(factory, total, calRev);
+    }
+    if (schedLadder)
+    {
+        factory.SetTypeId("ns3::LadderScheduler");
+        suite(factory, total, calRev);
     }
     if (schedList)
     {
@@ -530,17 +683,17 @@ main(int argc, char* argv[])
             LOG("Running List scheduler with 1/10 total events");
             listTotal /= 10;
         }
-        BenchSuite(factory, pop, listTotal, runs, eventStream, calRev).Log();
+        suite(factory, listTotal, calRev);
     }
     if (schedMap)
     {
         factory.SetTypeId("ns3::MapScheduler");
-        BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
+        suite(factory, total, calRev);
     }
     if (schedPQ)
     {
         factory.SetTypeId("ns3::PriorityQueueScheduler");
-        BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
+        suite(factory, total, calRev);
     }
 
     return 0;
@@ -0,0 +1,761 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+// End-to-end benchmark of the DDL job manager on fixed spine-leaf topologies.
+// Each scenario builds a spineLeafTopo, generates a job mix from the job templates,
+// runs it through DdlAppManager and reports wall-clock, events/sec, peak RSS,
+// solver time share and packets per simulated GB as JSON. Every scenario runs in
+// its own child process, so the peak RSS is the one of the scenario.
+// Sample usage:
+//   ./ns3 run 'ddl-bench --scenarios=small,medium --output=ddl-bench.json'
+//   ./ns3 run 'ddl-bench --baseline=ddl-bench-base.json --threshold=0.1'
+//   ./ns3 run 'ddl-bench --scenarios=small --tosBranches=crux,equal --branchTime=20ms'
+
+#include "ns3/boolean.h"
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/ddl-app.h"
+#include "ns3/ddl-apps-manager.h"
+#include "ns3/ddl-flow-recv.h"
+#include "ns3/ddl-flow-send.h"
+#include "ns3/ddl-topo.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/ipv4-address-generator.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/system-path.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ns3;
+using json = nlohmann::json;
+
+/// A fixed benchmark configuration
+struct DdlBenchScenario
+{
+    std::string name;        //!< scenario name used in the report
+    uint32_t spineNum;       //!< number of spine switches
+    uint32_t leafNum;        //!< number of leaf switches
+    uint32_t gpuNumPerLeaf;  //!< number of gpus under each leaf
+    uint32_t jobNum;         //!< number of jobs in the mix
+    std::string tosStrategy; //!< DdlAppManager tos strategy
+};
+
+/// The standard scenarios, the crux solver is O(n^4) in the running jobs so the
+/// large one uses the equal strategy
+static const std::vector<DdlBenchScenario> g_scenarios = {
+    {"small", 2, 4, 4, 6, "crux"},
+    {"medium", 16, 64, 8, 48, "crux"},
+    {"large", 64, 256, 8, 192, "equal"},
+};
+
+/// The default job templates cycled through to build the job mix, all have one flow per worker
+static const std::vector<std::string> g_jobMix = {
+    "gpt3-tp2pp2.csv",
+    "gpt3-dp2.csv",
+    "gpt3-pp4.csv",
+    "1-worker.csv",
+};
+
+/// Packets handed to all the point-to-point devices, of all the partitions
+static std::atomic<uint64_t> g_txPackets = 0;
+
+/**
+ * Count a packet handed to a device
+ * @param packet the packet
+ */
+static void
+CountTxPacket(Ptr<const Packet> packet)
+{
+    g_txPackets.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Build the fabric of a scenario
+ * @param scenario the scenario
+ * @param fabric spine-leaf, clos (two pods of the scenario's leafs), fat-tree (the smallest
+ *        one holding the scenario's gpus) or rail (the nvlink groups on rail leafs)
+ * @param oversubscription the oversubscription of the clos tiers
+ * @param nvlinkGroup the gpus of a nvlink group, 0 without nvlink
+ * @return the fabric config
+ */
+static DdlFabricConfig
+BuildFabric(const DdlBenchScenario& scenario,
+            const std::string& fabric,
+            double oversubscription,
+            uint32_t nvlinkGroup)
+{
+    DdlFabricConfig config;
+    if (fabric == "spine-leaf" || fabric == "rail")
+    {
+        config = DdlFabricConfig::spineLeaf(scenario.spineNum,
+                                            scenario.leafNum,
+                                            scenario.gpuNumPerLeaf,
+                                            12500,
+                                            12500);
+        config.railLayout = fabric == "rail";
+    }
+    else if (fabric == "clos")
+    {
+        config = DdlFabricConfig::clos(2,
+                                       scenario.leafNum / 2,
+                                       scenario.spineNum,
+                                       2 * scenario.spineNum,
+                                       scenario.gpuNumPerLeaf,
+                                       12500,
+                                       oversubscription);
+    }
+    else if (fabric == "fat-tree")
+    {
+        uint32_t k = 2;
+        while (k * k * k / 4 < scenario.leafNum * scenario.gpuNumPerLeaf)
+        {
+            k += 2;
+        }
+        config = DdlFabricConfig::fatTree(k, 12500);
+    }
+    else
+    {
+        std::cerr << "Unknown fabric " << fabric << std::endl;
+        exit(1);
+    }
+    config.nvlinkGroupSize = nvlinkGroup;
+    config.nvlinkBandwidth = 150000;
+    return config;
+}
+
+/**
+ * Write a topology config read by spineLeafTopo
+ * @param config the fabric
+ * @param filename the config file
+ */
+static void
+WriteTopoConfig(const DdlFabricConfig& config, const std::string& filename)
+{
+    std::ofstream file(filename);
+    file << "spine_num,leaf_num,gpu_num_per_leaf,spine_leaf_bandwidth,leaf_gpu_bandwidth,"
+            "load_balance,nvlink_group_size,nvlink_bandwidth,pod_num,core_num,"
+            "core_spine_bandwidth,layout\n";
+    file << config.spineNum << "," << config.leafNum << "," << config.gpuNumPerLeaf << ","
+         << config.spineLeafBandwidth << "," << config.leafGpuBandwidth << ","
+         << config.loadBalance << "," << config.nvlinkGroupSize << "," << config.nvlinkBandwidth
+         << "," << config.podNum << "," << config.coreNum << "," << config.coreSpineBandwidth
+         << "," << (config.railLayout ? "rail" : "block") << "\n";
+}
+
+/**
+ * Write the job files of the mix, the jobs arrive one by one every arriveInterval ms
+ * @param scenario the scenario
+ * @param templateDir dir of the job templates
+ * @param traceDir dir to write ddl-job-<jobId>.csv
+ * @param iterNum iterations of every job
+ * @param arriveInterval arrival gap in ms
+ * @param jobMix the job templates cycled through
+ */
+static void
+WriteJobMix(const DdlBenchScenario& scenario,
+            const std::string& templateDir,
+            const std::string& traceDir,
+            uint32_t iterNum,
+            uint32_t arriveInterval,
+            const std::vector<std::string>& jobMix)
+{
+    for (uint32_t jobId = 0; jobId < scenario.jobNum; jobId++)
+    {
+        std::string templateFile = templateDir + jobMix[jobId % jobMix.size()];
+        FlowFeatureMap flowFeatures = loadFlowFeaturesFromCSV(templateFile);
+        if (flowFeatures.empty())
+        {
+            std::cerr << "Failed to load job template " << templateFile << std::endl;
+            exit(1);
+        }
+
+        std::ifstream in(templateFile);
+        std::ofstream out(traceDir + "ddl-job-" + std::to_string(jobId) + ".csv");
+        std::string line;
+        std::getline(in, line);
+        out << line << "\n";
+        while (std::getline(in, line))
+        {
+            if (line.empty())
+            {
+                continue;
+            }
+            // replace job_id, arrive_time and iter_num, keep the rest of the row
+            std::stringstream ss(line);
+            std::string token;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                std::getline(ss, token, ',');
+            }
+            std::string rest;
+            std::getline(ss, rest);
+            out << jobId << "," << jobId * arriveInterval << "," << iterNum << "," << rest
+                << "\n";
+        }
+    }
+}
+
+/**
+ * Run one scenario
+ * @param scenario the scenario
+ * @param templateDir dir of the job templates
+ * @param iterNum iterations of every job
+ * @param arriveInterval arrival gap in ms
+ * @param stopTime simulation stop time
+ * @param telemetryPrefix prefix of the fabric telemetry file, empty to disable it
+ * @param timelinePrefix prefix of the iteration timeline file, empty to disable it
+ * @param fuseBytes the max size of a small flow fused into its upstream flow, 0 to disable it
+ * @param partitioned run the leafs in partitions of the multithreaded simulator
+ * @param packetTrain send the queued packets of the devices as trains
+ * @param flowMonitor install a FlowMonitor on all the nodes
+ * @param flowExportPrefix prefix of the per-interval flow export file, empty to disable it
+ * @param flowExportInterval the time between two lines of a flow in the export
+ * @param tosBranches the tos strategies to fork at branchTime, empty to disable it
+ * @param branchTime the branches fork at the first tos decision from this time
+ * @param intraHost complete the transfers inside a host without packets
+ * @param nvlinkGroup the gpus of a nvlink group, 0 without nvlink
+ * @param placeStrategy the placement of the jobs: lb, sequence or score
+ * @param backfilling the backfilling of the pending jobs: none, easy or conservative
+ * @param jobMix the job templates cycled through
+ * @param fabric the fabric built for the scenario, see BuildFabric
+ * @param oversubscription the oversubscription of the clos tiers
+ * @param linkConfig the per-link bandwidth and delay overrides, empty for none
+ * @return the scenario report, with the reports of the branches under "branches"
+ */
+static json
+RunScenario(const DdlBenchScenario& scenario,
+            const std::string& templateDir,
+            uint32_t iterNum,
+            uint32_t arriveInterval,
+            Time stopTime,
+            const std::string& telemetryPrefix,
+            const std::string& timelinePrefix,
+            uint32_t fuseBytes,
+            bool partitioned,
+            bool packetTrain,
+            bool flowMonitor,
+            const std::string& flowExportPrefix,
+            Time flowExportInterval,
+            const std::vector<std::string>& tosBranches,
+            Time branchTime,
+            bool intraHost,
+            uint32_t nvlinkGroup,
+            const std::string& placeStrategy,
+            const std::string& backfilling,
+            const std::vector<std::string>& jobMix,
+            const std::string& fabric,
+            double oversubscription,
+            const std::string& linkConfig)
+{
+    std::string workDir = SystemPath::MakeTemporaryDirectoryName();
+    SystemPath::MakeDirectories(workDir);
+    std::string traceDir = workDir + "/";
+    std::string topoFile = traceDir + "topo.csv";
+    DdlFabricConfig fabricConfig = BuildFabric(scenario, fabric, oversubscription, nvlinkGroup);
+    WriteTopoConfig(fabricConfig, topoFile);
+    WriteJobMix(scenario, templateDir, traceDir, iterNum, arriveInterval, jobMix);
+
+    g_txPackets = 0;
+    Ipv4AddressGenerator::Reset();
+    Config::SetDefault("ns3::PointToPointNetDevice::PacketTrain", BooleanValue(packetTrain));
+    if (partitioned)
+    {
+        // the default simulator may exist already, the next call creates the new type
+        Simulator::Destroy();
+        Config::SetGlobal("SimulatorImplementationType",
+                          StringValue("ns3::MultithreadedSimulatorImpl"));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    spineLeafTopo topo(topoFile);
+    if (!linkConfig.empty())
+    {
+        topo.loadLinkConfig(linkConfig);
+    }
+    DdlAppManager manager(&topo, placeStrategy, scenario.tosStrategy, 0, false);
+    manager.setJobTraceDir(traceDir);
+    manager.setSmallFlowFusionBytes(fuseBytes);
+    manager.setIntraHostTransfer(intraHost);
+    manager.setBackfilling(backfilling);
+    if (!timelinePrefix.empty())
+    {
+        manager.setIterTimelineFile(timelinePrefix + scenario.name + ".csv");
+    }
+    if (!tosBranches.empty())
+    {
+        manager.setTosBranches(tosBranches, branchTime);
+    }
+    std::vector<Ptr<DdlApplication>> jobs;
+    for (uint32_t jobId = 0; jobId < scenario.jobNum; jobId++)
+    {
+        jobs.push_back(CreateObject<DdlApplication>(jobId, &manager));
+        manager.addApp(PeekPointer(jobs.back()));
+    }
+    // MacTx, a PhyTxEnd sink would cost the packet trains their saved events
+    Config::ConnectWithoutContext("/NodeList/*/DeviceList/*/$ns3::PointToPointNetDevice/MacTx",
+                                  MakeCallback(&CountTxPacket));
+    if (!telemetryPrefix.empty())
+    {
+        topo.enableTelemetry(telemetryPrefix + scenario.name + ".ddlt", MicroSeconds(100), stopTime);
+    }
+    FlowMonitorHelper flowMonitorHelper;
+    if (flowMonitor)
+    {
+        Ptr<FlowMonitor> monitor = flowMonitorHelper.InstallAll();
+        if (!flowExportPrefix.empty())
+        {
+            // the flows are labelled jobId:flowId by the port they are sent to
+            auto classifier = DynamicCast<Ipv4FlowClassifier>(flowMonitorHelper.GetClassifier());
+            auto label = [&manager, classifier](FlowId flowId) {
+                Ipv4FlowClassifier::FiveTuple tuple = classifier->FindFlow(flowId);
+                uint32_t jobId = 0;
+                uint32_t ddlFlowId = 0;
+                if (!manager.findFlowByPort(tuple.destinationAddress,
+                                            tuple.destinationPort,
+                                            jobId,
+                                            ddlFlowId))
+                {
+                    return std::string();
+                }
+                return std::to_string(jobId) + ":" + std::to_string(ddlFlowId);
+            };
+            monitor->EnableIntervalExport(flowExportPrefix + scenario.name + ".csv",
+                                          flowExportInterval,
+                                          FlowMonitor::FlowLabelCallback(label));
+        }
+    }
+    auto setupEnd = std::chrono::steady_clock::now();
+
+    manager.runApp();
+    Simulator::Stop(stopTime);
+    Simulator::Run();
+    auto runEnd = std::chrono::steady_clock::now();
+    // the branches read the job files of the work dir, wait for them first
+    json branches = json::array();
+    if (manager.hasTosBranches())
+    {
+        for (const auto& [strategy, result] : manager.collectBranchResults())
+        {
+            if (result.empty())
+            {
+                std::cerr << "The " << strategy << " branch failed" << std::endl;
+                exit(1);
+            }
+            branches.push_back(json::parse(result));
+        }
+    }
+
+    double setupSeconds = std::chrono::duration<double>(setupEnd - start).count();
+    double runSeconds = std::chrono::duration<double>(runEnd - setupEnd).count();
+    uint64_t events = Simulator::GetEventCount();
+    double simulatedSeconds = Simulator::Now().GetSeconds();
+    double solverSeconds = manager.getSolverSeconds();
+    double placementSeconds = manager.getPlacementSeconds();
+    double meanJct = manager.getMeanJct();
+    double gpuUtilization = manager.getGpuUtilization();
+    // only the iterations finished before the stop time count, not the whole job mix
+    uint64_t simulatedBytes = manager.getDeliveredBytes();
+    uint32_t monitoredFlows =
+        flowMonitor ? flowMonitorHelper.GetMonitor()->GetFlowStats().size() : 0;
+    // the flow apps of the started jobs stay on their gpu, fused flows have none
+    uint32_t flowSendApps = 0;
+    uint32_t flowRecvApps = 0;
+    // the intra-host flows open no socket
+    uint32_t intraHostFlows = 0;
+    NodeContainer gpuNodes = topo.getGpuNodes();
+    for (auto node = gpuNodes.Begin(); node != gpuNodes.End(); node++)
+    {
+        for (uint32_t i = 0; i < (*node)->GetNApplications(); i++)
+        {
+            Ptr<Application> app = (*node)->GetApplication(i);
+            flowSendApps += DynamicCast<DdlFlowSendApplication>(app) ? 1 : 0;
+            flowRecvApps += DynamicCast<DdlFlowRecvApplication>(app) ? 1 : 0;
+            if (DynamicCast<DdlFlowSendApplication>(app))
+            {
+                DataRateValue intraHostRate;
+                app->GetAttribute("IntraHostRate", intraHostRate);
+                intraHostFlows += intraHostRate.Get().GetBitRate() > 0 ? 1 : 0;
+            }
+        }
+    }
+    Simulator::Destroy();
+    if (manager.getTosBranch().empty())
+    {
+        std::filesystem::remove_all(workDir);
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    json report;
+    report["scenario"] = scenario.name;
+    report["fabric"] = fabric;
+    report["podNum"] = topo.getPodNum();
+    report["coreNum"] = topo.getCoreNum();
+    report["spineNum"] = topo.getSpineNum();
+    report["leafNum"] = topo.getLeafNum();
+    report["gpuNumPerLeaf"] = topo.getGpuNumPerLeaf();
+    report["jobNum"] = scenario.jobNum;
+    report["tosStrategy"] =
+        manager.getTosBranch().empty() ? scenario.tosStrategy : manager.getTosBranch();
+    report["fuseBytes"] = fuseBytes;
+    report["partitioned"] = partitioned;
+    report["packetTrain"] = packetTrain;
+    report["intraHost"] = intraHost;
+    report["nvlinkGroup"] = nvlinkGroup;
+    report["monitoredFlows"] = monitoredFlows;
+    report["setupSeconds"] = setupSeconds;
+    report["wallClockSeconds"] = runSeconds;
+    report["simulatedSeconds"] = simulatedSeconds;
+    report["events"] = events;
+    report["eventsPerSecond"] = runSeconds > 0 ? events / runSeconds : 0;
+    // the scenario runs in a child forked before it allocates anything
+    report["peakRssKiB"] = usage.ru_maxrss;
+    report["flowSendApps"] = flowSendApps;
+    // a sender has a data socket, a receiver a data and an ack socket
+    report["sockets"] = flowSendApps + 2 * flowRecvApps - 3 * intraHostFlows;
+    report["intraHostFlows"] = intraHostFlows;
+    report["solverSeconds"] = solverSeconds;
+    report["placeStrategy"] = placeStrategy;
+    report["placementSeconds"] = placementSeconds;
+    report["scoredCandidates"] = manager.getScoredCandidates();
+    report["backfilling"] = backfilling;
+    report["backfilledJobs"] = manager.getBackfilledJobs();
+    report["meanJctMs"] = meanJct;
+    report["gpuUtilization"] = gpuUtilization;
+    report["solverTimeShare"] = runSeconds > 0 ? solverSeconds / runSeconds : 0;
+    report["packets"] = g_txPackets.load();
+    report["simulatedBytes"] = simulatedBytes;
+    report["packetsPerSimulatedGB"] =
+        simulatedBytes > 0 ? g_txPackets / (simulatedBytes / 1e9) : 0;
+    if (!manager.getTosBranch().empty())
+    {
+        // the branch ends here, its report goes to the parent instead of the caller
+        manager.sendBranchResult(report.dump());
+        _exit(0);
+    }
+    if (!tosBranches.empty())
+    {
+        report["branchTime"] = branchTime.GetSeconds();
+        report["branches"] = branches;
+    }
+    return report;
+}
+
+/**
+ * Run one scenario in a child process, so that it gets its own peak RSS
+ * and leaves no simulator state behind
+ * @param run runs the scenario and returns its report
+ * @param verbose keep the simulator's stdout output
+ * @return the scenario report
+ */
+template <typename F>
+static json
+RunInChild(F run, bool verbose)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        std::cerr << "Failed to create a pipe" << std::endl;
+        exit(1);
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "Failed to fork" << std::endl;
+        exit(1);
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        // the ddl layer prints a lot, keep it out of the measurement
+        if (!verbose)
+        {
+            std::cout.rdbuf(nullptr);
+        }
+        std::string report = run().dump();
+        std::size_t written = 0;
+        while (written < report.size())
+        {
+            ssize_t n = write(fds[1], report.data() + written, report.size() - written);
+            if (n <= 0)
+            {
+                _exit(1);
+            }
+            written += n;
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    std::string report;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    {
+        report.append(buffer, n);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || report.empty())
+    {
+        std::cerr << "The scenario failed with status " << status << std::endl;
+        exit(1);
+    }
+    return json::parse(report);
+}
+
+/**
+ * Compare the reports against a baseline
+ * @param reports the reports of this run
+ * @param baselineFile the JSON written by an earlier run
+ * @param threshold the allowed relative regression
+ * @return the number of regressions
+ */
+static uint32_t
+CheckBaseline(const json& reports, const std::string& baselineFile, double threshold)
+{
+    std::ifstream file(baselineFile);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open baseline " << baselineFile << std::endl;
+        exit(1);
+    }
+    json baseline = json::parse(file);
+
+    // metric -> whether a larger value is a regression
+    const std::vector<std::pair<std::string, bool>> metrics = {
+        {"wallClockSeconds", true},
+        {"eventsPerSecond", false},
+        {"peakRssKiB", true},
+        {"packetsPerSimulatedGB", true},
+    };
+
+    uint32_t regressions = 0;
+    for (const auto& report : reports)
+    {
+        for (const auto& base : baseline)
+        {
+            if (base["scenario"] != report["scenario"])
+            {
+                continue;
+            }
+            for (const auto& [metric, largerIsWorse] : metrics)
+            {
+                double now = report[metric].get<double>();
+                double before = base[metric].get<double>();
+                double limit = largerIsWorse ? before * (1 + threshold) : before * (1 - threshold);
+                if ((largerIsWorse && now > limit) || (!largerIsWorse && now < limit))
+                {
+                    std::cerr << "REGRESSION " << report["scenario"].get<std::string>() << " "
+                              << metric << ": " << before << " -> " << now << std::endl;
+                    regressions++;
+                }
+            }
+        }
+    }
+    return regressions;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string scenarios = "small,medium,large";
+    std::string templateDir = "src/applications/model/ddl-trace/job-template/";
+    std::string output = "ddl-bench.json";
+    std::string baseline;
+    double threshold = 0.1;
+    uint32_t iterNum = 2;
+    uint32_t arriveInterval = 5;
+    Time stopTime = Seconds(100);
+    bool verbose = false;
+    std::string telemetry;
+    std::string timeline;
+    uint32_t fuseBytes = 0;
+    bool partitioned = false;
+    bool packetTrain = false;
+    bool flowMonitor = false;
+    std::string flowExport;
+    Time flowExportInterval = MilliSeconds(10);
+    std::string tosBranches;
+    Time branchTime = Seconds(0);
+    bool intraHost = false;
+    uint32_t nvlinkGroup = 0;
+    std::string placeStrategy = "lb";
+    std::string backfilling = "none";
+    std::string jobMix;
+    std::string fabric = "spine-leaf";
+    double oversubscription = 2;
+    std::string linkConfig;
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Benchmark the DDL job manager end to end");
+    cmd.AddValue("scenarios", "comma separated scenarios: small, medium, large", scenarios);
+    cmd.AddValue("templateDir", "dir of the job templates", templateDir);
+    cmd.AddValue("output", "JSON report file", output);
+    cmd.AddValue("baseline", "JSON report to compare against", baseline);
+    cmd.AddValue("threshold", "allowed relative regression against the baseline", threshold);
+    cmd.AddValue("iterNum", "iterations of every job", iterNum);
+    cmd.AddValue("arriveInterval", "ms between two job arrivals", arriveInterval);
+    cmd.AddValue("stopTime", "simulation stop time", stopTime);
+    cmd.AddValue("verbose", "keep the simulator's stdout output", verbose);
+    cmd.AddValue("telemetry",
+                 "write the fabric telemetry of each scenario to <telemetry><scenario>.ddlt",
+                 telemetry);
+    cmd.AddValue("timeline",
+                 "write the iteration timeline of each scenario to <timeline><scenario>.csv",
+                 timeline);
+    cmd.AddValue("fuseBytes",
+                 "fuse zero-compute flows up to this size into their upstream flow, 0 disables it",
+                 fuseBytes);
+    cmd.AddValue("partitioned",
+                 "run the leafs in partitions of the multithreaded simulator",
+                 partitioned);
+    cmd.AddValue("packetTrain",
+                 "send the queued packets of the point-to-point devices as trains",
+                 packetTrain);
+    cmd.AddValue("flowMonitor", "install a FlowMonitor on all the nodes", flowMonitor);
+    cmd.AddValue("flowExport",
+                 "write the per-interval flow counters of each scenario to "
+                 "<flowExport><scenario>.csv, implies flowMonitor",
+                 flowExport);
+    cmd.AddValue("flowExportInterval", "the interval of the flow export", flowExportInterval);
+    cmd.AddValue("tosBranches",
+                 "comma separated tos strategies (crux, equal) forked at branchTime, they share "
+                 "the simulated prefix and are reported under branches",
+                 tosBranches);
+    cmd.AddValue("branchTime",
+                 "the branches fork at the first tos decision from this time",
+                 branchTime);
+    cmd.AddValue("intraHost",
+                 "complete the same gpu and nvlink transfers after their transfer time, "
+                 "without packets",
+                 intraHost);
+    cmd.AddValue("nvlinkGroup",
+                 "group the consecutive gpus of a leaf by nvlink, 0 without nvlink",
+                 nvlinkGroup);
+    cmd.AddValue("placeStrategy",
+                 "the placement of the jobs: lb, sequence or score, which scores the candidate "
+                 "placements by the slowdown they cause",
+                 placeStrategy);
+    cmd.AddValue("backfilling",
+                 "let later jobs start ahead of the pending ones: none, easy or conservative",
+                 backfilling);
+    cmd.AddValue("jobMix", "comma separated job templates cycled through", jobMix);
+    cmd.AddValue("fabric",
+                 "the fabric of the scenarios: spine-leaf, clos (two pods over cores), fat-tree "
+                 "(the smallest one holding the gpus) or rail (the nvlink groups on rail leafs)",
+                 fabric);
+    cmd.AddValue("oversubscription",
+                 "the oversubscription of the leaf and spine tiers of the clos fabric",
+                 oversubscription);
+    cmd.AddValue("linkConfig",
+                 "a link,from,to,bandwidth,delay file overriding single links of the fabric",
+                 linkConfig);
+    cmd.Parse(argc, argv);
+    flowMonitor = flowMonitor || !flowExport.empty();
+    if (partitioned && !telemetry.empty())
+    {
+        // the telemetry samples every link from one partition
+        std::cerr << "The telemetry does not support partitioned runs" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> jobMixList;
+    std::stringstream jobMixStream(jobMix);
+    std::string jobTemplate;
+    while (std::getline(jobMixStream, jobTemplate, ','))
+    {
+        jobMixList.push_back(jobTemplate);
+    }
+    if (jobMixList.empty())
+    {
+        jobMixList = g_jobMix;
+    }
+    std::vector<std::string> branchList;
+    std::stringstream branchStream(tosBranches);
+    std::string branch;
+    while (std::getline(branchStream, branch, ','))
+    {
+        branchList.push_back(branch);
+    }
+    if (!branchList.empty() && (partitioned || !telemetry.empty() || flowMonitor))
+    {
+        // the branches fork a single threaded process, and only the timeline is split by branch
+        std::cerr << "The tos branches do not support partitioned runs, the telemetry or the "
+                     "flow monitor"
+                  << std::endl;
+        return 1;
+    }
+
+    json reports = json::array();
+    std::stringstream ss(scenarios);
+    std::string name;
+    while (std::getline(ss, name, ','))
+    {
+        auto it = std::find_if(g_scenarios.begin(), g_scenarios.end(), [&](const auto& s) {
+            return s.name == name;
+        });
+        if (it == g_scenarios.end())
+        {
+            std::cerr << "Unknown scenario " << name << std::endl;
+            return 1;
+        }
+        json report = RunInChild(
+            [&]() {
+                return RunScenario(*it,
+                                   templateDir,
+                                   iterNum,
+                                   arriveInterval,
+                                   stopTime,
+                                   telemetry,
+                                   timeline,
+                                   fuseBytes,
+                                   partitioned,
+                                   packetTrain,
+                                   flowMonitor,
+                                   flowExport,
+                                   flowExportInterval,
+                                   branchList,
+                                   branchTime,
+                                   intraHost,
+                                   nvlinkGroup,
+                                   placeStrategy,
+                                   backfilling,
+                                   jobMixList,
+                                   fabric,
+                                   oversubscription,
+                                   linkConfig);
+            },
+            verbose);
+        std::cout << report.dump() << std::endl;
+        reports.push_back(report);
+    }
+
+    std::ofstream file(output);
+    file << reports.dump(2) << std::endl;
+
+    if (!baseline.empty() && CheckBaseline(reports, baseline, threshold) > 0)
+    {
+        return 1;
+    }
+    return 0;
+}